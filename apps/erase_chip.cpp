@@ -1,12 +1,27 @@
 #include "onfi_interface.hpp"
+#include "onfi/controller.hpp"
+#include "onfi/device.hpp"
+#include "onfi/device_config.hpp"
 #include <iostream>
+#include <vector>
 
 int main() {
     onfi_interface onfi;
     onfi.get_started();
     std::cout << "Erasing entire chip (use with caution) ..." << std::endl;
-    for (unsigned int b = 0; b < onfi.num_blocks; ++b) {
-        onfi.erase_block(b, /*verbose*/false);
+
+    onfi::OnfiController ctrl(onfi);
+    onfi::NandDevice dev(ctrl);
+    onfi::apply_device_config(onfi::make_device_config(onfi), dev);
+
+    // Multi-plane erase covers one block per plane at a time when supported
+    std::vector<unsigned int> blocks(onfi.num_blocks);
+    for (unsigned int b = 0; b < onfi.num_blocks; ++b) blocks[b] = b;
+    onfi.enable_erase();
+    const auto failures = dev.erase_blocks(blocks.data(), blocks.size(), true);
+    onfi.disable_erase();
+    for (const auto& group : failures) {
+        for (unsigned int block : group.blocks) std::cout << "Block " << block << " failed to erase." << std::endl;
     }
     std::cout << "Done." << std::endl;
     return 0;
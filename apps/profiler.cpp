@@ -1,8 +1,13 @@
 #include "gpio.hpp"
 #include "timing.hpp"
 #include "onfi_interface.hpp"
+#include "onfi/controller.hpp"
 #include "hardware_locations.hpp"
 
+#if NANDWORKS_HAL_SIM
+#include "sim/register_file.hpp"
+#endif
+
 #include <algorithm>
 #include <chrono>
 #include <cmath>
@@ -182,6 +187,20 @@ void print_chip_info(const onfi_interface& onfi) {
         std::cout << std::setw(2) << static_cast<unsigned int>(value) << ' ';
     }
     std::cout << std::dec << std::setfill(' ') << std::endl;
+
+    const StrobePacing& pacing = onfi.strobe_pacing();
+    const StrobeCalibration& cal = strobe_calibration();
+    std::cout << std::left << std::setw(32) << "Strobe Pacing:" << "mode " << static_cast<int>(pacing.mode);
+    if (pacing.active()) {
+        std::cout << ", WE# +" << pacing.we_low << "/+" << pacing.we_high
+                  << " RE# +" << pacing.re_low << "/+" << pacing.re_high << " cycles (low/high)";
+    } else {
+        std::cout << ", unpaced (loops already slower than spec)";
+    }
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(32) << "Strobe Calibration:" << std::fixed << std::setprecision(2)
+              << cal.ns_per_store << " ns/store, " << cal.ns_per_load << " ns/load, "
+              << cal.ns_per_delay_cycle << " ns/delay cycle" << std::defaultfloat << std::endl;
     std::cout << std::string(60, '-') << std::endl;
 }
 
@@ -325,6 +344,129 @@ BenchmarkResult benchmark_onfi_verify_page(onfi_interface& onfi,
     });
 }
 
+// Same bus traffic issued two ways: one call per phase (control pins restored after
+// each) versus a compiled sequence run with CE# held low. Column change has no array
+// time, so its delta is pure per-op software overhead.
+void benchmark_onfi_sequence_overhead(onfi_interface& onfi,
+                                      std::size_t iterations,
+                                      uint16_t block,
+                                      uint16_t page,
+                                      std::vector<BenchmarkResult>& results,
+                                      std::vector<std::string>& notes) {
+    std::cout << "Benchmarking ONFI per-op overhead (per-phase vs held CE#)..." << std::endl;
+    onfi::OnfiController ctrl(onfi);
+    uint8_t address[8] = {0};
+    onfi.convert_pagenumber_to_columnrow_address(block, page, address, false);
+    const uint8_t address_len = static_cast<uint8_t>(onfi.num_column_cycles + onfi.num_row_cycles);
+    const uint8_t column[2] = {0, 0};
+
+    const auto read_per_phase = run_benchmark("page_read_per_phase", iterations, [&](std::size_t) {
+        onfi.send_command(0x00);
+        onfi.send_addresses(address, address_len);
+        onfi.send_command(0x30);
+        onfi.wait_ready_blocking();
+    });
+    const auto read_sequence = run_benchmark("page_read_sequence", iterations, [&](std::size_t) {
+        ctrl.page_read(address, address_len);
+    });
+    const auto column_per_phase = run_benchmark("change_column_per_phase", iterations, [&](std::size_t) {
+        onfi.send_command(0x05);
+        onfi.send_addresses(column, 2);
+        onfi.send_command(0xE0);
+    });
+    const auto column_sequence = run_benchmark("change_column_sequence", iterations, [&](std::size_t) {
+        ctrl.change_read_column(column);
+    });
+
+    results.push_back(read_per_phase);
+    results.push_back(read_sequence);
+    results.push_back(column_per_phase);
+    results.push_back(column_sequence);
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3)
+        << "Held-CE# sequences save " << (read_per_phase.median - read_sequence.median) / 1000.0
+        << " us per page-read issue and " << (column_per_phase.median - column_sequence.median) / 1000.0
+        << " us per column change (median).";
+    notes.push_back(oss.str());
+}
+
+// Page reads with every R/B# wait policy, spin window forced to zero so each wait
+// parks. Reports read time plus how many waits parked and their wake-up latency, and
+// for status polling the status bytes read and the ready-detection latency.
+void benchmark_rb_wait_policies(onfi_interface& onfi,
+                                std::size_t iterations,
+                                uint16_t block,
+                                uint16_t page,
+                                std::vector<BenchmarkResult>& results,
+                                std::vector<std::string>& notes) {
+    std::cout << "Benchmarking R/B# wait policies on page reads..." << std::endl;
+    const RbWaitPolicy saved = onfi.wait_policy(RbWaitOp::Read);
+    const RbWaitMode modes[] = {RbWaitMode::Spin, RbWaitMode::SpinThenSleep, RbWaitMode::SpinThenEdge,
+                                RbWaitMode::StatusPoll};
+    for (RbWaitMode mode : modes) {
+        RbWaitPolicy policy = saved;
+        policy.mode = mode;
+        policy.spin_ns = 0;
+        onfi.set_wait_policy(RbWaitOp::Read, policy);
+        onfi.reset_wait_stats();
+
+        results.push_back(run_benchmark(std::string("page_read_wait_") + rb_wait_mode_name(mode), iterations,
+                                        [&](std::size_t) { onfi.read_page(block, page); }));
+
+        const RbWaitStats& stats = onfi.wait_stats(RbWaitOp::Read);
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3)
+            << "R/B# wait " << rb_wait_mode_name(mode) << ": " << stats.parked << "/" << stats.waits << " parked";
+        if (mode == RbWaitMode::SpinThenEdge) oss << " (" << stats.edge_wakeups << " edge wake-ups)";
+        if (stats.parked) {
+            oss << ", wake latency mean " << stats.mean_wake_latency_ns() / 1000.0
+                << " us, max " << static_cast<double>(stats.wake_latency_max_ns) / 1000.0 << " us";
+        }
+        if (stats.status_polls) {
+            oss << ", " << stats.status_reads << " status reads, detection latency mean "
+                << stats.mean_poll_latency_ns() / 1000.0 << " us, max "
+                << static_cast<double>(stats.poll_latency_max_ns) / 1000.0 << " us";
+        }
+        notes.push_back(oss.str());
+    }
+    onfi.set_wait_policy(RbWaitOp::Read, saved);
+}
+
+#if NANDWORKS_HAL_SIM
+// On the simulated backend every GPIO register access is counted, so the cost of the
+// data phases can be reported exactly instead of timed.
+void report_register_ops_per_byte(onfi_interface& onfi,
+                                  uint16_t block,
+                                  uint16_t page,
+                                  std::vector<std::string>& notes) {
+    std::cout << "Counting GPIO register operations per byte (simulated backend)..." << std::endl;
+    sim::RegisterCounters& counters = sim::register_file().counters();
+    const std::size_t total_bytes = static_cast<std::size_t>(onfi.num_bytes_in_page) + onfi.num_spare_bytes_in_page;
+    std::vector<uint8_t> buffer(total_bytes);
+
+    onfi.read_page(block, page);
+    counters.reset();
+    onfi.get_data(buffer.data(), static_cast<uint16_t>(buffer.size()));
+    const sim::RegisterCounters read_ops = counters;
+
+    std::vector<uint8_t> payload(onfi.num_bytes_in_page, 0x5A);
+    onfi.erase_block(block);
+    counters.reset();
+    onfi.program_page(block, page, payload.data(), false);
+    const sim::RegisterCounters program_ops = counters;
+    onfi.erase_block(block);
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2)
+        << "Register ops per byte: data-out " << static_cast<double>(read_ops.total()) / static_cast<double>(total_bytes)
+        << " (" << read_ops.level_loads << " GPLEV0 loads, " << (read_ops.set_stores + read_ops.clr_stores + read_ops.fsel_stores) << " stores for " << total_bytes << " bytes)"
+        << ", page program " << static_cast<double>(program_ops.total()) / static_cast<double>(payload.size())
+        << " (" << (program_ops.set_stores + program_ops.clr_stores + program_ops.fsel_stores) << " stores for " << payload.size() << " bytes, including command and address cycles).";
+    notes.push_back(oss.str());
+}
+#endif
+
 // ---------------------------------------------------------------------------
 // ONFI benchmarks (destructive)
 // ---------------------------------------------------------------------------
@@ -376,6 +518,10 @@ int main(int argc, char** argv) {
 
         std::cout << "--- Function Profiler ---" << std::endl;
         std::cout << "Iterations per benchmark: " << config.iterations << std::endl;
+        const TimebaseInfo& tb = timebase_info();
+        std::cout << "Timebase: " << tb.source << " @ " << std::fixed << std::setprecision(3)
+                  << static_cast<double>(tb.frequency_hz) / 1e6 << " MHz, resolution " << tb.resolution_ns
+                  << " ns, read cost " << tb.read_cost_ns << " ns" << std::defaultfloat << std::endl;
         if (!config.include_destructive) {
             notes.emplace_back("Destructive program/erase benchmarks skipped (enable with --include-destructive).");
         }
@@ -437,6 +583,11 @@ int main(int argc, char** argv) {
             results.push_back(benchmark_onfi_read_page(onfi, config.iterations, rng, block_dist, page_dist));
             results.push_back(benchmark_onfi_change_read_column(onfi, config.iterations, safe_block, safe_page));
             results.push_back(benchmark_onfi_verify_page(onfi, config.iterations, safe_block, safe_page));
+            benchmark_onfi_sequence_overhead(onfi, config.iterations, safe_block, safe_page, results, notes);
+            benchmark_rb_wait_policies(onfi, config.iterations, safe_block, safe_page, results, notes);
+#if NANDWORKS_HAL_SIM
+            report_register_ops_per_byte(onfi, safe_block, safe_page, notes);
+#endif
 
             if (config.include_destructive) {
                 std::vector<uint8_t> payload(static_cast<std::size_t>(onfi.num_bytes_in_page), 0xAA);
@@ -0,0 +1,92 @@
+#ifndef DQ_BUS_H
+#define DQ_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "hardware_locations.hpp"
+#include "dq_pin_map.hpp"
+#include "strobe_pacing.hpp"
+
+// Helpers that translate bytes on the 8-bit DQ bus into GPIO bank 0 register images.
+// Everything here is pure computation so it can be exercised off-target.
+
+// The board wiring from hardware_locations.hpp. Rewiring DQ0..DQ7 onto consecutive
+// GPIOs switches every helper below to the shift-and-mask codec.
+using BoardDqMap = DqPinMap<GPIO_DQ0, GPIO_DQ1, GPIO_DQ2, GPIO_DQ3,
+                            GPIO_DQ4, GPIO_DQ5, GPIO_DQ6, GPIO_DQ7>;
+using BoardDqCodec = DqCodec<BoardDqMap>;
+
+// Mask covering every DQ line in GPIO bank 0.
+constexpr uint32_t dq_all_mask() {
+    return BoardDqMap::all_mask;
+}
+
+// GPSET0 image that drives `value` onto DQ0..DQ7 (only the lines that must read 1).
+constexpr uint32_t dq_set_mask(uint8_t value) {
+    return BoardDqCodec::set_mask(value);
+}
+
+// GPFSEL images that switch all DQ lines to input or output in one store per register.
+const GpioFselImage& dq_fsel_image(bool is_output);
+
+// Reassemble the DQ byte from one raw GPLEV0 word (used by interface::read_dq_pins()).
+// A single shift on contiguous wiring, one shift/mask per line otherwise.
+constexpr uint8_t dq_decode_level_word(uint32_t levels) {
+    return BoardDqCodec::decode_word(levels);
+}
+
+// Decode a captured run of GPLEV0 words into bytes. Scattered wiring uses one
+// 256-entry table per byte lane of the level word (four loads and three ORs per byte);
+// contiguous wiring is one shift per byte.
+void dq_decode_levels(const uint32_t* levels, size_t count, uint8_t* out);
+
+// Scalar reference with the same result: one shift/mask per line regardless of wiring.
+void dq_decode_levels_scalar(const uint32_t* levels, size_t count, uint8_t* out);
+
+// Register images for one asynchronous data-in cycle.
+// `clr` lowers WE# together with the DQ lines that must read 0, `set` raises the DQ
+// lines that must read 1. WE# is raised by a separate constant store afterwards so the
+// full byte is stable for tDS before the latching edge.
+struct DqBurstWord {
+    uint32_t clr;
+    uint32_t set;
+};
+
+// Expand a buffer into its precomputed register stream. `out` is resized to `count`.
+void dq_build_data_in_burst(const uint8_t* data, size_t count, std::vector<DqBurstWord>& out);
+
+// Store a precomputed stream through `sink`, which must provide set(uint32_t) and
+// clr(uint32_t) for GPSET0/GPCLR0. Three stores per byte, no lookups in the loop.
+// With Paced the WE# low and high phases are padded per `pacing` (strobe_pacing.hpp).
+template <bool Paced = false, typename Sink>
+inline void dq_emit_data_in_burst(const DqBurstWord* words, size_t count, Sink& sink,
+                                  const StrobePacing& pacing = StrobePacing{}) {
+    const uint32_t we_mask = static_cast<uint32_t>(1u) << GPIO_WE;
+    for (size_t i = 0; i < count; ++i) {
+        sink.clr(words[i].clr);
+        sink.set(words[i].set);
+        strobe_delay<Paced>(pacing.we_low);
+        sink.set(we_mask);
+        strobe_delay<Paced>(pacing.we_high);
+    }
+}
+
+// Register sink that records stores instead of touching hardware.
+struct GpioWriteTrace {
+    enum class Reg : uint8_t { Set, Clr };
+    struct Entry {
+        Reg reg;
+        uint32_t value;
+    };
+    std::vector<Entry> entries;
+
+    void set(uint32_t value) { entries.push_back({Reg::Set, value}); }
+    void clr(uint32_t value) { entries.push_back({Reg::Clr, value}); }
+};
+
+// Record the stores issued by the original per-byte loop (WE# low, masked DQ write as
+// set+clear, WE# high) so the burst stream can be compared against it.
+void dq_trace_data_in_reference(const uint8_t* data, size_t count, GpioWriteTrace& trace);
+
+#endif // DQ_BUS_H
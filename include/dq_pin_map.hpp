@@ -0,0 +1,115 @@
+#ifndef DQ_PIN_MAP_H
+#define DQ_PIN_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+// Compile-time description of how DQ0..DQ7 are wired to GPIO bank 0.
+// All register images and decode tables are derived from the template arguments at
+// compile time. DqCodec picks a shift-and-mask specialization when the eight lines sit
+// on consecutive GPIOs in order (DQn on base + n), and table lookups otherwise.
+
+template <uint8_t P0, uint8_t P1, uint8_t P2, uint8_t P3,
+          uint8_t P4, uint8_t P5, uint8_t P6, uint8_t P7>
+struct DqPinMap {
+    static constexpr std::array<uint8_t, 8> pins{{P0, P1, P2, P3, P4, P5, P6, P7}};
+
+    static constexpr bool contiguous =
+        P1 == P0 + 1 && P2 == P0 + 2 && P3 == P0 + 3 &&
+        P4 == P0 + 4 && P5 == P0 + 5 && P6 == P0 + 6 && P7 == P0 + 7;
+
+    static constexpr uint8_t base = P0;
+
+    static constexpr uint32_t all_mask =
+        (1u << P0) | (1u << P1) | (1u << P2) | (1u << P3) |
+        (1u << P4) | (1u << P5) | (1u << P6) | (1u << P7);
+
+    static_assert(P0 < 32 && P1 < 32 && P2 < 32 && P3 < 32 &&
+                  P4 < 32 && P5 < 32 && P6 < 32 && P7 < 32,
+                  "DQ lines must live in GPIO bank 0");
+    static_assert(__builtin_popcount(all_mask) == 8, "DQ lines must be distinct GPIOs");
+
+    // GPSET0 image that drives `value` onto the bus.
+    static constexpr uint32_t spread(uint8_t value) {
+        uint32_t mask = 0;
+        for (size_t b = 0; b < 8; ++b) {
+            if (value & (1u << b)) mask |= 1u << pins[b];
+        }
+        return mask;
+    }
+
+    // Gather the DQ byte from a GPLEV0 word, one shift/mask per line.
+    static constexpr uint8_t gather(uint32_t levels) {
+        uint8_t value = 0;
+        for (size_t b = 0; b < 8; ++b) {
+            value |= static_cast<uint8_t>(((levels >> pins[b]) & 0x1) << b);
+        }
+        return value;
+    }
+};
+
+template <typename Map, bool Contiguous = Map::contiguous>
+struct DqCodec;
+
+// Scattered wiring: 256-entry set table and one decode table per GPLEV0 byte lane,
+// both generated at compile time.
+template <typename Map>
+struct DqCodec<Map, false> {
+    static constexpr bool shift_path = false;
+
+    static constexpr std::array<uint32_t, 256> make_set_lut() {
+        std::array<uint32_t, 256> lut{};
+        for (size_t v = 0; v < 256; ++v) lut[v] = Map::spread(static_cast<uint8_t>(v));
+        return lut;
+    }
+
+    static constexpr std::array<std::array<uint8_t, 256>, 4> make_decode_lut() {
+        std::array<std::array<uint8_t, 256>, 4> lut{};
+        for (size_t lane = 0; lane < 4; ++lane) {
+            for (size_t v = 0; v < 256; ++v) {
+                lut[lane][v] = Map::gather(static_cast<uint32_t>(v) << (lane * 8));
+            }
+        }
+        return lut;
+    }
+
+    alignas(64) static constexpr std::array<uint32_t, 256> set_lut = make_set_lut();
+    alignas(64) static constexpr std::array<std::array<uint8_t, 256>, 4> decode_lut = make_decode_lut();
+
+    static constexpr uint32_t set_mask(uint8_t value) { return set_lut[value]; }
+
+    static constexpr uint8_t decode_word(uint32_t levels) { return Map::gather(levels); }
+
+    static void decode_levels(const uint32_t* levels, size_t count, uint8_t* out) {
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t w = levels[i];
+            out[i] = static_cast<uint8_t>(decode_lut[0][w & 0xFF] |
+                                          decode_lut[1][(w >> 8) & 0xFF] |
+                                          decode_lut[2][(w >> 16) & 0xFF] |
+                                          decode_lut[3][w >> 24]);
+        }
+    }
+};
+
+// DQ0..DQ7 on consecutive GPIOs: the byte is the level word shifted by the base pin.
+template <typename Map>
+struct DqCodec<Map, true> {
+    static constexpr bool shift_path = true;
+
+    static constexpr uint32_t set_mask(uint8_t value) {
+        return static_cast<uint32_t>(value) << Map::base;
+    }
+
+    static constexpr uint8_t decode_word(uint32_t levels) {
+        return static_cast<uint8_t>(levels >> Map::base);
+    }
+
+    static void decode_levels(const uint32_t* levels, size_t count, uint8_t* out) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<uint8_t>(levels[i] >> Map::base);
+        }
+    }
+};
+
+#endif // DQ_PIN_MAP_H
@@ -7,8 +7,35 @@
 bool gpio_init();
 
 // Set the direction of a GPIO pin
+// Pins 0..31 go through the GPFSEL shadow: a no-op when already in that mode,
+// otherwise a single store of the updated register (no read-back).
 void gpio_set_direction(uint8_t pin, bool is_output);
 
+// GPFSEL registers covering GPIO bank 0 (GPFSEL3 holds GPIO 30..39).
+constexpr uint8_t kGpioFselRegs = 4;
+
+// Function-select image for GPFSEL0..GPFSEL3 (GPIO 0..31).
+// `mask` selects the 3-bit fields owned by the image, `bits` holds their wanted values.
+struct GpioFselImage {
+    uint32_t mask[kGpioFselRegs];
+    uint32_t bits[kGpioFselRegs];
+};
+
+// Build an image that puts every pin in `pins` into input or output mode.
+// Throws std::invalid_argument for pins outside GPIO 0..31.
+GpioFselImage gpio_make_fsel_image(const uint8_t* pins, uint8_t count, bool is_output);
+
+// Apply an image against the shadow: registers already matching are skipped, the rest
+// get one store each. Returns true if any register was written.
+bool gpio_apply_fsel_image(const GpioFselImage& image);
+
+// Re-read GPFSEL0..GPFSEL3 into the shadow (done by gpio_init; call again if another
+// agent changed pin modes behind our back).
+void gpio_refresh_fsel_shadow();
+
+// Single-access pin helpers below go through gpio_regs.hpp (no per-call barriers);
+// pins beyond bank 0 fall back to libbcm2835.
+
 // Write a value to a GPIO pin
 void gpio_write(uint8_t pin, bool value);
 
@@ -0,0 +1,95 @@
+#ifndef GPIO_REGS_H
+#define GPIO_REGS_H
+
+#include <stdint.h>
+#include <bcm2835.h>
+
+#ifndef NANDWORKS_HAL_SIM
+#define NANDWORKS_HAL_SIM 0
+#endif
+
+#if NANDWORKS_HAL_SIM
+#include "sim/register_file.hpp"
+#endif
+
+// Header-only access to GPIO bank 0 through the mapped bcm2835_gpio base.
+// Loads and stores are plain volatile accesses without the per-call barriers of the
+// libbcm2835 helpers. Accesses to the same peripheral stay in program order, so a
+// burst only needs gpio_reg_barrier() once before its first and after its last access
+// (to order it against other peripherals or memory). Valid between gpio_init() and
+// gpio_shutdown().
+//
+// With HAL_BACKEND=sim the accessors go through sim::register_file() so every load
+// and store reaches the pin-level NAND model and is counted.
+
+inline void gpio_reg_barrier() {
+    __sync_synchronize();
+}
+
+inline volatile uint32_t* gpio_reg(uint32_t offset) {
+    return bcm2835_gpio + (offset / 4);
+}
+
+#if NANDWORKS_HAL_SIM
+
+inline void gpio_reg_set0(uint32_t mask) {
+    sim::register_file().store(BCM2835_GPSET0, mask);
+}
+
+inline void gpio_reg_clr0(uint32_t mask) {
+    sim::register_file().store(BCM2835_GPCLR0, mask);
+}
+
+inline uint32_t gpio_reg_levels0() {
+    return sim::register_file().load(BCM2835_GPLEV0);
+}
+
+#else
+
+inline void gpio_reg_set0(uint32_t mask) {
+    *gpio_reg(BCM2835_GPSET0) = mask;
+}
+
+inline void gpio_reg_clr0(uint32_t mask) {
+    *gpio_reg(BCM2835_GPCLR0) = mask;
+}
+
+inline uint32_t gpio_reg_levels0() {
+    return *gpio_reg(BCM2835_GPLEV0);
+}
+
+#endif // NANDWORKS_HAL_SIM
+
+// Drive the lines in `mask` to the matching bits of `value` (set first, then clear,
+// same order as bcm2835_gpio_write_mask).
+inline void gpio_reg_write_mask0(uint32_t value, uint32_t mask) {
+    gpio_reg_set0(value & mask);
+    gpio_reg_clr0(~value & mask);
+}
+
+inline void gpio_reg_write0(uint8_t pin, bool value) {
+    const uint32_t mask = static_cast<uint32_t>(1u) << pin;
+    if (value) {
+        gpio_reg_set0(mask);
+    } else {
+        gpio_reg_clr0(mask);
+    }
+}
+
+// GPSET0/GPCLR0 sink for dq_emit_data_in_burst(); caches the register addresses so the
+// loop is two address-stable stores per call.
+#if NANDWORKS_HAL_SIM
+struct GpioReg0Sink {
+    void set(uint32_t value) const { gpio_reg_set0(value); }
+    void clr(uint32_t value) const { gpio_reg_clr0(value); }
+};
+#else
+struct GpioReg0Sink {
+    volatile uint32_t* gpset0 = gpio_reg(BCM2835_GPSET0);
+    volatile uint32_t* gpclr0 = gpio_reg(BCM2835_GPCLR0);
+    void set(uint32_t value) const { *gpset0 = value; }
+    void clr(uint32_t value) const { *gpclr0 = value; }
+};
+#endif
+
+#endif // GPIO_REGS_H
@@ -28,6 +28,8 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 // Data Quentin (DQ) Pins: Bidirectional data bus for transferring commands, addresses, and data.
+// All eight must be in GPIO 0..31. Wiring DQ0..DQ7 to consecutive GPIOs (DQn = DQ0 + n)
+// selects the shift-and-mask bus codec at compile time (see dq_pin_map.hpp).
 #define GPIO_DQ0 21  // Data Bus Line 0
 #define GPIO_DQ1 20  // Data Bus Line 1
 #define GPIO_DQ2 16  // Data Bus Line 2
@@ -46,6 +48,11 @@
 #define GPIO_CE  22  // Chip Enable: Activates the NAND flash chip. Active low.
 #define GPIO_RB  17  // Ready/Busy: Indicates the status of the NAND flash. Low means busy.
 
+// Further chip-enable targets share the DQ/WE/RE/ALE/CLE/WP lines above and are listed
+// at run time in ONFI_TARGETS as ce[:rb] pairs, e.g. "22:17,7:8,9" (see
+// microprocessor_interface.hpp). A target without its own R/B# pin shares GPIO_RB as a
+// wired-OR. Without ONFI_TARGETS the bus has the single target GPIO_CE/GPIO_RB.
+
 // Data Strobe Pins: Used for synchronizing data transfer in synchronous mode.
 #define GPIO_DQS  5  // Data Strobe: Toggles to signal valid data.
 #define GPIO_DQSC 6  // Data Strobe Complement: The inverse of DQS.
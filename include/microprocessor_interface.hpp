@@ -4,9 +4,15 @@
 #include <stdint.h>
 #include <fstream>
 #include <iostream>
+#include <cstdlib>
 #include <stdexcept>
+#include <vector>
 #include "gpio.hpp"
+#include "gpio_regs.hpp"
+#include "dq_bus.hpp"
 #include "hardware_locations.hpp"
+#include "rb_wait.hpp"
+#include "strobe_pacing.hpp"
 
 /// following flag keeps the debug information active
 #define DEBUG_INTERFACE false
@@ -32,6 +38,32 @@ enum chip_type {
     toshiba_tlc_toggle = 3
 };
 
+/**
+one chip-enable target on the shared bus
+.. rb_pin is the target's own R/B# line, or GPIO_RB when it shares the wired-OR line
+*/
+struct ChipTarget {
+    uint8_t ce_pin;
+    uint8_t rb_pin;
+};
+
+/**
+parse a target list of ce[:rb] pairs separated by commas, e.g. "22:17,7:8,9"
+.. a pair without rb uses GPIO_RB
+.. throws std::invalid_argument on malformed lists, pins outside GPIO 0..31, or a
+.. list validate_chip_targets rejects
+*/
+std::vector<ChipTarget> parse_chip_targets(const char* spec);
+
+/**
+check a target list against the wiring
+.. CE# and R/B# pins must not be bus pins (DQ, DQS, WE#, RE#, CLE, ALE, WP#), no two
+.. targets may share a CE#, and no CE# may be another target's R/B#; targets may
+.. share an R/B# line
+.. throws std::invalid_argument naming the offending pin
+*/
+void validate_chip_targets(const std::vector<ChipTarget>& targets);
+
 /**
 this interface class defines the pins, location etc required
 .. this may change based on system in use
@@ -42,6 +74,23 @@ private:
     /**
     define masks and addresses here
     */
+
+    // register stream reused by send_data so a page burst does not allocate per call
+    mutable std::vector<DqBurstWord> burst_words_;
+
+    // R/B# wait policies and statistics (see rb_wait.hpp)
+    mutable RbWaiter rb_waiter_;
+
+    // WE#/RE# padding for the active ONFI timing mode (see strobe_pacing.hpp)
+    StrobePacing pacing_;
+
+    // CE# targets on the bus (ONFI_TARGETS, default GPIO_CE/GPIO_RB) and the selected one
+    std::vector<ChipTarget> targets_;
+    size_t target_ = 0;
+    uint32_t ce_mask_ = 0;
+    uint32_t rb_mask_ = 0;
+    // every CE# plus RE# and WE#, driven high whenever the bus is idle
+    uint32_t idle_high_mask_ = 0;
 protected:
     std::fstream time_info_file;
 
@@ -53,6 +102,10 @@ public:
         if (!gpio_init()) {
             throw std::runtime_error("GPIO initialisation failed");
         }
+        const char* targets = std::getenv("ONFI_TARGETS");
+        set_targets(targets ? parse_chip_targets(targets) : std::vector<ChipTarget>{{GPIO_CE, GPIO_RB}});
+        // Devices power up in timing mode 0
+        set_strobe_timing_mode(0);
     }
 
     virtual ~interface() {
@@ -81,6 +134,27 @@ public:
     */
     void set_ce_low() const;
 
+    /**
+    \replace the CE# target list and select target 0
+    \.. throws std::invalid_argument when the list is empty or a pin is used twice as CE#
+    \.. pin directions are applied by the next set_pin_direction_inactive()
+    */
+    void set_targets(const std::vector<ChipTarget>& targets);
+    const std::vector<ChipTarget>& targets() const { return targets_; }
+    size_t target_count() const { return targets_.size(); }
+
+    /**
+    \route CE# and R/B# to target `index` (std::out_of_range otherwise)
+    \.. every later command, address, data and wait goes to that target only
+    */
+    void select_target(size_t index);
+    size_t selected_target() const { return target_; }
+    uint8_t ce_pin() const { return targets_[target_].ce_pin; }
+    uint8_t rb_pin() const { return targets_[target_].rb_pin; }
+
+    // True when target `index` has an R/B# line no other target drives
+    bool has_private_rb(size_t index) const;
+
     /**
     this function sets the default values of pins.
     we do not touch the DQ pin values here
@@ -93,6 +167,7 @@ public:
     function that sets the data lines as input
     .. to be used when data is to be received from NAND
     ... please do not forget to reset them to output once done
+    .. the GPFSEL shadow makes this a no-op when the bus is already input
     */
     void set_datalines_direction_input() const;
 
@@ -100,6 +175,7 @@ public:
     function that sets the data lines as output/default
     .. to be used when sending data or sending command
     ... this function must be called once the datalines are set as input
+    .. direction changes write one precomputed GPFSEL image per register
     */
     void set_datalines_direction_default() const;
 
@@ -187,23 +263,32 @@ public:
     \reset all the data on DQ pins
     \.. this might be unnecesary
     \make sure to call set_default_pin_values()
+    \asynchronous data-in is expanded into a GPSET0/GPCLR0 stream first (see dq_bus.hpp)
     */
     void send_data(const uint8_t *data_to_send, uint16_t num_data) const;
 
+    /**
+    \single-phase helpers used by the ONFI sequence interpreter
+    \.. CE# must already be low; CE# and the bus are left as they are afterwards
+    \.. latch_command: CLE high, one WE# strobe, CLE low
+    \.. latch_addresses: ALE high, one WE# strobe per byte, ALE low
+    \.. latch_data: asynchronous data-in burst (see dq_bus.hpp)
+    */
+    void latch_command(uint8_t command_to_send) const;
+    void latch_addresses(const uint8_t *address_to_send, uint8_t num_address_bytes) const;
+    void latch_data(const uint8_t *data_to_send, uint32_t num_data) const;
+
     void set_dq_pins(uint8_t data) const;
 
+    /**
+    \pace the WE#/RE# strobes for ONFI asynchronous timing mode `mode` (0..5)
+    \.. this only changes the host side; select the mode on the device with SET FEATURES 0x01 first
+    */
+    void set_strobe_timing_mode(uint8_t mode);
+    const StrobePacing& strobe_pacing() const { return pacing_; }
+
     uint8_t read_dq_pins() const {
-        const uint32_t levels = gpio_read_levels0();
-        uint8_t data = 0;
-        data |= ((levels >> GPIO_DQ0) & 0x1) << 0;
-        data |= ((levels >> GPIO_DQ1) & 0x1) << 1;
-        data |= ((levels >> GPIO_DQ2) & 0x1) << 2;
-        data |= ((levels >> GPIO_DQ3) & 0x1) << 3;
-        data |= ((levels >> GPIO_DQ4) & 0x1) << 4;
-        data |= ((levels >> GPIO_DQ5) & 0x1) << 5;
-        data |= ((levels >> GPIO_DQ6) & 0x1) << 6;
-        data |= ((levels >> GPIO_DQ7) & 0x1) << 7;
-        return data;
+        return dq_decode_level_word(gpio_reg_levels0());
     }
 
     // Wait for Ready/Busy (R/B#) to indicate ready (high). Returns true if
@@ -212,6 +297,20 @@ public:
 
     // Spin until R/B# is high (ready). No timeout, polls as fast as possible.
     void wait_ready_blocking() const;
+
+    // Wait until R/B# is high using the policy registered for `op`
+    // (spin, or spin for a window and then park on an edge event / sleep slices).
+    void wait_ready_blocking(RbWaitOp op) const;
+
+    void set_wait_policy(RbWaitOp op, const RbWaitPolicy& policy) { rb_waiter_.set_policy(op, policy); }
+    // Spin window of every policy, normally the device's tR (done by read_parameters)
+    void set_wait_spin_window(uint64_t spin_ns);
+    const RbWaitPolicy& wait_policy(RbWaitOp op) const { return rb_waiter_.policy(op); }
+    const RbWaitStats& wait_stats(RbWaitOp op) const { return rb_waiter_.stats(op); }
+    void record_status_poll(RbWaitOp op, uint64_t elapsed_ns, uint64_t reads, uint64_t latency_ns) const {
+        rb_waiter_.record_status_poll(op, elapsed_ns, reads, latency_ns);
+    }
+    void reset_wait_stats() { rb_waiter_.reset_stats(); }
 };
 
 #endif
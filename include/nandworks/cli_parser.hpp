@@ -18,6 +18,12 @@ struct ParsedCommand {
 
 ParsedCommand parse_command_arguments(const Command& command, const std::vector<std::string>& raw_args);
 
+// Split one command line into words, shell style: whitespace separates words, '...'
+// is literal, "..." honours \" and \\, a backslash escapes the next character, and an
+// unquoted # starting a word comments out the rest of the line. Throws
+// std::invalid_argument on an unterminated quote or trailing backslash.
+std::vector<std::string> split_command_line(const std::string& line);
+
 void print_command_usage(const Command& command, std::ostream& out);
 
 } // namespace nandworks
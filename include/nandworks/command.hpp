@@ -15,6 +15,15 @@ enum class CommandSafety {
     RequiresForce
 };
 
+// How much of the ONFI bring-up a command needs before it can touch the bus. Each level
+// includes the ones before it; DriverContext runs only the steps still missing.
+enum class SessionLevel {
+    None,
+    Bus,        // GPIO mapped and pins idle; data cycles use the asynchronous interface
+    Reset,      // plus the power-on reset, with R/B# ready
+    Identified  // plus READ ID, the parameter page and the timing mode (get_started)
+};
+
 struct OptionSpec {
     std::string long_name;
     char short_name = '\0';
@@ -38,6 +47,7 @@ struct Command {
     std::size_t max_positionals = static_cast<std::size_t>(-1);
     CommandSafety safety = CommandSafety::Safe;
     bool requires_session = true;
+    SessionLevel session_level = SessionLevel::Identified;
     bool requires_root = true;
     bool stop_parsing_options_after_positionals = false;
     CommandHandler handler;
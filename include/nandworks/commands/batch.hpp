@@ -0,0 +1,12 @@
+#ifndef NANDWORKS_COMMANDS_BATCH_HPP
+#define NANDWORKS_COMMANDS_BATCH_HPP
+
+#include "nandworks/command_registry.hpp"
+
+namespace nandworks::commands {
+
+void register_batch_commands(CommandRegistry& registry);
+
+} // namespace nandworks::commands
+
+#endif // NANDWORKS_COMMANDS_BATCH_HPP
@@ -0,0 +1,83 @@
+#ifndef NANDWORKS_DAEMON_HPP
+#define NANDWORKS_DAEMON_HPP
+
+#include "nandworks/command_registry.hpp"
+#include "nandworks/driver_context.hpp"
+
+#include <csignal>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace nandworks {
+
+// `nandworks serve` keeps one DriverContext (GPIO session, identified device) alive and
+// runs CommandRegistry invocations sent over a local Unix-domain socket, one at a time.
+// Root-only commands, and `script`/`batch` (which run arbitrary code and file I/O), are
+// refused unless the connecting process (SO_PEERCRED) is root; only a root client's cwd
+// is honoured. A client that stalls mid-request or stops reading is dropped after a
+// timeout.
+//
+// Wire format, all integers little-endian:
+//   request:  u32 length, then NUL-terminated strings: cwd, verbose ("0"/"1"), command, args...
+//   response: frames of u8 kind + u32 length + payload; kind 'o' is stdout, 'e' stderr
+//             (both binary-safe) and a final 'x' frame carries the i32 exit status.
+
+struct DaemonRequest {
+    std::string cwd;
+    bool verbose = false;
+    std::string command;
+    std::vector<std::string> args;
+};
+
+// $NANDWORKS_SOCKET, or /run/nandworks.sock.
+std::string daemon_socket_path();
+
+// Connected client socket to a daemon listening on `path`, or -1 when none is.
+int connect_daemon(const std::string& path);
+
+// Send `request` over `fd` (closed on return) and copy the streamed output to out/err.
+// Returns the command's exit status, or 4 if the daemon hung up without one.
+int forward_command(int fd, const DaemonRequest& request, std::ostream& out, std::ostream& err);
+
+class DaemonServer {
+public:
+    // Turns off daemon forwarding on `driver`: everything the daemon runs stays local.
+    DaemonServer(CommandRegistry& registry, DriverContext& driver, std::string socket_path);
+    ~DaemonServer();
+
+    DaemonServer(const DaemonServer&) = delete;
+    DaemonServer& operator=(const DaemonServer&) = delete;
+
+    // Bind and listen; a stale socket file (no daemon behind it) is replaced. Throws
+    // std::runtime_error if another daemon is listening or the socket cannot be bound.
+    void listen(unsigned int mode = 0660);
+
+    // Accept one client and run its command to completion. Returns false if accept()
+    // was interrupted by a signal.
+    bool serve_next();
+
+    // Receive/send timeout on client sockets (default 5 s, 0 disables): a client that
+    // sends nothing or stalls mid-frame no longer blocks the ones queued behind it.
+    void set_client_timeout_ms(unsigned int timeout_ms) noexcept { client_timeout_ms_ = timeout_ms; }
+
+    // serve_next() until `*stop` becomes nonzero.
+    void run(const volatile std::sig_atomic_t* stop);
+
+    const std::string& socket_path() const noexcept { return path_; }
+    unsigned long served() const noexcept { return served_; }
+
+private:
+    int dispatch(const DaemonRequest& request, bool caller_root, std::ostream& out, std::ostream& err);
+
+    CommandRegistry& registry_;
+    DriverContext& driver_;
+    std::string path_;
+    int listen_fd_ = -1;
+    unsigned long served_ = 0;
+    unsigned int client_timeout_ms_ = 5000;
+};
+
+} // namespace nandworks
+
+#endif // NANDWORKS_DAEMON_HPP
@@ -0,0 +1,26 @@
+#ifndef NANDWORKS_DISPATCH_HPP
+#define NANDWORKS_DISPATCH_HPP
+
+#include "nandworks/command_registry.hpp"
+#include "nandworks/driver_context.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace nandworks {
+
+// Look up, parse and run one command against a long-lived registry and session, with
+// the exit codes of the single-shot CLI: 2 unknown command, 3 argument error, 4 the
+// handler threw, 5 root privileges missing. Used by `serve` and `batch`.
+int dispatch_command(CommandRegistry& registry,
+                     DriverContext& driver,
+                     const std::string& name,
+                     const std::vector<std::string>& args,
+                     bool verbose,
+                     std::ostream& out,
+                     std::ostream& err);
+
+} // namespace nandworks
+
+#endif // NANDWORKS_DISPATCH_HPP
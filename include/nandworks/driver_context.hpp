@@ -1,6 +1,7 @@
 #ifndef NANDWORKS_DRIVER_CONTEXT_HPP
 #define NANDWORKS_DRIVER_CONTEXT_HPP
 
+#include "nandworks/command.hpp"
 #include "onfi_interface.hpp"
 
 #include <memory>
@@ -21,18 +22,38 @@ public:
     bool verbose() const noexcept { return verbose_; }
     void set_verbose(bool verbose) noexcept { verbose_ = verbose; }
 
+    // Whether the user on whose behalf commands run is root, checked against
+    // Command::requires_root. Defaults to this process's euid; the daemon sets it per
+    // client from the peer credentials.
+    bool caller_is_root() const noexcept { return caller_root_; }
+    void set_caller_root(bool root) noexcept { caller_root_ = root; }
+
+    // Whether session commands may be handed to a running daemon (batch decides per
+    // line). Off with NANDWORKS_NO_DAEMON or --no-daemon, and inside the daemon itself,
+    // whose socket would otherwise lead back to its own busy accept loop.
+    bool forwards_to_daemon() const noexcept { return forward_to_daemon_; }
+    void set_forward_to_daemon(bool forward) noexcept { forward_to_daemon_ = forward; }
+
     onfi_interface& require_onfi();
     onfi_interface& require_onfi_started(param_type type = param_type::ONFI);
 
+    // Bring the session up to at least `level`, running only the steps not yet done.
+    // `type` selects the parameter page once the level reaches Identified.
+    onfi_interface& require_session(SessionLevel level, param_type type = param_type::ONFI);
+
     bool has_onfi() const noexcept { return static_cast<bool>(onfi_); }
-    bool onfi_started() const noexcept { return started_; }
+    // True once any bring-up step has run (the bus is held)
+    bool onfi_started() const noexcept { return level_ != SessionLevel::None; }
+    SessionLevel session_level() const noexcept { return level_; }
 
     void shutdown() noexcept;
 
 private:
     bool verbose_;
+    bool caller_root_;
+    bool forward_to_daemon_;
     std::unique_ptr<onfi_interface> onfi_;
-    bool started_ = false;
+    SessionLevel level_ = SessionLevel::None;
     param_type start_type_ = param_type::ONFI;
 };
 
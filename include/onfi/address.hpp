@@ -15,6 +15,10 @@ void to_col_row_address(uint32_t pages_per_block,
                         unsigned int page_number,
                         uint8_t* out);
 
+// Block index that reaches `block` of `lun` through the row address: the LUN bits sit
+// directly above the block bits, which span ceil(log2(blocks_per_lun)) bits.
+unsigned int lun_block_index(uint32_t blocks_per_lun, unsigned int lun, unsigned int block);
+
 } // namespace onfi
 
 #endif // ONFI_ADDRESS_H
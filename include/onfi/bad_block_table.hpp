@@ -0,0 +1,59 @@
+#ifndef ONFI_BAD_BLOCK_TABLE_HPP
+#define ONFI_BAD_BLOCK_TABLE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace onfi {
+
+class NandDevice;
+
+// One bit per block of a chip, LUN-major (lun * blocks_per_lun + block), set for blocks
+// carrying a bad-block marker. Persisted next to the parameter page cache so a session
+// only scans a chip the first time it sees it.
+//
+// File format, integers little-endian:
+//   "NWBB", u8 version (1), u32 block count, ceil(blocks / 8) bitmap bytes (block b is
+//   bit b % 8 of byte b / 8), u16 ONFI CRC-16 over everything before it.
+class BadBlockTable {
+public:
+    BadBlockTable() = default;
+    explicit BadBlockTable(uint32_t blocks) : blocks_(blocks), bits_((blocks + 7) / 8, 0) {}
+
+    uint32_t blocks() const { return blocks_; }
+    bool empty() const { return blocks_ == 0; }
+
+    // Blocks past the end of the table read as good.
+    bool is_bad(uint32_t block) const {
+        return block < blocks_ && (bits_[block / 8] >> (block % 8)) & 1;
+    }
+    void mark_bad(uint32_t block, bool bad = true);
+
+    uint32_t bad_count() const;
+    std::vector<uint32_t> bad_blocks() const;
+
+    // Best effort, like the parameter page cache; false if the file was not written.
+    bool save(const std::string& path) const;
+    // False (table unchanged) on a missing file, a CRC mismatch or a block count other
+    // than `expected_blocks`.
+    bool load(const std::string& path, uint32_t expected_blocks);
+
+private:
+    uint32_t blocks_ = 0;
+    std::vector<uint8_t> bits_;
+};
+
+// Table file for the chip with READ UNIQUE ID `id`, or empty when the ID is invalid or
+// caching is off.
+std::string bad_block_table_path(const uint8_t* id);
+
+// Fill device.bad_blocks from the table persisted for `id`, or scan the chip and persist
+// the result when there is none (or `rescan` is set). Returns true when the table came
+// from disk.
+bool attach_bad_block_table(NandDevice& device, const uint8_t* id, bool rescan = false);
+
+} // namespace onfi
+
+#endif // ONFI_BAD_BLOCK_TABLE_HPP
@@ -1,6 +1,7 @@
 #ifndef ONFI_CONTROLLER_H
 #define ONFI_CONTROLLER_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "onfi/types.hpp"
 #include "onfi/transport.hpp"
@@ -17,13 +18,63 @@ public:
 
     void page_read(const uint8_t* addr, uint8_t addr_len, bool pre_zero_cmd = false);
     void change_read_column(const uint8_t* col2bytes);
+    // Random data-out of `n` bytes from `column`: 05h-E0h repositions the column at the
+    // start and again every `chunk` bytes (0: one burst), one sequence per chunk.
+    void read_data_chunked(uint32_t column, uint8_t* dst, uint32_t n, uint32_t chunk);
+
+    // Cache read pipeline, started by page_read(). Each step moves the page already in
+    // the data register to the cache register for read_data() while the array loads
+    // the next page: the following row (31h), an addressed row (00h-addr-31h), or
+    // nothing, ending the pipeline (3Fh).
+    void cache_read_sequential();
+    void cache_read_random(const uint8_t* addr, uint8_t addr_len);
+    void cache_read_end();
     void prefix_command(uint8_t cmd); // send a single-byte prefix command
 
     void program_page(const uint8_t* addr5, const uint8_t* data, uint32_t len);
+    // PROGRAM PAGE CACHE (80h..15h): returns once the cache register is free (SR6)
+    // while the array may still be programming the previous page (SR5 clear).
+    void program_page_cache(const uint8_t* addr5, const uint8_t* data, uint32_t len);
     void program_page_confirm(const uint8_t* addr5, const uint8_t* data, uint32_t len, uint8_t confirm_cmd);
     void erase_block(const uint8_t* row3);
+
+    // COPYBACK READ (00h-addr-35h): load a page into the page register for a later
+    // copyback program. The data may still be read out, e.g. to check it.
+    void copyback_read(const uint8_t* addr5);
+    // COPYBACK PROGRAM (85h-addr-10h) of the page register to a new row. Each patch is
+    // written over the register first with a column change (85h-col-data).
+    void copyback_program(const uint8_t* addr5, const ColumnPatch* patches = nullptr, size_t num_patches = 0);
+
+    // Multi-plane chains. Every plane but the last is queued (80h..11h for program,
+    // 00h..32h for read) with a short tDBSY wait; the last plane's ordinary 10h/30h
+    // starts all planes in the array together.
+    void program_page_queue_plane(const uint8_t* addr5, const uint8_t* data, uint32_t len);
+    void page_read_queue_plane(const uint8_t* addr, uint8_t addr_len);
+    // Point data-out at the plane (and column) named by a full address (06h-addr-E0h).
+    void select_read_plane(const uint8_t* addr, uint8_t addr_len);
+    // 60h-row for each of `count` blocks (rows packed three bytes apart), then one D0h.
+    void erase_blocks_multi_plane(const uint8_t* rows, uint8_t count);
     void partial_erase_block(const uint8_t* row3, uint32_t loop_count);
 
+    // Multi-LUN building blocks. The start_* forms issue an operation without waiting
+    // on R/B#, which the LUNs share; readiness is then polled per LUN with 78h.
+    void start_page_read(const uint8_t* addr, uint8_t addr_len);
+    void start_program_page(const uint8_t* addr5, const uint8_t* data, uint32_t len);
+    void start_erase_block(const uint8_t* row3);
+    // READ STATUS ENHANCED: status of the LUN addressed by `row3`, which also becomes
+    // the LUN that later data output comes from.
+    uint8_t read_status_enhanced(const uint8_t* row3);
+    // READ STATUS (70h) without waiting on R/B#, for a target that shares the line.
+    uint8_t read_status();
+    // 00h (back to data output from the selected LUN) and stream `n` bytes, without
+    // waiting on the shared R/B#.
+    void read_selected_data(uint8_t* dst, uint32_t n);
+
+    // Vendor program/erase suspend: `opcode` then a wait until the LUN accepts reads
+    // (tSPD). Resume issues its opcode and returns with the operation running again.
+    void suspend(uint8_t opcode);
+    void resume(uint8_t opcode);
+
     void set_features(uint8_t address, const uint8_t data[4],
                       FeatureCommand command = FeatureCommand::Set);
     void get_features(uint8_t address, uint8_t out[4],
@@ -31,6 +82,8 @@ public:
 
     void read_data(uint8_t* dst, uint16_t n) const;
     uint8_t get_status();
+    // Private R/B# level of the transport's target (see Transport::ready_line).
+    int ready_line() const;
 };
 
 } // namespace onfi
@@ -2,30 +2,119 @@
 #define ONFI_DEVICE_H
 
 #include <stdint.h>
+#include <functional>
 #include <vector>
 #include "onfi/types.hpp"
 #include "onfi/controller.hpp"
 #include "onfi/data_sink.hpp"
 #include "onfi/address.hpp"
+#include "onfi/bad_block_table.hpp"
 #include "microprocessor_interface.hpp" // for enums
 
 namespace onfi {
 
+// One array operation for NandDevice::run_lun_operations() or run_target_operations().
+struct LunOperation {
+    enum class Kind : uint8_t { Read, Program, Erase };
+
+    Kind kind = Kind::Read;
+    unsigned int target = 0;               // index into run_target_operations()'s devices
+    unsigned int lun = 0;
+    unsigned int block = 0;                // block within the LUN
+    unsigned int page = 0;                 // ignored for Erase
+    bool including_spare = false;
+    const uint8_t* data = nullptr;         // Program payload
+    std::vector<uint8_t>* out = nullptr;   // Read destination
+    bool ok = false;                       // set when the operation completes
+};
+
+// When NandDevice::run_suspendable() may suspend a program or erase to serve reads.
+// Suspend and resume are vendor commands the parameter page does not describe; with
+// suspend_command 0 (the default) operations are never suspended.
+struct SuspendPolicy {
+    uint8_t suspend_command = 0;
+    uint8_t resume_command = 0;
+    uint64_t min_run_ns = 0;     // time the operation runs between two suspends
+    uint32_t max_suspends = 8;   // per operation, so it always completes
+    uint32_t reads_per_suspend = 1;  // reads served before resuming; 0 serves all queued
+};
+
+struct SuspendStats {
+    uint64_t suspends = 0;
+    uint64_t reads_served = 0;        // while suspended or after the operation completed
+    uint64_t suspended_ns_total = 0;  // suspend command to resume command
+    uint64_t suspended_ns_max = 0;
+
+    void reset() { *this = SuspendStats{}; }
+};
+
+// One erase of erase_blocks(): the blocks erased together and the status read after it.
+struct EraseGroup {
+    std::vector<unsigned int> blocks;
+    uint8_t status = 0;
+
+    bool failed() const { return (status & 0x01) != 0; }
+};
+
 // Higher-level device wrapper: owns geometry, routes flows via controller.
 class NandDevice {
     OnfiController& ctrl_;
+    mutable SuspendStats suspend_stats_;
+
+    using PageVisitor = std::function<void(unsigned int page, const std::vector<uint8_t>& data)>;
+
+    // True when multi-page reads may use the cache read pipeline.
+    bool use_cache_read(bool bytewise) const;
+    // True when multi-page programs may use PROGRAM PAGE CACHE.
+    bool use_cache_program() const;
+
+    // Read `pages` of `block` in the given order and hand each to `visit`. With cache
+    // read the next page loads from the array while the visitor handles the current one.
+    void read_pages(unsigned int block, const uint16_t* pages, uint32_t count,
+                    bool including_spare, bool bytewise, const PageVisitor& visit) const;
 public:
     Geometry geometry{};
     default_interface_type interface_type = asynchronous;
     chip_type chip = default_async;
+    Capabilities capabilities{};
+    SuspendPolicy suspend_policy{};
+    // Bytes moved between column changes on bytewise reads (1: a 05h-E0h per byte).
+    uint32_t bytewise_chunk = 1;
+    // Filled by scan_bad_blocks() or attach_bad_block_table(); empty until then.
+    BadBlockTable bad_blocks{};
 
     explicit NandDevice(OnfiController& ctrl) : ctrl_(ctrl) {}
 
     // Read a full page (+optional spare) into a buffer.
-    // If bytewise=true, performs column changes for each byte.
+    // If bytewise=true, repositions the column every bytewise_chunk bytes.
     void read_page(unsigned int block, unsigned int page, bool including_spare,
                    bool bytewise, std::vector<uint8_t>& out) const;
 
+    // Read `length` bytes starting at `column` (spare columns follow the main area) into
+    // `out`: the page is loaded with 00h-30h and only the range crosses the bus, after a
+    // 05h-E0h column change. Throws std::out_of_range past the end of the spare area.
+    void read_range(unsigned int block, unsigned int page, uint32_t column, uint32_t length,
+                    uint8_t* out, bool bytewise = false) const;
+    // read_range over the whole spare area.
+    void read_spare(unsigned int block, unsigned int page, std::vector<uint8_t>& out) const;
+    // Pages carrying the factory bad-block marker: the first page, and on MLC/TLC parts
+    // the last page as well.
+    std::vector<unsigned int> marker_pages() const;
+    // Factory marker: the first spare byte of any marker page reads 00h.
+    bool is_bad_block(unsigned int block) const;
+    // Bad-block table lookups, without touching the bus; false for every block until a
+    // table is attached. The first takes a block index as every block-based call does
+    // (see lun_block()), the second a block within `lun`.
+    bool is_bad(unsigned int block) const;
+    bool is_bad(unsigned int lun, unsigned int block) const {
+        return block < geometry.blocks_per_lun && bad_blocks.is_bad(lun * geometry.blocks_per_lun + block);
+    }
+    // is_bad_block for every block of every LUN (table index lun * blocks_per_lun + block),
+    // moving only the marker byte of each
+    // marker page over the bus. With cache read the next marker page loads from the
+    // array while the current one is checked.
+    BadBlockTable scan_bad_blocks() const;
+
     // Program a page from provided data; including_spare controls total bytes.
     void program_page(unsigned int block, unsigned int page, const uint8_t* data,
                       bool including_spare) const;
@@ -33,6 +122,51 @@ public:
     // Erase block
     void erase_block(unsigned int block) const;
 
+    // Move a page (data + spare) inside the device with COPYBACK READ/PROGRAM, so no
+    // page data crosses the bus. Up to four `patches` are written over the copy on the
+    // way; more throw std::invalid_argument. Without copyback support, or across planes,
+    // the page is read out, patched and programmed instead. Returns false if the
+    // program reported a failure.
+    bool copy_page(unsigned int src_block, unsigned int src_page,
+                   unsigned int dst_block, unsigned int dst_page,
+                   const ColumnPatch* patches = nullptr, size_t num_patches = 0) const;
+
+    // copy_page for selected or all pages of a block, each to the same page index of
+    // `dst_block` (which must be erased), with the same patches on every page.
+    bool copy_block(unsigned int src_block, unsigned int dst_block,
+                    bool complete_block,
+                    const uint16_t* page_indices,
+                    uint16_t num_pages,
+                    const ColumnPatch* patches = nullptr, size_t num_patches = 0) const;
+
+    // Planes per LUN from the parameter page (1 when unknown) and the plane of a block.
+    uint32_t planes() const { return capabilities.planes(); }
+    uint32_t plane_of(unsigned int block) const { return block & (planes() - 1); }
+
+    // Split `blocks` (order kept) into groups that one multi-plane operation can cover:
+    // one block per plane, sharing the non-plane address bits unless the device lifts
+    // that restriction. Single-plane devices get one block per group.
+    std::vector<std::vector<unsigned int>> plane_groups(const unsigned int* blocks, size_t count,
+                                                        bool multi_plane) const;
+
+    using EraseProgress = std::function<void(const EraseGroup& group)>;
+
+    // Erase a list of blocks, one multi-plane erase (60h..60h..D0h) per plane group
+    // when supported. `progress` sees every group once its status is in. Returns the
+    // groups that reported failure; unless `keep_going`, the first one ends the run.
+    std::vector<EraseGroup> erase_blocks(const unsigned int* blocks, size_t count, bool keep_going = false,
+                                         const EraseProgress& progress = nullptr) const;
+
+    // Program the same page in blocks on distinct planes with one 80h..11h / 80h..10h
+    // chain; data[i] goes to blocks[i]. Returns false if the status reported failure.
+    bool program_page_multi_plane(const unsigned int* blocks, const uint8_t* const* data, size_t count,
+                                  unsigned int page, bool including_spare) const;
+
+    // Read the same page from blocks on distinct planes (00h..32h, 00h..30h), then
+    // stream each plane's register through 06h-E0h; out[i] holds blocks[i].
+    void read_page_multi_plane(const unsigned int* blocks, size_t count, unsigned int page,
+                               bool including_spare, std::vector<std::vector<uint8_t>>& out) const;
+
     // Partial erase block (custom flow), page is used to form row address
     void partial_erase_block(unsigned int block, unsigned int page_in_block, uint32_t loop_count) const;
 
@@ -43,7 +177,41 @@ public:
                           const uint8_t* data, bool including_spare) const;
     void read_tlc_subpages(unsigned int block, unsigned int page, DataSink& sink) const;
 
-    // Read selected or full block pages and stream to sink
+    // LUNs behind this chip enable (parameter page byte 100).
+    uint32_t luns() const { return geometry.luns ? geometry.luns : 1; }
+    // Block index addressing `block` of `lun`; usable with every block-based call.
+    unsigned int lun_block(unsigned int lun, unsigned int block) const {
+        return lun_block_index(geometry.blocks_per_lun, lun, block);
+    }
+    // READ STATUS ENHANCED (78h) for one LUN.
+    uint8_t lun_status(unsigned int lun) const;
+
+    // Run operations with one in flight per LUN: each LUN works through its own
+    // operations in order while the others are busy, with readiness polled by 78h
+    // instead of the shared R/B#. Without multi-LUN support (or with one LUN) the
+    // operations run one after another. Returns false if any operation failed.
+    bool run_lun_operations(std::vector<LunOperation>& ops) const;
+
+    // Start a program or erase (`op`) and serve `reads` while it is busy: each time it
+    // has run for min_run_ns it is suspended, up to reads_per_suspend reads are served
+    // and it is resumed, at most max_suspends times. Reads left over (or all of them,
+    // without a suspend policy) run after it completes.
+    // Returns false if any operation failed.
+    bool run_suspendable(LunOperation& op, std::vector<LunOperation>& reads) const;
+    const SuspendStats& suspend_stats() const { return suspend_stats_; }
+    void reset_suspend_stats() const { suspend_stats_.reset(); }
+
+    // Scheduler building blocks: issue `op` without waiting on R/B#, then complete it
+    // once `status` shows its LUN ready (read the page out, or take pass/fail).
+    void start_operation(const LunOperation& op) const;
+    bool finish_operation(LunOperation& op, uint8_t status) const;
+    // READ STATUS (70h) without waiting on R/B#.
+    uint8_t read_status() const { return ctrl_.read_status(); }
+    // R/B# level private to this device's CE# target: 1 ready, 0 busy, -1 shared.
+    int ready_line() const { return ctrl_.ready_line(); }
+
+    // Read selected or full block pages and stream to sink. Uses cache read (31h/3Fh)
+    // when the device advertises it and bytewise is false.
     void read_block(unsigned int block,
                     bool complete_block,
                     const uint16_t* page_indices,
@@ -52,8 +220,10 @@ public:
                     bool bytewise,
                     DataSink& sink) const;
 
-    // Program pages in a block with either zeroed data or provided/random data
-    void program_block(unsigned int block,
+    // Program pages in a block with either zeroed data or provided/random data.
+    // Chains pages with PROGRAM PAGE CACHE (15h) when the device advertises it.
+    // Returns false if any page reported a program failure in the status register.
+    bool program_block(unsigned int block,
                        bool complete_block,
                        const uint16_t* page_indices,
                        uint16_t num_pages,
@@ -61,6 +231,18 @@ public:
                        bool including_spare,
                        bool randomize) const;
 
+    // program_block over several blocks: each page index is programmed in every block
+    // of a plane group at once when multi-plane program is supported. A single block
+    // goes through program_block.
+    bool program_blocks(const unsigned int* blocks,
+                        size_t num_blocks,
+                        bool complete_block,
+                        const uint16_t* page_indices,
+                        uint16_t num_pages,
+                        const uint8_t* provided_data,
+                        bool including_spare,
+                        bool randomize) const;
+
     // Verification helpers
     bool verify_program_page(unsigned int block, unsigned int page,
                              const uint8_t* expected,
@@ -70,6 +252,15 @@ public:
                              uint32_t* out_byte_errors = nullptr,
                              uint32_t* out_bit_errors = nullptr) const;
 
+    // verify_program_page for `length` bytes at `column`; `expected` holds just the range
+    // (all 00h when null).
+    bool verify_range(unsigned int block, unsigned int page,
+                      uint32_t column, uint32_t length,
+                      const uint8_t* expected,
+                      int max_allowed_errors,
+                      uint32_t* out_byte_errors = nullptr,
+                      uint32_t* out_bit_errors = nullptr) const;
+
     bool verify_program_block(unsigned int block,
                               bool complete_block,
                               const uint16_t* page_indices,
@@ -87,6 +278,13 @@ public:
                             bool verbose) const;
 };
 
+// Run operations across CE# targets sharing one bus, one in flight per target:
+// `targets[op.target]` executes `op`, and an idle target starts its next operation
+// while the others are busy. A target with a private R/B# is skipped while that
+// line is low; otherwise its readiness comes from READ STATUS. Returns false if any
+// operation failed.
+bool run_target_operations(const std::vector<const NandDevice*>& targets, std::vector<LunOperation>& ops);
+
 } // namespace onfi
 
 #endif // ONFI_DEVICE_H
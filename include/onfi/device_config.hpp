@@ -11,15 +11,19 @@ struct DeviceConfig {
     Geometry geometry{};
     default_interface_type interface_type = asynchronous;
     chip_type chip = default_async;
+    Capabilities capabilities{};
 };
 
 inline void apply_device_config(const DeviceConfig& config, NandDevice& device) {
     device.geometry = config.geometry;
     device.interface_type = config.interface_type;
     device.chip = config.chip;
+    device.capabilities = config.capabilities;
 }
 
 DeviceConfig make_device_config(const ::onfi_interface& source);
+// Configuration of CE# target `target` as identified by get_started().
+DeviceConfig make_device_config(const ::onfi_interface& source, unsigned int target);
 
 } // namespace onfi
 
@@ -0,0 +1,44 @@
+#ifndef ONFI_PARAM_CACHE_HPP
+#define ONFI_PARAM_CACHE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace onfi {
+
+// On-disk cache of CRC-validated ONFI parameter pages, one raw 256-byte file per chip
+// (the layout of a `parameters --output` dump), named after the chip's READ UNIQUE ID.
+// Other per-chip state (the bad-block table) lives alongside under the same naming.
+
+constexpr size_t kUniqueIdBytes = 32;
+constexpr size_t kParameterPageBytes = 256;
+
+// READ UNIQUE ID returns 16 bytes followed by their complement. Anything else (no unique
+// ID support, a bad transfer) cannot key a cache entry.
+bool unique_id_valid(const uint8_t* id);
+
+// $NANDWORKS_PARAM_CACHE (set but empty disables the cache), else
+// $XDG_CACHE_HOME/nandworks or $HOME/.cache/nandworks. Empty when caching is off.
+std::string parameter_cache_dir();
+
+// `<cache dir>/<first 16 ID bytes in hex><extension>`, or empty when the ID is invalid
+// or caching is off. Every per-chip cache file is named this way.
+std::string chip_cache_path(const uint8_t* id, const char* extension);
+
+// Cache file for `id` (extension .onfi), or empty when the ID is invalid or caching is off.
+std::string parameter_cache_path(const uint8_t* id);
+
+// Write `path` through a temporary file and a rename, creating the cache directory.
+// False if any step failed; nothing is left behind then.
+bool write_cache_file(const std::string& path, const uint8_t* data, size_t length);
+
+// Fill `params` from the cache; false on a miss or an entry that fails its CRC.
+bool load_cached_parameter_page(const uint8_t* id, uint8_t* params);
+
+// Best effort: an unwritable cache only costs the next session a parameter page read.
+void store_cached_parameter_page(const uint8_t* id, const uint8_t* params);
+
+} // namespace onfi
+
+#endif // ONFI_PARAM_CACHE_HPP
@@ -1,11 +1,18 @@
 #ifndef ONFI_PARAM_PAGE_H
 #define ONFI_PARAM_PAGE_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "onfi/types.hpp"
 
 namespace onfi {
 
+// ONFI parameter page CRC-16: polynomial 0x8005, initial value 0x4F4E, MSB first
+uint16_t onfi_crc16(const uint8_t* data, size_t length);
+
+// True when bytes 254-255 (little-endian) hold the CRC-16 of bytes 0-253
+bool parameter_page_crc_valid(const uint8_t* params);
+
 // Decode version digits from ONFI parameter bytes 4-5
 Version decode_onfi_version(uint8_t byte4, uint8_t byte5);
 
@@ -15,6 +22,13 @@ uint32_t parse_spare_size(uint8_t b85, uint8_t b84);
 uint32_t parse_pages_per_block(uint8_t b95, uint8_t b94, uint8_t b93, uint8_t b92);
 uint32_t parse_blocks_per_lun(uint8_t b99, uint8_t b98, uint8_t b97, uint8_t b96);
 
+// tR maximum page read time in microseconds from bytes 137-138; 0 when not reported
+uint32_t parse_max_read_time_us(uint8_t b138, uint8_t b137);
+
+// Supported features and optional commands from bytes 6-9, plane layout from 113-114,
+// tCCS from 139-140
+Capabilities parse_capabilities(const uint8_t* params);
+
 // Convenience: extract geometry and cycles from the full 256-byte parameter page
 void parse_geometry_from_parameters(const uint8_t* params, Geometry& out);
 
@@ -0,0 +1,65 @@
+#ifndef ONFI_SEQUENCE_HPP
+#define ONFI_SEQUENCE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rb_wait.hpp"
+
+namespace onfi {
+
+// Compact micro-op program describing one complete ONFI operation
+// (command, address, data-in/out and ready-wait phases). Transports run the whole
+// program with CE# held low instead of restoring the control pins after every phase.
+// Address bytes are copied into the program; data buffers are referenced and must
+// outlive the call to Transport::execute().
+class Sequence {
+public:
+    static constexpr size_t kMaxOps = 24;
+    static constexpr size_t kMaxAddressBytes = 16;
+
+    enum class Op : uint8_t {
+        Command,
+        Address,
+        DataIn,
+        DataOut,
+        WaitReady,
+        Delay,
+    };
+
+    struct MicroOp {
+        Op op;
+        uint8_t value;          // command byte, offset into the address pool, or RbWaitOp
+        uint32_t length;        // address cycles, data bytes or delay nanoseconds
+        const uint8_t* src;     // DataIn payload
+        uint8_t* dst;           // DataOut destination
+    };
+
+    Sequence& command(uint8_t cmd);
+    Sequence& address(const uint8_t* bytes, uint8_t count);
+    Sequence& data_in(const uint8_t* data, uint32_t count);
+    Sequence& data_out(uint8_t* dst, uint32_t count);
+    // `kind` selects the transport's R/B# wait policy for this operation
+    Sequence& wait_ready(RbWaitOp kind = RbWaitOp::Generic);
+    // Fixed settle time between phases, e.g. tCCS after a column change
+    Sequence& wait_ns(uint32_t ns);
+
+    void clear() { op_count_ = 0; address_used_ = 0; }
+
+    const MicroOp* begin() const { return ops_; }
+    const MicroOp* end() const { return ops_ + op_count_; }
+    size_t size() const { return op_count_; }
+
+    const uint8_t* address_bytes(const MicroOp& op) const { return address_pool_ + op.value; }
+
+private:
+    MicroOp& push(Op op);
+
+    MicroOp ops_[kMaxOps];
+    uint8_t address_pool_[kMaxAddressBytes];
+    size_t op_count_ = 0;
+    size_t address_used_ = 0;
+};
+
+} // namespace onfi
+
+#endif // ONFI_SEQUENCE_HPP
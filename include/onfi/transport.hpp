@@ -2,9 +2,12 @@
 #define ONFI_TRANSPORT_HPP
 
 #include <stdint.h>
+#include "onfi/types.hpp"
 
 namespace onfi {
 
+class Sequence;
+
 class Transport {
 public:
     virtual ~Transport() = default;
@@ -16,6 +19,47 @@ public:
     virtual void delay_function(uint32_t loop_count) = 0;
     virtual void get_data(uint8_t* dst, uint16_t count) const = 0;
     virtual uint8_t get_status() = 0;
+
+    // Run a complete micro-op program. The default issues one call per phase;
+    // transports override it to keep CE# asserted across the whole operation.
+    virtual void execute(const Sequence& sequence);
+
+    // Route later calls to chip-enable target `target`. Single-target transports
+    // accept only target 0.
+    virtual void select_target(unsigned int target);
+
+    // Level of an R/B# line that only the selected target drives: 1 ready, 0 busy.
+    // -1 when the line is shared with other targets (or absent); poll status instead.
+    virtual int ready_line() const { return -1; }
+
+    // tCCS of the selected target: the wait after a column change before its data cycles.
+    virtual uint32_t column_change_ns() const { return kDefaultColumnChangeNs; }
+};
+
+// Transport bound to one CE# target of a multi-target bus: selects the target before
+// every call and forwards to `bus`. One per NandDevice lets several devices share the
+// DQ/control lines.
+class TargetTransport : public Transport {
+    Transport& bus_;
+    unsigned int target_;
+public:
+    TargetTransport(Transport& bus, unsigned int target) : bus_(bus), target_(target) {}
+
+    unsigned int target() const { return target_; }
+
+    void send_command(uint8_t command) const override { bus_.select_target(target_); bus_.send_command(command); }
+    void send_addresses(const uint8_t* address, uint8_t count, bool verbose = false) const override {
+        bus_.select_target(target_);
+        bus_.send_addresses(address, count, verbose);
+    }
+    void send_data(const uint8_t* data, uint16_t count) const override { bus_.select_target(target_); bus_.send_data(data, count); }
+    void wait_ready_blocking() const override { bus_.select_target(target_); bus_.wait_ready_blocking(); }
+    void delay_function(uint32_t loop_count) override { bus_.delay_function(loop_count); }
+    void get_data(uint8_t* dst, uint16_t count) const override { bus_.select_target(target_); bus_.get_data(dst, count); }
+    uint8_t get_status() override { bus_.select_target(target_); return bus_.get_status(); }
+    void execute(const Sequence& sequence) override { bus_.select_target(target_); bus_.execute(sequence); }
+    int ready_line() const override { bus_.select_target(target_); return bus_.ready_line(); }
+    uint32_t column_change_ns() const override { bus_.select_target(target_); return bus_.column_change_ns(); }
 };
 
 } // namespace onfi
@@ -18,10 +18,47 @@ struct Geometry {
     uint32_t spare_size_bytes = 0;       // spare (OOB) area
     uint32_t pages_per_block = 0;
     uint32_t blocks_per_lun = 0;
+    uint32_t luns = 1;                   // LUNs sharing this chip enable
     uint8_t  column_cycles = 0;
     uint8_t  row_cycles = 0;
 };
 
+// ONFI tCCS used before the parameter page is read
+constexpr uint16_t kDefaultColumnChangeNs = 500;
+
+// Optional features (parameter page bytes 6-7) and commands (bytes 8-9) the device
+// advertises, plus the plane layout (bytes 113-114). Zero means unknown, which keeps
+// every caller on the basic single-plane command set.
+struct Capabilities {
+    uint16_t features = 0;
+    uint16_t optional_commands = 0;
+    uint8_t plane_address_bits = 0;      // low block-address bits selecting the plane
+    uint8_t multi_plane_attributes = 0;
+    // tCCS change column setup (bytes 139-140): from the 05h-E0h or 85h column change
+    // to the next data cycle. The ONFI default holds until the page says otherwise.
+    uint16_t column_change_ns = kDefaultColumnChangeNs;
+
+    uint32_t planes() const { return 1u << plane_address_bits; }
+    bool multi_plane_program_erase() const { return planes() > 1 && (features & 0x0008) != 0; }
+    bool multi_plane_read() const { return planes() > 1 && (features & 0x0040) != 0; }
+    // Without this bit the blocks of one multi-plane operation must share every
+    // block-address bit above the plane bits.
+    bool multi_plane_any_block() const { return (multi_plane_attributes & 0x02) != 0; }
+    bool cache_program() const { return (optional_commands & 0x0001) != 0; }
+    bool cache_read() const { return (optional_commands & 0x0002) != 0; }
+    bool copyback() const { return (optional_commands & 0x0010) != 0; }
+    // LUNs may run array operations concurrently (selected with READ STATUS ENHANCED)
+    bool multi_lun_operations() const { return (features & 0x0002) != 0; }
+};
+
+// Bytes written over a page register from `column` on, e.g. spare bytes patched in
+// flight during a copyback.
+struct ColumnPatch {
+    uint16_t column = 0;
+    const uint8_t* data = nullptr;
+    uint16_t length = 0;
+};
+
 // Simple container for ONFI version digits
 struct Version {
     char major = 'x';
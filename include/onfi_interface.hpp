@@ -54,9 +54,16 @@ private:
     std::fstream onfi_data_file;
 	std::fstream time_info_file;
 	mutable std::vector<uint8_t> scratch_buffer_;
+	// raw GPLEV0 words captured during a data-out burst, decoded after RE# goes idle
+	mutable std::vector<uint32_t> capture_levels_;
 	bool erase_enabled_ = true;
 
 	uint8_t* ensure_scratch(size_t size);
+	uint32_t* ensure_capture(size_t count) const;
+	// asynchronous data-out burst; CE# must already be low and stays low
+	void read_data_held(uint8_t* data_received, uint32_t num_data) const;
+	// StatusPoll wait inside a held sequence: 70h, then RE# strobes until RDY
+	void poll_status_held(RbWaitOp op) const;
 
 public:
 	// public items go here: this should be almost all the required functions
@@ -82,28 +89,59 @@ public:
 	}
 	void send_data(const uint8_t* data_to_send, uint16_t num_data) const override { interface::send_data(data_to_send, num_data); }
 	void wait_ready_blocking() const override { interface::wait_ready_blocking(); }
+	void select_target(unsigned int target) override { interface::select_target(target); }
+	int ready_line() const override;
+	uint32_t column_change_ns() const override;
 
 	// let us make these paramters public
 	uint16_t num_bytes_in_page;
 	uint16_t num_spare_bytes_in_page;
 	uint16_t num_pages_in_block;
 	uint16_t num_blocks;
+	// LUNs per chip enable (parameter page byte 100); blocks above are per LUN
+	uint8_t num_luns = 1;
 	uint8_t num_column_cycles;
 	uint8_t num_row_cycles;
+	// ONFI parameter page bytes 129-130: bit n set when asynchronous timing mode n is supported (0 if unknown)
+	uint16_t async_timing_modes = 0;
+	// ONFI parameter page bytes 6-9: optional features and commands (empty if unknown or JEDEC)
+	onfi::Capabilities capabilities{};
+	// Per CE# target (see ONFI_TARGETS), filled by get_started(); index 0 matches the
+	// fields above, which always describe target 0.
+	std::vector<onfi::Geometry> target_geometry;
+	std::vector<onfi::Capabilities> target_capabilities;
 
 	char manufacturer_id[13];
 	char device_model[21];
 	char onfi_version[5];
 	char unique_id[33]; // 32 bytes for unique ID + null terminator
+	// Raw page last decoded by read_parameters(), and whether it (or a redundant copy)
+	// passed the ONFI CRC-16; always false for JEDEC pages, which are not checked
+	uint8_t parameter_page[256] = {};
+	bool parameter_page_crc_ok = false;
 
 
 	/**
 	 * @brief Initialize the ONFI stack and underlying HAL resources.
 	 * @param ONFI_OR_JEDEC Select ONFI (default) or JEDEC parameter parsing.
 	 * @param verbose Emit initialization details and parameter summaries when true.
+	 * @details With several CE# targets every target is reset and identified, and all
+	 *          are put in the fastest timing mode they have in common.
 	 */
 	void get_started(param_type ONFI_OR_JEDEC=ONFI, bool verbose = false);
 
+	/**
+	 * @brief First step of get_started(): HAL resources up and every pin idle, without
+	 *        talking to the device.
+	 */
+	void open_bus(bool verbose = false);
+
+	/**
+	 * @brief Last step of get_started(): READ ID, the parameter page of every target and
+	 *        the common timing mode. Expects a bus that is open and a device that was reset.
+	 */
+	void identify_targets(param_type ONFI_OR_JEDEC=ONFI, bool verbose = false);
+
 /**
 	 * @brief Bring up the hardware bridge, map registers, and perform power-on checks.
 	 * @param verbose Emit detailed status to stdout if true.
@@ -127,6 +165,29 @@ public:
 	 */
 	uint8_t get_status() override;
 
+/**
+	 * @brief Run a compiled ONFI micro-op program with CE# held low throughout.
+	 * @details Control pins are restored once at the end instead of after every phase.
+	 *          Toggle-mode parts fall back to the per-phase Transport implementation.
+	 * @param sequence Program built with onfi::Sequence.
+	 */
+	void execute(const onfi::Sequence& sequence) override;
+
+/**
+	 * @brief True when waits for `op` poll READ STATUS instead of watching R/B#.
+	 */
+	bool polls_status(RbWaitOp op) const;
+
+/**
+	 * @brief Wait for the array to go ready outside a compiled sequence.
+	 * @details Under the StatusPoll policy this issues its own 70h poll with CE# low and,
+	 *          when `data_follows`, latches 00h so the next get_data() returns the data
+	 *          register. Other policies wait on R/B# as wait_ready_blocking(op) does.
+	 * @param op Operation whose wait policy applies.
+	 * @param data_follows The caller reads data next (READ, READ PARAMETER PAGE, READ ID).
+	 */
+	void wait_ready_op(RbWaitOp op, bool data_follows = false) const;
+
 /**
 	 * @brief Print a human-readable failure interpretation of the status register.
 	 */
@@ -147,10 +208,25 @@ public:
 	/**
 	 * @brief Read and decode the ONFI parameter page.
 	 * @param ONFI_OR_JEDEC Select ONFI (default) or JEDEC parameter parsing.
-	 * @param bytewise Read data byte-by-byte (true) or word-wise (false).
+	 * @param bytewise Reposition the read column during the transfer (true) or read one burst (false).
 	 * @param verbose Emit raw page contents and decoded information.
+	 * @param bytewise_chunk Bytes read between column changes when bytewise (1 = every byte).
+	 * @details An ONFI page that fails its CRC-16 is read again in one burst together with
+	 *          the redundant copies at offsets 256 and 512, and the first valid copy is used.
 	 */
-	void read_parameters(param_type ONFI_OR_JEDEC=ONFI,bool bytewise = true, bool verbose = false);
+	void read_parameters(param_type ONFI_OR_JEDEC=ONFI,bool bytewise = true, bool verbose = false, uint32_t bytewise_chunk = 1);
+
+	/**
+	 * @brief Take the ONFI parameter page from the on-disk cache keyed by the unique ID
+	 *        read by read_id(), falling back to read_parameters() on a miss.
+	 * @details A page read from the device that passes its CRC-16 is stored for the next
+	 *          session. JEDEC pages always come from the device. See onfi/param_cache.hpp.
+	 * @return true when the page came from the cache.
+	 */
+	bool read_parameters_cached(param_type ONFI_OR_JEDEC=ONFI, bool bytewise = true, bool verbose = false);
+
+	/** @brief Decode a 256-byte parameter page into the geometry and capability fields. */
+	void decode_parameters(param_type ONFI_OR_JEDEC, const uint8_t* ONFI_parameters, bool verbose = false);
 
 	/** @brief Issue the ONFI Read-ID sequence. */
 	void read_id();
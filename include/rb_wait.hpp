@@ -0,0 +1,134 @@
+#ifndef RB_WAIT_H
+#define RB_WAIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ready/Busy (R/B#) wait policies.
+// Every wait starts by spinning on GPLEV0. Spin keeps doing that until the device is
+// ready (lowest latency, burns the core for all of tPROG/tBERS). The hybrid modes spin
+// for `spin_ns` (sized to the expected tR) and then park the thread: SpinThenEdge
+// blocks in epoll on a rising-edge event for R/B# from the GPIO character device,
+// SpinThenSleep sleeps in calibrated clock_nanosleep slices and re-polls. When the
+// edge event cannot be requested (no /dev/gpiochip, simulated backend) SpinThenEdge
+// falls back to sleeping.
+// StatusPoll does not use R/B# at all: a sequence run by onfi_interface::execute()
+// issues 70h once and re-strobes RE# every `poll_interval_ns` until the status byte
+// shows RDY, for rigs without R/B# or with the line shared between LUNs and targets.
+// The legacy per-call paths (parameter page, timed commands, get_data) poll through
+// onfi_interface::wait_ready_op(); RbWaiter::wait() itself still spins on R/B#.
+
+enum class RbWaitMode : uint8_t {
+    Spin,
+    SpinThenSleep,
+    SpinThenEdge,
+    StatusPoll,
+};
+
+// Operation the wait belongs to; each has its own policy and statistics.
+enum class RbWaitOp : uint8_t {
+    Generic,
+    Read,
+    Program,
+    Erase,
+    Reset,
+    Count,
+};
+
+struct RbWaitPolicy {
+    RbWaitMode mode = RbWaitMode::Spin;
+    uint64_t spin_ns = 50000;        // spin window before parking
+    uint64_t sleep_slice_ns = 20000; // target wake interval for SpinThenSleep
+    uint64_t poll_interval_ns = 0;   // StatusPoll: gap between status samples
+    uint64_t timeout_ns = 0;         // StatusPoll: give up after this long (0: never)
+};
+
+// Wake latency is the time from R/B# rising to the waiter observing it. With an edge
+// event it is measured from the kernel event timestamp; for sleep slices it is bounded
+// by the gap since the last busy sample. Only parked waits contribute.
+struct RbWaitStats {
+    uint64_t waits = 0;
+    uint64_t parked = 0;
+    uint64_t edge_wakeups = 0;
+    uint64_t total_ns = 0;
+    uint64_t wake_latency_total_ns = 0;
+    uint64_t wake_latency_max_ns = 0;
+    // StatusPoll waits, the status bytes they sampled and their detection latency
+    // (last busy sample to the ready one, bounded by the poll spacing)
+    uint64_t status_polls = 0;
+    uint64_t status_reads = 0;
+    uint64_t poll_latency_total_ns = 0;
+    uint64_t poll_latency_max_ns = 0;
+
+    double mean_wake_latency_ns() const {
+        return parked ? static_cast<double>(wake_latency_total_ns) / static_cast<double>(parked) : 0.0;
+    }
+    double mean_poll_latency_ns() const {
+        return status_polls ? static_cast<double>(poll_latency_total_ns) / static_cast<double>(status_polls) : 0.0;
+    }
+    void reset() { *this = RbWaitStats{}; }
+};
+
+const char* rb_wait_mode_name(RbWaitMode mode);
+const char* rb_wait_op_name(RbWaitOp op);
+
+class RbWaiter {
+public:
+    RbWaiter();
+    ~RbWaiter();
+    RbWaiter(const RbWaiter&) = delete;
+    RbWaiter& operator=(const RbWaiter&) = delete;
+
+    void set_policy(RbWaitOp op, const RbWaitPolicy& policy) { policies_[index(op)] = policy; }
+    const RbWaitPolicy& policy(RbWaitOp op) const { return policies_[index(op)]; }
+
+    const RbWaitStats& stats(RbWaitOp op) const { return stats_[index(op)]; }
+    void reset_stats();
+
+    // Block until R/B# reads high, using the policy registered for `op`.
+    void wait(RbWaitOp op);
+
+    // Account a StatusPoll wait done by the transport (see RbWaitStats).
+    void record_status_poll(RbWaitOp op, uint64_t elapsed_ns, uint64_t reads, uint64_t latency_ns);
+
+    // True once the current pin's rising-edge event is armed (requested lazily on first use).
+    bool edge_available();
+
+    // R/B# line to wait on (GPIO_RB by default). Each pin's edge event is requested on
+    // its first park and kept, so switching between targets, which may share R/B#,
+    // does not reopen it.
+    void set_pin(uint8_t pin);
+    uint8_t pin() const { return pin_; }
+
+    // Measured clock_nanosleep overshoot subtracted from every sleep slice.
+    uint64_t sleep_overshoot_ns();
+
+private:
+    static size_t index(RbWaitOp op) { return static_cast<size_t>(op); }
+
+    void park_sleep(const RbWaitPolicy& policy, RbWaitStats& stats, uint64_t last_busy_ns);
+    void park_edge(RbWaitStats& stats, uint64_t last_busy_ns);
+    void drain_events();
+    void release_edges();
+    bool ready() const;
+
+    // Edge event line of one R/B# pin
+    struct EdgeLine {
+        int line_fd = -1;
+        int epoll_fd = -1;
+        bool tried = false;
+    };
+    static constexpr size_t kBankPins = 32;  // GPLEV0 covers GPIO 0-31
+
+    RbWaitPolicy policies_[static_cast<size_t>(RbWaitOp::Count)];
+    RbWaitStats stats_[static_cast<size_t>(RbWaitOp::Count)];
+
+    uint8_t pin_;
+    uint32_t mask_;
+    EdgeLine edges_[kBankPins];
+    EdgeLine* edge_;  // entry of pin_
+    bool calibrated_ = false;
+    uint64_t overshoot_ns_ = 0;
+};
+
+#endif // RB_WAIT_H
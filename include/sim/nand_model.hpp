@@ -0,0 +1,228 @@
+#ifndef SIM_NAND_MODEL_HPP
+#define SIM_NAND_MODEL_HPP
+
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "hardware_locations.hpp"
+#include "sim/register_file.hpp"
+
+namespace sim {
+
+struct NandModelConfig {
+    uint32_t page_size = 2048;
+    uint32_t spare_size = 64;
+    uint32_t pages_per_block = 256;
+    uint32_t blocks = 128;              // per LUN
+    uint32_t luns = 1;
+    // Chip-enable and R/B# lines of this target; several models on a PinBus share
+    // everything else
+    uint8_t ce_pin = GPIO_CE;
+    uint8_t rb_pin = GPIO_RB;
+    uint8_t column_cycles = 2;
+    uint8_t row_cycles = 3;
+    // Low block-address bits selecting the plane (1 => two planes)
+    uint8_t plane_address_bits = 1;
+    // GPLEV0 samples R/B# stays low after each operation (stand-ins for tR/tPROG/tBERS)
+    uint32_t read_busy_samples = 4;
+    uint32_t program_busy_samples = 8;
+    uint32_t erase_busy_samples = 16;
+    // R/B# low time when a cache operation hands over a register (tRCBSY/tCBSY)
+    uint32_t cache_busy_samples = 1;
+    // Vendor program/erase suspend and resume opcodes (0 disables suspend); R/B# stays
+    // low for suspend_busy_samples before the suspended LUN accepts reads (tSPD)
+    uint8_t suspend_command = 0xB0;
+    uint8_t resume_command = 0x30;
+    uint32_t suspend_busy_samples = 2;
+    // Leading copies of the three parameter page copies that read back with a flipped
+    // bit (in the page size field), failing their CRC
+    uint32_t corrupt_parameter_copies = 0;
+    // Blocks shipped with the factory bad-block marker (0x00 at the first spare byte of page 0)
+    std::vector<uint32_t> factory_bad_blocks;
+};
+
+struct NandModelStats {
+    uint64_t commands = 0;
+    uint64_t address_cycles = 0;
+    uint64_t data_in_bytes = 0;
+    uint64_t data_out_bytes = 0;
+    uint64_t page_reads = 0;
+    uint64_t cache_reads = 0;
+    uint64_t page_programs = 0;
+    uint64_t cache_programs = 0;
+    uint64_t parameter_page_reads = 0;
+    uint64_t copyback_reads = 0;
+    uint64_t copyback_programs = 0;
+    uint64_t suspends = 0;
+    uint64_t resumes = 0;
+    uint64_t block_erases = 0;
+    uint64_t multi_plane_ops = 0;
+    // Multi-plane operations naming one plane twice or mixing block-address groups
+    uint64_t plane_conflicts = 0;
+    // Level samples during which more than one LUN was busy
+    uint64_t concurrent_lun_samples = 0;
+    uint64_t ignored_while_busy = 0;
+    uint64_t unknown_commands = 0;
+    // RE# strobed while the host still drove DQ as outputs
+    uint64_t bus_conflicts = 0;
+};
+
+// Pin-level ONFI NAND target (asynchronous interface) attached to the simulated GPIO
+// bank using the wiring from hardware_locations.hpp, with CE# and R/B# taken from the
+// config. Commands, addresses and data are latched on WE# rising edges, data-out
+// advances on RE# rising edges and R/B# is driven low for a configurable number of
+// level samples after array operations.
+// Supports RESET, READ ID, READ PARAMETER PAGE, READ UNIQUE ID, GET/SET FEATURES,
+// READ STATUS (and enhanced), page read with CHANGE READ COLUMN, sequential and random
+// cache read, page program (plain and cached) with CHANGE WRITE COLUMN, COPYBACK READ and
+// PROGRAM, block erase, and the multi-plane forms of program (11h), read (32h with
+// 06h-E0h plane select) and erase.
+// With several LUNs each keeps its own registers, status and busy time; the LUN named by
+// the last row address or READ STATUS ENHANCED (78h) is the selected one, and R/B# is
+// low while any LUN is busy. Cache operations release R/B# (SR6) after the register
+// hand-over while the array stays busy (SR5) for the full operation time. A program or
+// erase can be suspended (config opcodes) to serve reads and resumed with the busy time
+// it had left.
+class NandModel : public PinDevice {
+public:
+    explicit NandModel(NandModelConfig config = NandModelConfig{});
+
+    void on_pins(uint32_t previous, uint32_t current, uint32_t host_outputs) override;
+    uint32_t on_sample(uint32_t host_levels, uint32_t host_outputs, uint32_t& driven) override;
+
+    const NandModelConfig& config() const { return config_; }
+    NandModelStats& stats() { return stats_; }
+    bool busy() const { return busy_samples_ > 0; }
+    bool array_busy() const { return busy() || array_busy_samples_ > 0; }
+    uint8_t status() const;
+
+    // The 256-byte ONFI parameter page this device reports.
+    const std::vector<uint8_t>& parameter_page() const { return parameter_page_; }
+
+    // Array contents of one page (data + spare), bypassing the bus.
+    std::vector<uint8_t> array_page(uint32_t row) const;
+
+    // Drop all command state as a power cycle would; the array is kept.
+    void power_cycle();
+
+private:
+    enum class Pending : uint8_t {
+        None,
+        ReadId,
+        ParamPage,
+        UniqueId,
+        GetFeatures,
+        SetFeatures,
+        ReadSetup,
+        ChangeReadColumn,
+        Program,
+        ChangeWriteColumn,
+        Erase,
+        StatusEnhanced,
+        SelectPlane,
+    };
+
+    void command(uint8_t cmd);
+    void address(uint8_t value);
+    void data_in(uint8_t value);
+    void address_complete();
+
+    void stream(const std::vector<uint8_t>& source);
+    uint8_t output_byte() const;
+
+    uint32_t decoded_row(size_t first) const;
+    uint32_t decoded_column() const;
+    uint32_t page_bytes() const { return config_.page_size + config_.spare_size; }
+    uint32_t plane_of(uint32_t row) const;
+    uint32_t lun_of(uint32_t row) const;
+    bool row_in_range(uint32_t row) const;
+    void select_lun(uint32_t lun);
+    bool valid_plane_set(const std::vector<uint32_t>& rows);
+    void load_page(uint32_t row);
+    void cache_read(uint32_t next_row, bool load_next);
+    const std::vector<uint8_t>& read_register() const { return cache_output_ ? cache_register_ : page_register_; }
+    bool program_page(uint32_t row, const std::vector<uint8_t>& data);
+    bool erase_block(uint32_t row);
+    // Program queued planes plus the current page register (10h/15h)
+    void commit_programs();
+    void build_parameter_page();
+
+    NandModelConfig config_;
+    NandModelStats stats_;
+
+    std::unordered_map<uint32_t, std::vector<uint8_t>> array_;
+    std::vector<uint8_t> page_register_;
+    std::vector<uint8_t> cache_register_;
+    std::vector<std::vector<uint8_t>> plane_registers_;
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> queued_programs_;
+    std::vector<uint32_t> queued_reads_;
+    std::vector<uint32_t> queued_erases_;
+    std::vector<uint8_t> parameter_page_;
+    uint8_t unique_id_[16] = {};
+    std::vector<uint8_t> scratch_;
+    uint8_t features_[256][4] = {};
+
+    Pending pending_ = Pending::None;
+    uint8_t address_[8] = {};
+    uint8_t address_count_ = 0;
+    uint8_t feature_address_ = 0;
+    uint8_t feature_count_ = 0;
+
+    uint32_t row_ = 0;
+    uint32_t column_ = 0;
+    bool accepting_data_ = false;
+    bool write_protected_ = false;
+    bool last_failed_ = false;
+    // FAILC: outcome of the program before the last one
+    bool previous_failed_ = false;
+    bool cache_chain_ = false;
+    // Data-out comes from the cache register (cache read in progress)
+    bool cache_output_ = false;
+
+    const std::vector<uint8_t>* out_source_ = nullptr;
+    size_t out_pos_ = 0;
+    bool status_output_ = false;
+    bool driving_ = false;
+    uint8_t out_latch_ = 0;
+
+    uint32_t busy_samples_ = 0;
+    uint32_t array_busy_samples_ = 0;
+    // Busy time left on a suspended program or erase, restored by resume
+    uint32_t suspended_samples_ = 0;
+    bool suspended_ = false;
+    // The busy time belongs to a program or erase
+    bool suspendable_ = false;
+
+    // Per-LUN state; the members above belong to the selected LUN and its slot here
+    // is stale until another LUN is selected.
+    struct LunContext {
+        std::vector<uint8_t> page_register;
+        std::vector<uint8_t> cache_register;
+        std::vector<std::vector<uint8_t>> plane_registers;
+        uint32_t row = 0;
+        uint32_t column = 0;
+        bool last_failed = false;
+        bool previous_failed = false;
+        bool cache_chain = false;
+        bool cache_output = false;
+        size_t out_pos = 0;
+        uint32_t busy_samples = 0;
+        uint32_t array_busy_samples = 0;
+        uint32_t suspended_samples = 0;
+        bool suspended = false;
+        bool suspendable = false;
+    };
+    void swap_context(LunContext& context);
+
+    std::vector<LunContext> luns_;
+    uint32_t selected_lun_ = 0;
+    uint32_t block_bits_ = 0;
+};
+
+// Device attached to register_file() by the libbcm2835 shim.
+NandModel& default_nand_model();
+
+} // namespace sim
+
+#endif // SIM_NAND_MODEL_HPP
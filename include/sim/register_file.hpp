@@ -0,0 +1,101 @@
+#ifndef SIM_REGISTER_FILE_HPP
+#define SIM_REGISTER_FILE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sim {
+
+// Something wired to GPIO bank 0 on the far side of the simulated register file
+// (the NAND model). The register file reports every change of the host-driven pin
+// levels and asks the device which lines it drives on every GPLEV0 load.
+class PinDevice {
+public:
+    virtual ~PinDevice() = default;
+
+    // Host-driven levels changed from `previous` to `current`. `host_outputs` has a
+    // bit set for every bank-0 pin currently in output mode.
+    virtual void on_pins(uint32_t previous, uint32_t current, uint32_t host_outputs) = 0;
+
+    // Called on every GPLEV0 load. Returns the device-driven levels and sets
+    // `driven` to the lines the device is driving.
+    virtual uint32_t on_sample(uint32_t host_levels, uint32_t host_outputs, uint32_t& driven) = 0;
+};
+
+// Several devices on one set of bank-0 lines, e.g. NAND targets with their own CE#.
+// Pin changes reach every device. A line driven by more than one device reads low if
+// any of them pulls it low, the open-drain behaviour of a shared R/B#.
+class PinBus : public PinDevice {
+public:
+    // Throws std::length_error beyond kMaxDevices.
+    void add(PinDevice* device);
+
+    void on_pins(uint32_t previous, uint32_t current, uint32_t host_outputs) override;
+    uint32_t on_sample(uint32_t host_levels, uint32_t host_outputs, uint32_t& driven) override;
+
+private:
+    static constexpr size_t kMaxDevices = 8;
+    PinDevice* devices_[kMaxDevices] = {};
+    size_t count_ = 0;
+};
+
+// Register traffic since the last reset(), for ops-per-byte accounting.
+struct RegisterCounters {
+    uint64_t set_stores = 0;
+    uint64_t clr_stores = 0;
+    uint64_t fsel_stores = 0;
+    uint64_t level_loads = 0;
+    uint64_t other = 0;
+
+    uint64_t total() const { return set_stores + clr_stores + fsel_stores + level_loads + other; }
+    void reset() { *this = RegisterCounters{}; }
+};
+
+// In-memory stand-in for the BCM2835 GPIO register block. Offsets are byte offsets as
+// in bcm2835.h (BCM2835_GPSET0 etc.). Set/clear registers update an output latch;
+// GPLEV0 resolves output latch, pull resistors and device-driven lines.
+class RegisterFile {
+public:
+    static constexpr size_t kWords = 64;
+
+    RegisterFile();
+
+    // Storage the shim exposes as bcm2835_gpio. Only GPFSELn and unmodelled registers
+    // live here; every access must still go through store()/load().
+    volatile uint32_t* base() { return words_; }
+
+    void store(uint32_t offset, uint32_t value);
+    uint32_t load(uint32_t offset);
+
+    // BCM2835_GPIO_PUD_* values
+    void set_pull(uint8_t pin, uint8_t pud);
+
+    void attach(PinDevice* device);
+    PinDevice* device() const { return device_; }
+
+    // Levels the host drives on bank 0 (output latch on outputs, pulls elsewhere).
+    uint32_t host_levels0() const;
+    uint32_t host_outputs0() const { return outputs0_; }
+
+    RegisterCounters& counters() { return counters_; }
+
+private:
+    void refresh_outputs();
+    void notify();
+
+    uint32_t words_[kWords];
+    uint32_t latch0_ = 0;
+    uint32_t latch1_ = 0;
+    uint32_t outputs0_ = 0;
+    uint32_t pull_up0_ = 0;
+    uint32_t last_host_ = 0;
+    PinDevice* device_ = nullptr;
+    RegisterCounters counters_;
+};
+
+// Process-wide register file behind the libbcm2835 shim.
+RegisterFile& register_file();
+
+} // namespace sim
+
+#endif // SIM_REGISTER_FILE_HPP
@@ -0,0 +1,65 @@
+#ifndef STROBE_PACING_H
+#define STROBE_PACING_H
+
+#include <stdint.h>
+#include "timing.hpp"
+
+// Pacing of the bit-banged WE#/RE# strobes to an ONFI asynchronous (SDR) timing mode.
+// The minimum pulse widths of the selected mode are compared with what the strobe
+// loops achieve on their own (measured GPIO store/load cost) and any shortfall is
+// padded with busy_wait_cycles() at four points: WE# low, WE# high, RE# low (before
+// the DQ sample) and RE# high. When the CPU is already slower than the spec every
+// delay is zero and the loops run their unpaced instantiation.
+
+// Minimum (tREA: maximum) asynchronous timings in ns for one ONFI timing mode.
+struct OnfiAsyncTiming {
+    uint8_t mode;
+    uint16_t t_wp;   // WE# pulse width
+    uint16_t t_wh;   // WE# high hold
+    uint16_t t_wc;   // write cycle
+    uint16_t t_ds;   // data setup to WE# high
+    uint16_t t_dh;   // data hold after WE# high
+    uint16_t t_rp;   // RE# pulse width
+    uint16_t t_reh;  // RE# high hold
+    uint16_t t_rc;   // read cycle
+    uint16_t t_rea;  // RE# access time (data valid after RE# low)
+};
+
+// ONFI timing modes 0..5; throws std::out_of_range otherwise.
+const OnfiAsyncTiming& onfi_async_timing(uint8_t mode);
+
+// Measured cost of the primitives the strobe loops are built from.
+struct StrobeCalibration {
+    double ns_per_delay_cycle; // one busy_wait_cycles() iteration
+    double ns_per_store;       // back-to-back GPSET0/GPCLR0 store
+    double ns_per_load;        // GPLEV0 load
+};
+
+// Calibrated once per process on first use; GPIO must be initialised.
+const StrobeCalibration& strobe_calibration();
+
+// busy_wait_cycles() counts inserted at each strobe phase.
+struct StrobePacing {
+    uint8_t mode = 0;
+    uint32_t we_low = 0;
+    uint32_t we_high = 0;
+    uint32_t re_low = 0;
+    uint32_t re_high = 0;
+
+    bool active() const { return (we_low | we_high | re_low | re_high) != 0; }
+};
+
+// Delays needed for `timing` given the loop costs in `calibration`.
+StrobePacing make_strobe_pacing(const OnfiAsyncTiming& timing, const StrobeCalibration& calibration);
+
+// Pads one strobe phase. With Paced == false it compiles to nothing.
+template <bool Paced>
+inline void strobe_delay(uint32_t cycles) {
+    if constexpr (Paced) {
+        if (cycles) busy_wait_cycles(cycles);
+    } else {
+        (void)cycles;
+    }
+}
+
+#endif // STROBE_PACING_H
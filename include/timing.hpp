@@ -3,6 +3,12 @@
 
 #include <stdint.h>
 
+// Timestamps come from the architectural counter (CNTVCT_EL0 on AArch64, an invariant
+// TSC on x86 for off-target runs), calibrated once against CLOCK_MONOTONIC_RAW on first
+// use and converted with a fixed-point multiplier. Values share the CLOCK_MONOTONIC_RAW
+// epoch. When no usable counter exists, or ONFI_TIMEBASE=clock is set, every read falls
+// back to clock_gettime(CLOCK_MONOTONIC_RAW).
+
 // Get the current timestamp in nanoseconds
 uint64_t get_timestamp_ns();
 
@@ -12,8 +18,14 @@ void busy_wait_ns(uint64_t ns);
 // Busy-wait for a specific number of cycles.
 void busy_wait_cycles(uint32_t cycles);
 
+struct TimebaseInfo {
+    const char* source;      // "cntvct", "tsc" or "clock_gettime"
+    uint64_t frequency_hz;   // counter frequency (1e9 for the clock_gettime fallback)
+    double resolution_ns;    // one counter tick, or clock_getres() for the fallback
+    double read_cost_ns;     // measured cost of one get_timestamp_ns() call
+};
 
-
-
+// Calibration result of the active timebase (calibrates on first call).
+const TimebaseInfo& timebase_info();
 
 #endif // TIMING_H
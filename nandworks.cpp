@@ -1,10 +1,15 @@
 #include "nandworks/cli_parser.hpp"
 #include "nandworks/command_context.hpp"
 #include "nandworks/command_registry.hpp"
+#include "nandworks/commands/batch.hpp"
 #include "nandworks/commands/onfi.hpp"
 #include "nandworks/commands/script.hpp"
+#include "nandworks/commands/serve.hpp"
+#include "nandworks/daemon.hpp"
 #include "nandworks/driver_context.hpp"
 
+#include <climits>
+#include <cstdlib>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
@@ -23,9 +28,10 @@ constexpr const char* kDriverVersion = "0.3.0-dev";
 
 void print_global_help(const nandworks::CommandRegistry& registry, std::ostream& out, bool verbose) {
     out << kDriverBanner << " (" << kDriverVersion << ")" << (verbose ? " [verbose]" : "") << "\n";
-    out << "Usage: nandworks [--verbose] <command> [options]\n";
+    out << "Usage: nandworks [--verbose] [--no-daemon] <command> [options]\n";
     out << "       nandworks --help\n";
-    out << "       nandworks help <command>\n\n";
+    out << "       nandworks help <command>\n";
+    out << "Commands that need a session run in a 'nandworks serve' daemon when one is listening.\n\n";
     out << "Commands:\n";
     for (const auto& command : registry.commands()) {
         out << "  " << command.name;
@@ -109,6 +115,7 @@ int main(int argc, char** argv) {
     bool verbose = false;
     bool global_help = false;
     bool list_commands = false;
+    bool no_daemon = std::getenv("NANDWORKS_NO_DAEMON") != nullptr;
     std::string command_name;
     std::vector<std::string> raw_args;
 
@@ -122,6 +129,10 @@ int main(int argc, char** argv) {
             global_help = true;
             continue;
         }
+        if (arg == "--no-daemon" && command_name.empty()) {
+            no_daemon = true;
+            continue;
+        }
         if (arg == "--list-commands" && command_name.empty()) {
             list_commands = true;
             continue;
@@ -137,6 +148,8 @@ int main(int argc, char** argv) {
     register_builtin_commands(registry);
     nandworks::commands::register_script_commands(registry);
     nandworks::commands::register_onfi_commands(registry);
+    nandworks::commands::register_serve_commands(registry);
+    nandworks::commands::register_batch_commands(registry);
 
     if ((global_help || list_commands) && command_name.empty()) {
         print_global_help(registry, std::cout, verbose);
@@ -169,12 +182,28 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    // A running daemon already holds the session (and root); hand the command over
+    if (command->requires_session && !no_daemon) {
+        const int fd = nandworks::connect_daemon(nandworks::daemon_socket_path());
+        if (fd >= 0) {
+            nandworks::DaemonRequest request;
+            char cwd[PATH_MAX];
+            if (::getcwd(cwd, sizeof(cwd)) != nullptr) request.cwd = cwd;
+            request.verbose = verbose;
+            request.command = command->name;
+            request.args = raw_args;
+            return nandworks::forward_command(fd, request, std::cout, std::cerr);
+        }
+    }
+
     if (command->requires_root && !is_root_user()) {
         std::cerr << "Command '" << command->name << "' requires root privileges. Please rerun with sudo." << "\n";
         return 5;
     }
 
     nandworks::DriverContext driver(verbose);
+    // Also seen by `batch`, which decides per line
+    driver.set_forward_to_daemon(!no_daemon);
 
     nandworks::CommandContext context{registry, driver, *command, std::move(parsed.arguments), std::cout, std::cerr, verbose, parsed.force, parsed.help_requested};
 
@@ -0,0 +1,50 @@
+#include "dq_bus.hpp"
+
+namespace {
+    constexpr uint8_t kDqPins[] = {
+        GPIO_DQ0, GPIO_DQ1, GPIO_DQ2, GPIO_DQ3,
+        GPIO_DQ4, GPIO_DQ5, GPIO_DQ6, GPIO_DQ7,
+    };
+
+    constexpr uint32_t kWeMask = static_cast<uint32_t>(1u) << GPIO_WE;
+
+    static_assert((BoardDqMap::all_mask & kWeMask) == 0, "WE# must not share a DQ line");
+
+    const GpioFselImage dq_fsel_input = gpio_make_fsel_image(kDqPins, sizeof(kDqPins), false);
+    const GpioFselImage dq_fsel_output = gpio_make_fsel_image(kDqPins, sizeof(kDqPins), true);
+}
+
+const GpioFselImage& dq_fsel_image(bool is_output) {
+    return is_output ? dq_fsel_output : dq_fsel_input;
+}
+
+void dq_decode_levels(const uint32_t* levels, size_t count, uint8_t* out) {
+    BoardDqCodec::decode_levels(levels, count, out);
+}
+
+void dq_decode_levels_scalar(const uint32_t* levels, size_t count, uint8_t* out) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = BoardDqMap::gather(levels[i]);
+    }
+}
+
+void dq_build_data_in_burst(const uint8_t* data, size_t count, std::vector<DqBurstWord>& out) {
+    out.resize(count);
+    DqBurstWord* words = out.data();
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t ones = dq_set_mask(data[i]);
+        words[i].clr = kWeMask | (dq_all_mask() & ~ones);
+        words[i].set = ones;
+    }
+}
+
+void dq_trace_data_in_reference(const uint8_t* data, size_t count, GpioWriteTrace& trace) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t value = BoardDqMap::spread(data[i]);
+        trace.clr(kWeMask);
+        // bcm2835_gpio_write_mask(value, mask) is a set of (value & mask) then a clear of (~value & mask)
+        trace.set(value & dq_all_mask());
+        trace.clr(~value & dq_all_mask());
+        trace.set(kWeMask);
+    }
+}
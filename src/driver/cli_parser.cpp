@@ -4,6 +4,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <unordered_map>
+#include <utility>
 
 namespace nandworks {
 
@@ -177,6 +178,56 @@ ParsedCommand parse_command_arguments(const Command& command, const std::vector<
     return parsed;
 }
 
+std::vector<std::string> split_command_line(const std::string& line) {
+    std::vector<std::string> words;
+    std::string word;
+    bool in_word = false;
+
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        const char ch = line[i];
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+            if (in_word) {
+                words.push_back(std::move(word));
+                word.clear();
+                in_word = false;
+            }
+            continue;
+        }
+        if (ch == '#' && !in_word) {
+            break;
+        }
+        in_word = true;
+        if (ch == '\\') {
+            if (++i == line.size()) {
+                throw std::invalid_argument("Trailing backslash");
+            }
+            word.push_back(line[i]);
+        } else if (ch == '\'') {
+            const std::size_t end = line.find('\'', i + 1);
+            if (end == std::string::npos) {
+                throw std::invalid_argument("Unterminated single quote");
+            }
+            word.append(line, i + 1, end - i - 1);
+            i = end;
+        } else if (ch == '"') {
+            for (++i;; ++i) {
+                if (i == line.size()) {
+                    throw std::invalid_argument("Unterminated double quote");
+                }
+                if (line[i] == '"') break;
+                if (line[i] == '\\' && i + 1 < line.size() && (line[i + 1] == '"' || line[i + 1] == '\\')) ++i;
+                word.push_back(line[i]);
+            }
+        } else {
+            word.push_back(ch);
+        }
+    }
+    if (in_word) {
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+
 void print_command_usage(const Command& command, std::ostream& out) {
     out << "Usage: " << command.usage << "\n";
     if (!command.summary.empty()) {
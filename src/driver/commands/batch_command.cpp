@@ -0,0 +1,198 @@
+#include "nandworks/commands/batch.hpp"
+
+#include "nandworks/cli_parser.hpp"
+#include "nandworks/command_context.hpp"
+#include "nandworks/daemon.hpp"
+#include "nandworks/dispatch.hpp"
+#include "nandworks/driver_context.hpp"
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace nandworks::commands {
+namespace {
+
+void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (const char ch : text) {
+        const unsigned char byte = static_cast<unsigned char>(ch);
+        switch (ch) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                // Bytes outside printable ASCII map to U+0000..U+00FF, so binary output survives
+                if (byte < 0x20 || byte >= 0x7F) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", byte);
+                    out << escaped;
+                } else {
+                    out << ch;
+                }
+        }
+    }
+    out << '"';
+}
+
+struct LineResult {
+    std::size_t line = 0;
+    std::string command;
+    int status = 0;
+    uint64_t elapsed_us = 0;
+};
+
+int run_line(const CommandContext& context,
+             const std::vector<std::string>& words,
+             bool use_daemon,
+             std::ostream& out,
+             std::ostream& err) {
+    const std::string& name = words.front();
+    const std::vector<std::string> args(words.begin() + 1, words.end());
+    const Command* command = context.registry.find(name);
+    if (command != nullptr && (command->name == "batch" || command->name == "serve")) {
+        err << "Command '" << command->name << "' cannot run inside a batch.\n";
+        return 2;
+    }
+
+    // Keep the daemon as the only owner of the bus while it is listening
+    if (use_daemon && command != nullptr && command->requires_session) {
+        const int fd = connect_daemon(daemon_socket_path());
+        if (fd >= 0) {
+            DaemonRequest request;
+            char cwd[PATH_MAX];
+            if (::getcwd(cwd, sizeof(cwd)) != nullptr) request.cwd = cwd;
+            request.verbose = context.verbose;
+            request.command = command->name;
+            request.args = args;
+            return forward_command(fd, request, out, err);
+        }
+    }
+    return dispatch_command(context.registry, context.driver, name, args, context.verbose, out, err);
+}
+
+int batch_command(const CommandContext& context) {
+    const std::string source = context.arguments.positional_count() > 0 ? context.arguments.positional(0) : "-";
+    const bool json = context.arguments.has("json");
+    const bool keep_going = context.arguments.has("continue-on-error");
+
+    std::ifstream file;
+    if (source != "-") {
+        file.open(source);
+        if (!file) {
+            throw std::runtime_error("Cannot open batch file '" + source + "'");
+        }
+    }
+    std::istream& input = (source == "-") ? std::cin : file;
+
+    bool use_daemon = context.driver.forwards_to_daemon();
+    if (use_daemon) {
+        const int probe = connect_daemon(daemon_socket_path());
+        use_daemon = probe >= 0;
+        if (probe >= 0) ::close(probe);
+    }
+
+    std::size_t executed = 0;
+    std::size_t failed = 0;
+    int first_failure = 0;
+    std::size_t line_number = 0;
+    std::string line;
+    while (std::getline(input, line)) {
+        ++line_number;
+
+        LineResult result;
+        result.line = line_number;
+        std::ostringstream captured_out;
+        std::ostringstream captured_err;
+        std::ostream& out = json ? static_cast<std::ostream&>(captured_out) : context.out;
+        std::ostream& err = json ? static_cast<std::ostream&>(captured_err) : context.err;
+
+        std::vector<std::string> words;
+        try {
+            words = split_command_line(line);
+        } catch (const std::exception& ex) {
+            err << "Argument error: " << ex.what() << "\n";
+            result.status = 3;
+        }
+        if (words.empty() && result.status == 0) {
+            continue;
+        }
+        if (!words.empty()) {
+            result.command = words.front();
+            const auto start = std::chrono::steady_clock::now();
+            result.status = run_line(context, words, use_daemon, out, err);
+            result.elapsed_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+
+        ++executed;
+        if (result.status != 0) {
+            ++failed;
+            if (first_failure == 0) first_failure = result.status;
+        }
+
+        if (json) {
+            context.out << "{\"line\":" << result.line << ",\"command\":";
+            write_json_string(context.out, result.command);
+            context.out << ",\"status\":" << result.status
+                        << ",\"elapsed_us\":" << result.elapsed_us
+                        << ",\"stdout\":";
+            write_json_string(context.out, captured_out.str());
+            context.out << ",\"stderr\":";
+            write_json_string(context.out, captured_err.str());
+            context.out << "}" << std::endl;
+        } else {
+            context.out.flush();
+            context.err << "[batch:" << result.line << "] " << result.command << " -> " << result.status << std::endl;
+        }
+
+        if (result.status != 0 && !keep_going) {
+            break;
+        }
+    }
+
+    if (!json) {
+        context.err << "Batch: " << executed << " commands, " << failed << " failed." << "\n";
+    }
+    return first_failure;
+}
+
+} // namespace
+
+void register_batch_commands(CommandRegistry& registry) {
+    registry.register_command({
+        .name = "batch",
+        .aliases = {"pipe"},
+        .summary = "Run newline-delimited nandworks commands in one process.",
+        .description = "Reads one command per line from a file or stdin ('-') and runs each against a single "
+                       "session, so the device is brought up once. Lines are split shell style; blank lines and "
+                       "# comments are skipped. Execution stops at the first failing line unless "
+                       "--continue-on-error is given, and the exit status is that of the first failure. With "
+                       "--json each line yields one JSON object with its status, elapsed time and captured "
+                       "output. Commands are forwarded to a running 'nandworks serve' daemon when one is listening.",
+        .usage = "nandworks batch [--continue-on-error] [--json] [file|-]",
+        .options = {
+            OptionSpec{"continue-on-error", 'k', false, false, false, "", "Keep running after a line fails."},
+            OptionSpec{"json", 'j', false, false, false, "", "Emit one JSON Lines result per command instead of raw output."}
+        },
+        .min_positionals = 0,
+        .max_positionals = 1,
+        .safety = CommandSafety::Safe,
+        .requires_session = false,
+        .requires_root = false,
+        .handler = batch_command,
+    });
+}
+
+} // namespace nandworks::commands
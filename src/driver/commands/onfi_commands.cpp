@@ -3,6 +3,7 @@
 #include "nandworks/command_context.hpp"
 #include "nandworks/driver_context.hpp"
 #include "gpio.hpp"
+#include "onfi/bad_block_table.hpp"
 #include "onfi/controller.hpp"
 #include "onfi/device.hpp"
 #include "onfi/device_config.hpp"
@@ -36,6 +37,7 @@ struct GeometrySummary {
     uint32_t spare_bytes = 0;
     uint32_t pages_per_block = 0;
     uint32_t blocks = 0;
+    uint32_t luns = 1;
 };
 
 GeometrySummary summarize_geometry(const onfi_interface& onfi) {
@@ -44,6 +46,7 @@ GeometrySummary summarize_geometry(const onfi_interface& onfi) {
     summary.spare_bytes = onfi.num_spare_bytes_in_page;
     summary.pages_per_block = onfi.num_pages_in_block;
     summary.blocks = onfi.num_blocks;
+    summary.luns = onfi.num_luns;
     return summary;
 }
 
@@ -145,30 +148,63 @@ void ensure_page_in_range(const onfi_interface& onfi, int64_t page) {
     }
 }
 
-std::vector<uint8_t> read_parameter_page(onfi_interface& onfi, param_type type, bool bytewise) {
-    while (gpio_read(GPIO_RB) == 0) {
-    }
-
-    uint8_t address = (type == param_type::JEDEC) ? 0x40 : 0x00;
-    onfi.send_command(0xEC);
-    onfi.send_addresses(&address);
+// Bytes of a page picked by --column/--length/--spare-only (spare columns follow the
+// main area). --length defaults to the end of the main area, or of the spare when the
+// range starts there or `include_spare` is set.
+struct PageRange {
+    uint32_t column = 0;
+    uint32_t length = 0;
+};
 
-    while (gpio_read(GPIO_RB) == 0) {
-    }
+bool has_page_range_options(const CommandContext& context) {
+    return context.arguments.has("column") || context.arguments.has("length") || context.arguments.has("spare-only");
+}
 
-    std::vector<uint8_t> buffer(256, 0xFF);
-    if (!bytewise) {
-        onfi.get_data(buffer.data(), static_cast<uint16_t>(buffer.size()));
+// Without --length the range runs to the end of the readable area, or covers
+// `default_length` bytes when that is nonzero (a --spare-only range always runs to the end).
+PageRange page_range_option(const CommandContext& context, const onfi_interface& onfi,
+                            bool include_spare, uint32_t default_column = 0, uint32_t default_length = 0) {
+    const uint32_t main_bytes = onfi.num_bytes_in_page;
+    const uint32_t end = main_bytes + onfi.num_spare_bytes_in_page;
+    PageRange range;
+    if (context.arguments.has("spare-only")) {
+        if (context.arguments.has("column")) {
+            throw std::invalid_argument("--spare-only cannot be combined with --column");
+        }
+        range.column = main_bytes;
     } else {
-        uint8_t col[2] = {0, 0};
-        for (std::size_t idx = 0; idx < buffer.size(); ++idx) {
-            col[1] = static_cast<uint8_t>(idx / 256U);
-            col[0] = static_cast<uint8_t>(idx % 256U);
-            onfi.change_read_column(col);
-            onfi.get_data(&buffer[idx], 1);
+        const int64_t column = context.arguments.value_as_int("column", default_column);
+        if (column < 0 || column >= end) {
+            throw std::invalid_argument("Column out of range");
         }
+        range.column = static_cast<uint32_t>(column);
     }
-    return buffer;
+    const uint32_t limit = (include_spare || range.column >= main_bytes) ? end : main_bytes;
+    const bool to_end = default_length == 0 || context.arguments.has("spare-only");
+    const int64_t length = context.arguments.value_as_int("length", to_end ? limit - range.column : default_length);
+    if (length <= 0 || range.column + length > end) {
+        throw std::invalid_argument("Length out of range");
+    }
+    range.length = static_cast<uint32_t>(length);
+    return range;
+}
+
+// --chunk: bytes read between column changes of a --bytewise transfer (default 1).
+uint32_t bytewise_chunk_option(const CommandContext& context) {
+    if (!context.arguments.has("chunk")) return 1;
+    if (!context.arguments.has("bytewise")) {
+        throw std::invalid_argument("--chunk requires --bytewise");
+    }
+    const int64_t chunk = context.arguments.require_int("chunk");
+    if (chunk <= 0 || chunk > 0xFFFF) {
+        throw std::invalid_argument("--chunk must be between 1 and 65535");
+    }
+    return static_cast<uint32_t>(chunk);
+}
+
+// Bring the session up as far as the command declared (Command::session_level)
+onfi_interface& require_session(const CommandContext& context) {
+    return context.driver.require_session(context.command.session_level);
 }
 
 void print_byte_table(std::ostream& out, const std::vector<uint8_t>& data) {
@@ -292,12 +328,13 @@ int probe_command(const CommandContext& context) {
     context.out << "  Spare bytes: " << g.spare_bytes << "\n";
     context.out << "  Pages per block: " << g.pages_per_block << "\n";
     context.out << "  Blocks: " << g.blocks << "\n";
+    context.out << "  LUNs: " << g.luns << "\n";
     context.out << "Interface: " << (onfi.interface_type == asynchronous ? "asynchronous" : "toggle") << "\n";
     return 0;
 }
 
 int read_id_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     if (context.arguments.has("refresh")) {
         onfi.read_id();
     }
@@ -310,7 +347,7 @@ int read_id_command(const CommandContext& context) {
 }
 
 int status_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const uint8_t status = onfi.get_status();
 
     context.out << "Status: 0x" << std::hex << std::setw(2) << std::setfill('0')
@@ -329,13 +366,17 @@ int status_command(const CommandContext& context) {
 }
 
 int read_parameters_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const bool use_jedec = context.arguments.has("jedec");
     const bool bytewise = context.arguments.has("bytewise");
+    const uint32_t chunk = bytewise_chunk_option(context);
     param_type type = use_jedec ? param_type::JEDEC : param_type::ONFI;
 
-    onfi.read_parameters(type, bytewise, context.verbose);
-    auto buffer = read_parameter_page(onfi, type, bytewise);
+    onfi.read_parameters(type, bytewise, context.verbose, chunk);
+    const std::vector<uint8_t> buffer(std::begin(onfi.parameter_page), std::end(onfi.parameter_page));
+    if (type == param_type::ONFI) {
+        context.out << "CRC-16: " << (onfi.parameter_page_crc_ok ? "ok" : "mismatch in every copy") << "\n";
+    }
 
     if (context.arguments.has("raw")) {
         print_byte_table(context.out, buffer);
@@ -355,11 +396,12 @@ int read_parameters_command(const CommandContext& context) {
     context.out << "  Spare bytes: " << g.spare_bytes << "\n";
     context.out << "  Pages per block: " << g.pages_per_block << "\n";
     context.out << "  Blocks: " << g.blocks << "\n";
+    context.out << "  LUNs: " << g.luns << "\n";
     return 0;
 }
 
 int read_page_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     const int64_t page = context.arguments.require_int("page");
     if (block < 0 || block >= onfi.num_blocks) {
@@ -374,11 +416,20 @@ int read_page_command(const CommandContext& context) {
     onfi::OnfiController controller(onfi);
     onfi::NandDevice device(controller);
     configure_device(onfi, device);
+    device.bytewise_chunk = bytewise_chunk_option(context);
 
-    std::vector<uint8_t> buffer;
-    device.read_page(static_cast<unsigned int>(block), static_cast<unsigned int>(page), include_spare, bytewise, buffer);
+    const PageRange range = page_range_option(context, onfi, include_spare);
+    std::vector<uint8_t> buffer(range.length, 0xFF);
+    device.read_range(static_cast<unsigned int>(block), static_cast<unsigned int>(page),
+                      range.column, range.length, buffer.data(), bytewise);
 
     if (auto output = context.arguments.value("output")) {
+        // "-" streams the raw bytes to stdout (through the daemon socket when forwarded)
+        if (*output == "-") {
+            context.out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            context.out.flush();
+            return 0;
+        }
         if (!write_file(*output, buffer)) {
             context.err << "Failed to write page to '" << *output << "'\n";
             return 1;
@@ -391,7 +442,7 @@ int read_page_command(const CommandContext& context) {
 }
 
 int program_page_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     const int64_t page = context.arguments.require_int("page");
     if (block < 0 || block >= onfi.num_blocks) {
@@ -424,7 +475,7 @@ int program_page_command(const CommandContext& context) {
     configure_device(onfi, device);
 
     device.program_page(static_cast<unsigned int>(block), static_cast<unsigned int>(page), payload.data(), include_spare);
-    onfi.wait_ready_blocking();
+    onfi.wait_ready_op(RbWaitOp::Program);
     const uint8_t status = onfi.get_status();
     if (status & 0x01) {
         context.err << "Program operation failed (status=0x" << std::hex << std::setw(2) << std::setfill('0')
@@ -447,7 +498,7 @@ int program_page_command(const CommandContext& context) {
 }
 
 int erase_block_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     if (block < 0 || block >= onfi.num_blocks) {
         throw std::invalid_argument("Block index out of range");
@@ -458,7 +509,7 @@ int erase_block_command(const CommandContext& context) {
     configure_device(onfi, device);
 
     device.erase_block(static_cast<unsigned int>(block));
-    onfi.wait_ready_blocking();
+    onfi.wait_ready_op(RbWaitOp::Erase);
     const uint8_t status = onfi.get_status();
     if (status & 0x01) {
         context.err << "Erase failed (status=0x" << std::hex << std::setw(2) << std::setfill('0')
@@ -474,7 +525,7 @@ int erase_block_command(const CommandContext& context) {
 
 
 int read_block_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     ensure_block_in_range(onfi, block);
     const bool include_spare = context.arguments.has("include-spare");
@@ -492,10 +543,15 @@ int read_block_command(const CommandContext& context) {
     onfi::OnfiController controller(onfi);
     onfi::NandDevice device(controller);
     configure_device(onfi, device);
+    device.bytewise_chunk = bytewise_chunk_option(context);
 
     std::unique_ptr<onfi::DataSink> sink;
     if (auto output = context.arguments.value("output")) {
-        sink = std::make_unique<onfi::FileDataSink>(output->c_str());
+        if (*output == "-") {
+            sink = std::make_unique<onfi::OstreamDataSink>(context.out);
+        } else {
+            sink = std::make_unique<onfi::FileDataSink>(output->c_str());
+        }
     } else {
         sink = std::make_unique<onfi::HexOstreamDataSink>(context.out);
     }
@@ -512,9 +568,14 @@ int read_block_command(const CommandContext& context) {
 }
 
 int program_block_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     ensure_block_in_range(onfi, block);
+    const int64_t count = context.arguments.value_as_int("count", 1);
+    if (count <= 0) {
+        throw std::invalid_argument("Count must be positive");
+    }
+    ensure_block_in_range(onfi, block + count - 1);
     const bool include_spare = context.arguments.has("include-spare");
     const bool randomize = context.arguments.has("random");
     const bool pad = context.arguments.has("pad");
@@ -554,16 +615,20 @@ int program_block_command(const CommandContext& context) {
     onfi::NandDevice device(controller);
     configure_device(onfi, device);
 
-    device.program_block(static_cast<unsigned int>(block),
-                         complete,
-                         pages.empty() ? nullptr : pages.data(),
-                         static_cast<uint16_t>(pages.size()),
-                         payload_ptr,
-                         include_spare,
-                         randomize);
-    onfi.wait_ready_blocking();
+    // Several blocks program each page in one multi-plane operation per plane group
+    std::vector<unsigned int> blocks(static_cast<size_t>(count));
+    for (int64_t offset = 0; offset < count; ++offset) blocks[offset] = static_cast<unsigned int>(block + offset);
+    const bool programmed = device.program_blocks(blocks.data(),
+                                                  blocks.size(),
+                                                  complete,
+                                                  pages.empty() ? nullptr : pages.data(),
+                                                  static_cast<uint16_t>(pages.size()),
+                                                  payload_ptr,
+                                                  include_spare,
+                                                  randomize);
+    onfi.wait_ready_op(RbWaitOp::Program);
     const uint8_t status = onfi.get_status();
-    if (status & 0x01) {
+    if (!programmed || (status & 0x01)) {
         context.err << "Program block failed (status=0x" << std::hex << std::setw(2) << std::setfill('0')
                     << static_cast<int>(status) << std::dec << std::setfill(' ') << ")\n";
         return 1;
@@ -572,17 +637,19 @@ int program_block_command(const CommandContext& context) {
     if (verify) {
         const uint8_t* expected_ptr = payload_ptr;
         const char* verification_label = payload_ptr ? "with provided pattern" : "with default pattern";
-        const bool ok = device.verify_program_block(static_cast<unsigned int>(block),
-                                                    complete,
-                                                    pages.empty() ? nullptr : pages.data(),
-                                                    static_cast<uint16_t>(pages.size()),
-                                                    expected_ptr,
-                                                    include_spare,
-                                                    context.verbose,
-                                                    /*max_allowed_errors*/0);
-        if (!ok) {
-            context.err << "Verification failed " << verification_label << "." << "\n";
-            return 2;
+        for (unsigned int target : blocks) {
+            const bool ok = device.verify_program_block(target,
+                                                        complete,
+                                                        pages.empty() ? nullptr : pages.data(),
+                                                        static_cast<uint16_t>(pages.size()),
+                                                        expected_ptr,
+                                                        include_spare,
+                                                        context.verbose,
+                                                        /*max_allowed_errors*/0);
+            if (!ok) {
+                context.err << "Verification failed " << verification_label << " (block " << target << ")." << "\n";
+                return 2;
+            }
         }
     }
 
@@ -590,8 +657,70 @@ int program_block_command(const CommandContext& context) {
     return 0;
 }
 
+int copy_block_command(const CommandContext& context) {
+    auto& onfi = require_session(context);
+    const int64_t source = context.arguments.require_int("from");
+    const int64_t destination = context.arguments.require_int("to");
+    ensure_block_in_range(onfi, source);
+    ensure_block_in_range(onfi, destination);
+    if (source == destination) {
+        throw std::invalid_argument("--from and --to must name different blocks");
+    }
+
+    const auto pages_option = context.arguments.value("pages");
+    const bool complete = !pages_option.has_value();
+    std::vector<uint16_t> pages;
+    if (pages_option) {
+        pages = parse_page_list(*pages_option, onfi.num_pages_in_block);
+        if (pages.empty()) {
+            throw std::invalid_argument("--pages must specify at least one page index");
+        }
+    }
+
+    // Spare bytes written over every copied page from the start of the spare area
+    std::vector<uint8_t> spare;
+    onfi::ColumnPatch patch;
+    if (auto input = context.arguments.value("spare-input")) {
+        spare = read_file(*input);
+        if (spare.empty() || spare.size() > onfi.num_spare_bytes_in_page) {
+            throw std::runtime_error("Spare input must hold 1 to " + std::to_string(onfi.num_spare_bytes_in_page) + " bytes");
+        }
+        patch.column = onfi.num_bytes_in_page;
+        patch.data = spare.data();
+        patch.length = static_cast<uint16_t>(spare.size());
+    }
+
+    onfi::OnfiController controller(onfi);
+    onfi::NandDevice device(controller);
+    configure_device(onfi, device);
+
+    if (context.arguments.has("erase")) {
+        device.erase_block(static_cast<unsigned int>(destination));
+        if (onfi.get_status() & 0x01) {
+            context.err << "Erase of destination block failed." << "\n";
+            return 1;
+        }
+    }
+
+    const bool copied = device.copy_block(static_cast<unsigned int>(source),
+                                          static_cast<unsigned int>(destination),
+                                          complete,
+                                          pages.empty() ? nullptr : pages.data(),
+                                          static_cast<uint16_t>(pages.size()),
+                                          spare.empty() ? nullptr : &patch,
+                                          spare.empty() ? 0 : 1);
+    if (!copied) {
+        context.err << "Copy block failed." << "\n";
+        return 1;
+    }
+    const bool on_chip = device.capabilities.copyback() &&
+                         device.plane_of(static_cast<unsigned int>(source)) == device.plane_of(static_cast<unsigned int>(destination));
+    context.out << "Copy block successful (" << (on_chip ? "copyback" : "through host") << ")." << "\n";
+    return 0;
+}
+
 int measure_erase_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     ensure_block_in_range(onfi, block);
     const bool json = context.arguments.has("json");
@@ -624,7 +753,7 @@ int measure_erase_command(const CommandContext& context) {
 }
 
 int measure_program_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     ensure_block_in_range(onfi, block);
     const int64_t page = context.arguments.require_int("page");
@@ -686,7 +815,7 @@ int measure_program_command(const CommandContext& context) {
 }
 
 int measure_read_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     ensure_block_in_range(onfi, block);
     const int64_t page = context.arguments.require_int("page");
@@ -759,20 +888,20 @@ int measure_read_command(const CommandContext& context) {
 }
 
 int verify_page_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     const int64_t page = context.arguments.require_int("page");
     ensure_block_in_range(onfi, block);
     ensure_page_in_range(onfi, page);
     const bool include_spare = context.arguments.has("include-spare");
+    const PageRange range = page_range_option(context, onfi, include_spare);
 
     std::vector<uint8_t> expected;
     const uint8_t* expected_ptr = nullptr;
     if (auto input = context.arguments.value("input")) {
         expected = read_file(*input);
-        const std::size_t expected_len = onfi.num_bytes_in_page + (include_spare ? onfi.num_spare_bytes_in_page : 0);
-        if (expected.size() != expected_len) {
-            throw std::runtime_error("Expected data length must match page length including spare selection");
+        if (expected.size() != range.length) {
+            throw std::runtime_error("Expected data length must match the selected page range");
         }
         expected_ptr = expected.data();
     }
@@ -783,21 +912,21 @@ int verify_page_command(const CommandContext& context) {
 
     uint32_t byte_errors = 0;
     uint32_t bit_errors = 0;
-    const bool ok = device.verify_program_page(static_cast<unsigned int>(block),
-                                               static_cast<unsigned int>(page),
-                                               expected_ptr,
-                                               include_spare,
-                                               context.verbose,
-                                               0,
-                                               &byte_errors,
-                                               &bit_errors);
+    const bool ok = device.verify_range(static_cast<unsigned int>(block),
+                                        static_cast<unsigned int>(page),
+                                        range.column,
+                                        range.length,
+                                        expected_ptr,
+                                        0,
+                                        &byte_errors,
+                                        &bit_errors);
     context.out << "Byte errors: " << byte_errors << ", bit errors: " << bit_errors << "\n";
     context.out << (ok ? "Verification passed." : "Verification failed.") << "\n";
     return ok ? 0 : 1;
 }
 
 int verify_block_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t block = context.arguments.require_int("block");
     ensure_block_in_range(onfi, block);
     const bool include_spare = context.arguments.has("include-spare");
@@ -839,7 +968,7 @@ int verify_block_command(const CommandContext& context) {
 }
 
 int erase_chip_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     int64_t start = context.arguments.value_as_int("start", 0);
     int64_t count = context.arguments.value_as_int("count", onfi.num_blocks - start);
     if (start < 0 || start >= onfi.num_blocks) {
@@ -856,48 +985,108 @@ int erase_chip_command(const CommandContext& context) {
     onfi::NandDevice device(controller);
     configure_device(onfi, device);
 
-    for (int64_t offset = 0; offset < count; ++offset) {
-        const unsigned int block = static_cast<unsigned int>(start + offset);
-        context.out << "Erasing block " << block << "..." << std::flush;
-        device.erase_block(block);
-        onfi.wait_ready_blocking();
-        const uint8_t status = onfi.get_status();
-        if (status & 0x01) {
+    // The device groups blocks on different planes into one erase when it supports it
+    std::vector<unsigned int> blocks(static_cast<size_t>(count));
+    for (int64_t offset = 0; offset < count; ++offset) blocks[offset] = static_cast<unsigned int>(start + offset);
+    const bool keep_going = context.arguments.has("continue");
+    const auto report = [&](const onfi::EraseGroup& group) {
+        context.out << (group.blocks.size() == 1 ? "Erasing block " : "Erasing blocks ");
+        for (size_t i = 0; i < group.blocks.size(); ++i) {
+            context.out << (i ? ", " : "") << group.blocks[i];
+        }
+        context.out << "...";
+        if (group.failed()) {
             context.out << " failed (status=0x" << std::hex << std::setw(2) << std::setfill('0')
-                        << static_cast<int>(status) << std::dec << std::setfill(' ') << ")" << std::endl;
-            return 1;
+                        << static_cast<int>(group.status) << std::dec << std::setfill(' ') << ")" << std::endl;
+        } else {
+            context.out << " done" << std::endl;
         }
-        context.out << " done" << std::endl;
+    };
+    const auto failures = device.erase_blocks(blocks.data(), blocks.size(), keep_going, report);
+    if (failures.empty()) return 0;
+    if (keep_going) {
+        context.out << "Erase failed for blocks";
+        const char* separator = " ";
+        for (const auto& group : failures) {
+            for (unsigned int block : group.blocks) {
+                context.out << separator << block;
+                separator = ", ";
+            }
+        }
+        context.out << std::endl;
     }
-    return 0;
+    return 1;
 }
 
 int scan_bad_blocks_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
+    onfi::OnfiController controller(onfi);
+    onfi::NandDevice device(controller);
+    configure_device(onfi, device);
+    const bool rescan = context.arguments.has("rescan");
+    const auto* id = reinterpret_cast<const uint8_t*>(onfi.unique_id);
+
+    // A custom range marks the block bad if any byte is 00h; it is never persisted. A bare
+    // --column is one marker byte, not everything up to the end of the spare area.
+    const bool custom = has_page_range_options(context);
+    const PageRange range = custom ? page_range_option(context, onfi, true, onfi.num_bytes_in_page, 1) : PageRange{};
+    std::vector<uint8_t> marker(range.length);
+    const auto is_bad = [&](unsigned int block) {
+        device.read_range(block, 0, range.column, range.length, marker.data());
+        return std::find(marker.begin(), marker.end(), 0x00) != marker.end();
+    };
+
     if (context.arguments.has("block")) {
         const int64_t block = context.arguments.require_int("block");
         ensure_block_in_range(onfi, block);
-        const bool bad = onfi.is_bad_block(static_cast<unsigned int>(block));
+        const auto index = static_cast<unsigned int>(block);
+        bool bad = false;
+        if (custom) {
+            bad = is_bad(index);
+        } else if (!rescan && device.bad_blocks.load(onfi::bad_block_table_path(id),
+                                                       device.geometry.blocks_per_lun * device.luns())) {
+            bad = device.is_bad(index);
+        } else {
+            // One block is cheaper to probe than a table is to build
+            bad = device.is_bad_block(index);
+        }
         context.out << "Block " << block << (bad ? " is bad" : " is good") << "\n";
         return bad ? 1 : 0;
     }
 
-    context.out << "Scanning for bad blocks..." << std::endl;
-    bool any_bad = false;
-    for (uint32_t block = 0; block < onfi.num_blocks; ++block) {
-        if (onfi.is_bad_block(block)) {
-            any_bad = true;
-            context.out << "  Bad block: " << block << "\n";
+    std::vector<uint32_t> bad_blocks;
+    if (custom) {
+        context.out << "Scanning for bad blocks..." << std::endl;
+        for (uint32_t block = 0; block < onfi.num_blocks; ++block) {
+            if (is_bad(block)) bad_blocks.push_back(block);
         }
+    } else {
+        const std::string path = onfi::bad_block_table_path(id);
+        if (onfi::attach_bad_block_table(device, id, rescan)) {
+            context.out << "Using bad-block table " << path << "\n";
+        } else {
+            context.out << "Scanned " << device.bad_blocks.blocks() << " blocks";
+            if (!path.empty()) context.out << "; table saved to " << path;
+            context.out << "\n";
+        }
+        bad_blocks = device.bad_blocks.bad_blocks();
+    }
+
+    // Table entries past LUN 0 are reported as the block within their LUN
+    const uint32_t per_lun = device.geometry.blocks_per_lun;
+    for (uint32_t entry : bad_blocks) {
+        context.out << "  Bad block: " << entry % per_lun;
+        if (entry >= per_lun) context.out << " (LUN " << entry / per_lun << ")";
+        context.out << "\n";
     }
-    if (!any_bad) {
+    if (bad_blocks.empty()) {
         context.out << "No bad blocks detected." << std::endl;
     }
-    return any_bad ? 1 : 0;
+    return bad_blocks.empty() ? 0 : 1;
 }
 
 int set_feature_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t address = context.arguments.require_int("address");
     if (address < 0 || address > 0xFF) {
         throw std::invalid_argument("Feature address out of range");
@@ -914,7 +1103,7 @@ int set_feature_command(const CommandContext& context) {
 }
 
 int get_feature_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t address = context.arguments.require_int("address");
     if (address < 0 || address > 0xFF) {
         throw std::invalid_argument("Feature address out of range");
@@ -933,29 +1122,29 @@ int get_feature_command(const CommandContext& context) {
 }
 
 int reset_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     onfi.reset_device(context.verbose);
     context.out << "Reset issued." << "\n";
     return 0;
 }
 
 int device_init_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     onfi.device_initialization(context.verbose);
     context.out << "Device initialization sequence complete." << "\n";
     return 0;
 }
 
 int wait_ready_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     context.out << "Waiting for ready..." << std::flush;
-    onfi.wait_ready_blocking();
+    onfi.wait_ready_op(RbWaitOp::Generic);
     context.out << " done." << "\n";
     return 0;
 }
 
 int raw_command_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t value = context.arguments.require_int("value");
     if (value < 0 || value > 0xFF) {
         throw std::invalid_argument("Command byte out of range");
@@ -967,7 +1156,7 @@ int raw_command_command(const CommandContext& context) {
 }
 
 int raw_address_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     auto bytes_arg = context.arguments.value("bytes");
     if (!bytes_arg) {
         throw std::invalid_argument("Missing required option '--bytes'");
@@ -987,7 +1176,7 @@ int raw_address_command(const CommandContext& context) {
 }
 
 int raw_send_data_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     auto bytes_arg = context.arguments.value("bytes");
     if (!bytes_arg) {
         throw std::invalid_argument("Missing required option '--bytes'");
@@ -1007,7 +1196,7 @@ int raw_send_data_command(const CommandContext& context) {
 }
 
 int raw_read_data_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t count = context.arguments.require_int("count");
     if (count <= 0 || count > 4096) {
         throw std::invalid_argument("--count must be between 1 and 4096");
@@ -1019,7 +1208,7 @@ int raw_read_data_command(const CommandContext& context) {
 }
 
 int raw_change_column_command(const CommandContext& context) {
-    auto& onfi = context.driver.require_onfi_started();
+    auto& onfi = require_session(context);
     const int64_t column = context.arguments.require_int("column");
     if (column < 0 || column > 0xFFFF) {
         throw std::invalid_argument("Column value out of range");
@@ -1095,10 +1284,11 @@ void register_onfi_commands(CommandRegistry& registry) {
         .aliases = {"param"},
         .summary = "Read the ONFI or JEDEC parameter page and update cached geometry.",
         .description = "Retrieves the 256-byte parameter page, updates cached geometry, and optionally dumps it.",
-        .usage = "nandworks parameters [--jedec] [--bytewise] [--raw] [--output <path>]",
+        .usage = "nandworks parameters [--jedec] [--bytewise [--chunk <n>]] [--raw] [--output <path>]",
         .options = {
             OptionSpec{"jedec", '\0', false, false, false, "", "Use the JEDEC parameter page."},
             OptionSpec{"bytewise", '\0', false, false, false, "", "Read the parameter page byte-by-byte."},
+            OptionSpec{"chunk", '\0', true, false, false, "bytes", "With --bytewise, bytes read between column changes (default 1)."},
             OptionSpec{"raw", '\0', false, false, false, "", "Dump the raw 256-byte page to stdout."},
             OptionSpec{"output", 'o', true, false, false, "file", "Write the raw parameter page to a file."}
         },
@@ -1115,13 +1305,17 @@ void register_onfi_commands(CommandRegistry& registry) {
         .aliases = {"read"},
         .summary = "Read a NAND page into memory and display or persist it.",
         .description = "Uses the ONFI READ command sequence to capture a page, optionally including spare bytes.",
-        .usage = "nandworks read-page --block <index> --page <index> [--include-spare] [--bytewise] [--output <path>]",
+        .usage = "nandworks read-page --block <index> --page <index> [--include-spare] [--column <n>] [--length <n>] [--spare-only] [--bytewise [--chunk <n>]] [--output <path>]",
         .options = {
             OptionSpec{"block", 'b', true, true, false, "index", "Block index (0-based)."},
             OptionSpec{"page", 'p', true, true, false, "index", "Page index within the block (0-based)."},
             OptionSpec{"include-spare", 's', false, false, false, "", "Include spare (OOB) bytes in the dump."},
             OptionSpec{"bytewise", '\0', false, false, false, "", "Perform bytewise column switching for the transfer."},
-            OptionSpec{"output", 'o', true, false, false, "file", "Write the raw page data to the specified file."}
+            OptionSpec{"chunk", '\0', true, false, false, "bytes", "With --bytewise, bytes read between column changes (default 1)."},
+            OptionSpec{"column", '\0', true, false, false, "byte", "First column to transfer (spare columns follow the main area)."},
+            OptionSpec{"length", '\0', true, false, false, "bytes", "Number of bytes from the column."},
+            OptionSpec{"spare-only", '\0', false, false, false, "", "Transfer only the spare (OOB) area."},
+            OptionSpec{"output", 'o', true, false, false, "file", "Write the raw page data to the specified file ('-' for stdout)."}
         },
         .min_positionals = 0,
         .max_positionals = 0,
@@ -1159,13 +1353,14 @@ void register_onfi_commands(CommandRegistry& registry) {
         .aliases = {"readb"},
         .summary = "Read an entire block or selected pages and display or persist it.",
         .description = "Uses the ONFI READ sequence to dump one or more pages, optionally including spare bytes.",
-        .usage = "nandworks read-block --block <index> [--pages <list>] [--include-spare] [--bytewise] [--output <path>]",
+        .usage = "nandworks read-block --block <index> [--pages <list>] [--include-spare] [--bytewise [--chunk <n>]] [--output <path>]",
         .options = {
             OptionSpec{"block", 'b', true, true, false, "index", "Block index (0-based)."},
             OptionSpec{"pages", 'p', true, false, false, "list", "Comma or dash separated page list (default all)."},
             OptionSpec{"include-spare", 's', false, false, false, "", "Include spare (OOB) bytes in the dump."},
             OptionSpec{"bytewise", '\0', false, false, false, "", "Perform bytewise column switching for the transfer."},
-            OptionSpec{"output", 'o', true, false, false, "file", "Write the dump to a binary file."}
+            OptionSpec{"chunk", '\0', true, false, false, "bytes", "With --bytewise, bytes read between column changes (default 1)."},
+            OptionSpec{"output", 'o', true, false, false, "file", "Write the dump to a binary file ('-' for stdout)."}
         },
         .min_positionals = 0,
         .max_positionals = 0,
@@ -1180,9 +1375,10 @@ void register_onfi_commands(CommandRegistry& registry) {
         .aliases = {"programb"},
         .summary = "Program a block using a fixed payload, random data, or supplied pages.",
         .description = "Invokes the ONFI program flow across a block or subset of pages with optional verification.",
-        .usage = "nandworks program-block --block <index> [--pages <list>] [--input <path>] [--include-spare] [--pad] [--verify] [--random]",
+        .usage = "nandworks program-block --block <index> [--count <n>] [--pages <list>] [--input <path>] [--include-spare] [--pad] [--verify] [--random]",
         .options = {
             OptionSpec{"block", 'b', true, true, false, "index", "Block index (0-based)."},
+            OptionSpec{"count", '\0', true, false, false, "count", "Program this many consecutive blocks (default 1); pages on different planes go in one multi-plane program."},
             OptionSpec{"pages", 'p', true, false, false, "list", "Comma or dash separated page list."},
             OptionSpec{"input", 'i', true, false, false, "file", "Binary payload to program into each page."},
             OptionSpec{"include-spare", 's', false, false, false, "", "Include spare bytes when programming."},
@@ -1198,16 +1394,40 @@ void register_onfi_commands(CommandRegistry& registry) {
         .handler = program_block_command,
     });
 
+    registry.register_command({
+        .name = "copy-block",
+        .aliases = {"copyb"},
+        .summary = "Copy a block or selected pages to another block inside the device.",
+        .description = "Moves pages with COPYBACK READ/PROGRAM so page data stays on the chip, optionally patching spare bytes on the way.",
+        .usage = "nandworks copy-block --from <index> --to <index> [--pages <list>] [--spare-input <path>] [--erase]",
+        .options = {
+            OptionSpec{"from", '\0', true, true, false, "index", "Source block index (0-based)."},
+            OptionSpec{"to", '\0', true, true, false, "index", "Destination block index (0-based)."},
+            OptionSpec{"pages", 'p', true, false, false, "list", "Comma or dash separated page list (default all)."},
+            OptionSpec{"spare-input", '\0', true, false, false, "file", "Bytes written over the start of each page's spare area."},
+            OptionSpec{"erase", '\0', false, false, false, "", "Erase the destination block first."}
+        },
+        .min_positionals = 0,
+        .max_positionals = 0,
+        .safety = CommandSafety::RequiresForce,
+        .requires_session = true,
+        .requires_root = true,
+        .handler = copy_block_command,
+    });
+
     registry.register_command({
         .name = "verify-page",
         .aliases = {"vp"},
         .summary = "Verify a programmed page against expected data.",
         .description = "Compares the contents of a page with optional reference data and reports byte/bit errors.",
-        .usage = "nandworks verify-page --block <index> --page <index> [--include-spare] [--input <path>]",
+        .usage = "nandworks verify-page --block <index> --page <index> [--include-spare] [--column <n>] [--length <n>] [--spare-only] [--input <path>]",
         .options = {
             OptionSpec{"block", 'b', true, true, false, "index", "Block index (0-based)."},
             OptionSpec{"page", 'p', true, true, false, "index", "Page index (0-based)."},
             OptionSpec{"include-spare", 's', false, false, false, "", "Include spare bytes when comparing."},
+            OptionSpec{"column", '\0', true, false, false, "byte", "First column to transfer (spare columns follow the main area)."},
+            OptionSpec{"length", '\0', true, false, false, "bytes", "Number of bytes from the column."},
+            OptionSpec{"spare-only", '\0', false, false, false, "", "Transfer only the spare (OOB) area."},
             OptionSpec{"input", 'i', true, false, false, "file", "Reference data to compare against."}
         },
         .min_positionals = 0,
@@ -1242,11 +1462,13 @@ void register_onfi_commands(CommandRegistry& registry) {
         .name = "erase-chip",
         .aliases = {"erase-all"},
         .summary = "Erase a contiguous range of blocks (default entire device).",
-        .description = "Iterates block erase across the device, stopping on first failure.",
-        .usage = "nandworks erase-chip [--start <index>] [--count <n>]",
+        .description = "Erases the range, one block per plane at a time when the part supports multi-plane erase, "
+                       "and stops at the first erase that reports failure unless --continue is given.",
+        .usage = "nandworks erase-chip [--start <index>] [--count <n>] [--continue]",
         .options = {
             OptionSpec{"start", '\0', true, false, false, "index", "Starting block index (default 0)."},
-            OptionSpec{"count", '\0', true, false, false, "count", "Number of blocks to erase (default to end)."}
+            OptionSpec{"count", '\0', true, false, false, "count", "Number of blocks to erase (default to end)."},
+            OptionSpec{"continue", '\0', false, false, false, "", "Keep erasing after a failure and list the failed blocks at the end."}
         },
         .min_positionals = 0,
         .max_positionals = 0,
@@ -1260,10 +1482,16 @@ void register_onfi_commands(CommandRegistry& registry) {
         .name = "scan-bad-blocks",
         .aliases = {"bad-blocks"},
         .summary = "Identify blocks marked as bad.",
-        .description = "Checks either a single block or the entire device for factory bad-block markers.",
-        .usage = "nandworks scan-bad-blocks [--block <index>]",
+        .description = "Checks either a single block or the entire device for factory bad-block markers. "
+                       "A full scan is kept as a bad-block table keyed by the chip's unique ID and reused "
+                       "by later sessions until --rescan.",
+        .usage = "nandworks scan-bad-blocks [--block <index>] [--rescan] [--column <n>] [--length <n>] [--spare-only]",
         .options = {
-            OptionSpec{"block", 'b', true, false, false, "index", "Optional single block to inspect."}
+            OptionSpec{"block", 'b', true, false, false, "index", "Optional single block to inspect."},
+            OptionSpec{"rescan", '\0', false, false, false, "", "Ignore a saved bad-block table and scan the chip again."},
+            OptionSpec{"column", '\0', true, false, false, "byte", "Marker column in the first page (default: first spare byte)."},
+            OptionSpec{"length", '\0', true, false, false, "bytes", "Marker bytes from the column (default 1); any 00h marks the block bad."},
+            OptionSpec{"spare-only", '\0', false, false, false, "", "Check the whole spare area of the first page."}
         },
         .min_positionals = 0,
         .max_positionals = 0,
@@ -1532,6 +1760,7 @@ set_flags("read-page", true, true);
 set_flags("program-page", true, true);
 set_flags("read-block", true, true);
 set_flags("program-block", true, true);
+set_flags("copy-block", true, true);
 set_flags("verify-page", true, true);
 set_flags("verify-block", true, true);
 set_flags("erase-chip", true, true);
@@ -1551,6 +1780,21 @@ set_flags("measure-program", true, true);
 set_flags("measure-read", true, true);
 set_flags("erase-block", true, true);
 
+auto set_session_level = [&](std::string_view name, SessionLevel level) {
+    if (const auto* cmd = registry.find(name)) {
+        const_cast<Command*>(cmd)->session_level = level;
+    }
+};
+
+// Diagnostics and raw bus access need neither the reset nor the identification;
+// features only need a device that has been reset
+for (std::string_view name : {"status", "wait-ready", "reset-device", "device-init", "raw-command",
+                              "raw-address", "raw-send-data", "raw-read-data"}) {
+    set_session_level(name, SessionLevel::Bus);
+}
+set_session_level("get-feature", SessionLevel::Reset);
+set_session_level("set-feature", SessionLevel::Reset);
+
 
 }
 
@@ -0,0 +1,97 @@
+#include "nandworks/commands/serve.hpp"
+
+#include "nandworks/command_context.hpp"
+#include "nandworks/daemon.hpp"
+#include "nandworks/driver_context.hpp"
+
+#include <csignal>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include <signal.h>
+
+namespace nandworks::commands {
+namespace {
+
+volatile std::sig_atomic_t g_stop_requested = 0;
+
+void request_stop(int) {
+    g_stop_requested = 1;
+}
+
+unsigned int parse_socket_mode(const std::string& text) {
+    std::size_t consumed = 0;
+    unsigned long mode = 0;
+    try {
+        mode = std::stoul(text, &consumed, 8);
+    } catch (const std::exception&) {
+        consumed = 0;
+    }
+    if (consumed != text.size() || mode > 0777) {
+        throw std::invalid_argument("--mode must be an octal permission such as 0660");
+    }
+    return static_cast<unsigned int>(mode);
+}
+
+int serve_command(const CommandContext& context) {
+    const std::string path = context.arguments.value_or("socket", daemon_socket_path());
+    const unsigned int mode = parse_socket_mode(context.arguments.value_or("mode", "0660"));
+    const param_type type = context.arguments.has("jedec") ? param_type::JEDEC : param_type::ONFI;
+
+    // Bring the device up once; every forwarded command reuses the session
+    context.driver.require_onfi_started(type);
+
+    DaemonServer server(context.registry, context.driver, path);
+    server.listen(mode);
+
+    // No SA_RESTART, so a signal interrupts the blocking accept()
+    struct sigaction action {};
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    struct sigaction previous_int {}, previous_term {};
+    sigaction(SIGINT, &action, &previous_int);
+    sigaction(SIGTERM, &action, &previous_term);
+    g_stop_requested = 0;
+
+    context.out << "Serving on " << path << " (Ctrl-C to stop)" << std::endl;
+    try {
+        server.run(&g_stop_requested);
+    } catch (...) {
+        sigaction(SIGINT, &previous_int, nullptr);
+        sigaction(SIGTERM, &previous_term, nullptr);
+        throw;
+    }
+    sigaction(SIGINT, &previous_int, nullptr);
+    sigaction(SIGTERM, &previous_term, nullptr);
+    context.out << "Stopped after " << server.served() << " commands." << "\n";
+    return 0;
+}
+
+} // namespace
+
+void register_serve_commands(CommandRegistry& registry) {
+    registry.register_command({
+        .name = "serve",
+        .aliases = {"daemon"},
+        .summary = "Keep the GPIO session open and run commands sent by other nandworks invocations.",
+        .description = "Brings the device up once and listens on a Unix-domain socket. While it runs, every "
+                       "nandworks command that needs a session is forwarded to it and executed one at a time "
+                       "on its bus, with output streamed back. Set NANDWORKS_SOCKET to change the default socket "
+                       "and pass --no-daemon to a client to bypass it.",
+        .usage = "nandworks serve [--socket <path>] [--mode <octal>] [--jedec]",
+        .options = {
+            OptionSpec{"socket", 's', true, false, false, "path", "Socket path (default $NANDWORKS_SOCKET or /run/nandworks.sock)."},
+            OptionSpec{"mode", 'm', true, false, false, "octal", "Socket file permissions (default 0660)."},
+            OptionSpec{"jedec", '\0', false, false, false, "", "Identify the device with the JEDEC parameter page."}
+        },
+        .min_positionals = 0,
+        .max_positionals = 0,
+        .safety = CommandSafety::Safe,
+        .requires_session = false,
+        .requires_root = true,
+        .handler = serve_command,
+    });
+}
+
+} // namespace nandworks::commands
@@ -0,0 +1,309 @@
+#include "nandworks/daemon.hpp"
+
+#include "nandworks/dispatch.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace nandworks {
+
+namespace {
+
+constexpr const char* kDefaultSocketPath = "/run/nandworks.sock";
+constexpr uint32_t kMaxRequestBytes = 1u << 20;
+constexpr std::size_t kFrameBufferBytes = 4096;
+constexpr int kListenBacklog = 8;
+
+bool send_all(int fd, const void* data, std::size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        const ssize_t n = ::send(fd, p, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool recv_all(int fd, void* data, std::size_t length) {
+    char* p = static_cast<char*>(data);
+    while (length > 0) {
+        const ssize_t n = ::recv(fd, p, length, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+void put_u32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+uint32_t get_u32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+bool send_frame(int fd, char kind, const char* data, std::size_t length) {
+    char header[5];
+    header[0] = kind;
+    put_u32(header + 1, static_cast<uint32_t>(length));
+    return send_all(fd, header, sizeof(header)) && (length == 0 || send_all(fd, data, length));
+}
+
+// Buffers one response stream and ships it as frames of `kind`. A client that went
+// away only drops the output; the command still runs to completion.
+class FrameStreambuf : public std::streambuf {
+public:
+    FrameStreambuf(int fd, char kind) : fd_(fd), kind_(kind) {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!flush_buffer()) return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override { return flush_buffer() ? 0 : -1; }
+
+private:
+    bool flush_buffer() {
+        const std::ptrdiff_t pending = pptr() - pbase();
+        if (pending > 0 && !broken_) {
+            broken_ = !send_frame(fd_, kind_, pbase(), static_cast<std::size_t>(pending));
+        }
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        return true;
+    }
+
+    int fd_;
+    char kind_;
+    bool broken_ = false;
+    char buffer_[kFrameBufferBytes];
+};
+
+bool make_address(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+void set_timeouts(int fd, unsigned int timeout_ms) {
+    timeval timeout{};
+    timeout.tv_sec = static_cast<time_t>(timeout_ms / 1000);
+    timeout.tv_usec = static_cast<suseconds_t>((timeout_ms % 1000) * 1000);
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+// A peer whose credentials cannot be read is treated as unprivileged
+bool peer_is_root(int fd) {
+    ucred credentials{};
+    socklen_t length = sizeof(credentials);
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) return false;
+    return length == sizeof(credentials) && credentials.uid == 0;
+}
+
+bool read_request(int fd, DaemonRequest& request) {
+    char header[4];
+    if (!recv_all(fd, header, sizeof(header))) return false;
+    const uint32_t length = get_u32(header);
+    if (length == 0 || length > kMaxRequestBytes) return false;
+    std::string payload(length, '\0');
+    if (!recv_all(fd, payload.data(), length)) return false;
+
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    while (start < payload.size()) {
+        const std::size_t end = payload.find('\0', start);
+        if (end == std::string::npos) return false;
+        fields.emplace_back(payload, start, end - start);
+        start = end + 1;
+    }
+    if (fields.size() < 3) return false;
+    request.cwd = std::move(fields[0]);
+    request.verbose = fields[1] == "1";
+    request.command = std::move(fields[2]);
+    request.args.assign(std::make_move_iterator(fields.begin() + 3), std::make_move_iterator(fields.end()));
+    return true;
+}
+
+} // namespace
+
+std::string daemon_socket_path() {
+    const char* env = std::getenv("NANDWORKS_SOCKET");
+    return (env && *env) ? std::string(env) : std::string(kDefaultSocketPath);
+}
+
+int connect_daemon(const std::string& path) {
+    sockaddr_un address;
+    if (!make_address(path, address)) return -1;
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int forward_command(int fd, const DaemonRequest& request, std::ostream& out, std::ostream& err) {
+    std::string payload;
+    payload.append(request.cwd).push_back('\0');
+    payload.append(request.verbose ? "1" : "0").push_back('\0');
+    payload.append(request.command).push_back('\0');
+    for (const auto& arg : request.args) payload.append(arg).push_back('\0');
+
+    char header[4];
+    put_u32(header, static_cast<uint32_t>(payload.size()));
+    if (!send_all(fd, header, sizeof(header)) || !send_all(fd, payload.data(), payload.size())) {
+        ::close(fd);
+        err << "Failed to send command to nandworks daemon.\n";
+        return 4;
+    }
+
+    std::vector<char> data;
+    while (true) {
+        char frame[5];
+        if (!recv_all(fd, frame, sizeof(frame))) break;
+        const uint32_t length = get_u32(frame + 1);
+        data.resize(length);
+        if (length != 0 && !recv_all(fd, data.data(), length)) break;
+        if (frame[0] == 'x' && length == 4) {
+            ::close(fd);
+            out.flush();
+            return static_cast<int32_t>(get_u32(data.data()));
+        }
+        std::ostream& target = (frame[0] == 'e') ? err : out;
+        target.write(data.data(), static_cast<std::streamsize>(length));
+    }
+    ::close(fd);
+    out.flush();
+    err << "nandworks daemon closed the connection before the command finished.\n";
+    return 4;
+}
+
+DaemonServer::DaemonServer(CommandRegistry& registry, DriverContext& driver, std::string socket_path)
+    : registry_(registry), driver_(driver), path_(std::move(socket_path)) {
+    // Commands the daemon runs (batch lines included) use its own session
+    driver_.set_forward_to_daemon(false);
+}
+
+DaemonServer::~DaemonServer() {
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        ::unlink(path_.c_str());
+    }
+}
+
+void DaemonServer::listen(unsigned int mode) {
+    sockaddr_un address;
+    if (!make_address(path_, address)) {
+        throw std::runtime_error("Invalid daemon socket path '" + path_ + "'");
+    }
+    const int existing = connect_daemon(path_);
+    if (existing >= 0) {
+        ::close(existing);
+        throw std::runtime_error("A nandworks daemon is already listening on '" + path_ + "'");
+    }
+    ::unlink(path_.c_str());
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("socket() failed: ") + std::strerror(errno));
+    }
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::chmod(path_.c_str(), static_cast<mode_t>(mode)) != 0 ||
+        ::listen(fd, kListenBacklog) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on '" + path_ + "': " + std::strerror(error));
+    }
+    listen_fd_ = fd;
+}
+
+bool DaemonServer::serve_next() {
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+        if (errno == EINTR) return false;
+        throw std::runtime_error(std::string("accept() failed: ") + std::strerror(errno));
+    }
+
+    if (client_timeout_ms_ != 0) set_timeouts(fd, client_timeout_ms_);
+    DaemonRequest request;
+    if (read_request(fd, request)) {
+        FrameStreambuf out_buffer(fd, 'o');
+        FrameStreambuf err_buffer(fd, 'e');
+        std::ostream out(&out_buffer);
+        std::ostream err(&err_buffer);
+        const int status = dispatch(request, peer_is_root(fd), out, err);
+        out.flush();
+        err.flush();
+        char payload[4];
+        put_u32(payload, static_cast<uint32_t>(status));
+        send_frame(fd, 'x', payload, sizeof(payload));
+        ++served_;
+    }
+    ::close(fd);
+    return true;
+}
+
+void DaemonServer::run(const volatile std::sig_atomic_t* stop) {
+    while (!*stop) {
+        serve_next();
+    }
+}
+
+int DaemonServer::dispatch(const DaemonRequest& request, bool caller_root, std::ostream& out, std::ostream& err) {
+    const Command* command = registry_.find(request.command);
+    if (command != nullptr && command->name == "serve") {
+        err << "Command 'serve' cannot be forwarded to a running daemon.\n";
+        return 2;
+    }
+    // Commands without a session of their own (script, batch) run Lua or further
+    // commands, and with them file access, with the daemon's privileges
+    if (command != nullptr && !command->requires_session && !caller_root) {
+        err << "Command '" << command->name << "' requires root privileges when sent to the daemon.\n";
+        return 5;
+    }
+    // Relative paths resolve against the client's directory, but only a root client may
+    // move the daemon there; other clients keep the daemon's directory
+    if (caller_root && !request.cwd.empty() && ::chdir(request.cwd.c_str()) != 0) {
+        err << "Cannot change to client directory '" << request.cwd << "': " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    // Privileges follow the client, also for commands a forwarded batch or script runs
+    const bool daemon_root = driver_.caller_is_root();
+    driver_.set_caller_root(caller_root && daemon_root);
+    const int status = dispatch_command(registry_, driver_, request.command, request.args, request.verbose, out, err);
+    driver_.set_caller_root(daemon_root);
+    return status;
+}
+
+} // namespace nandworks
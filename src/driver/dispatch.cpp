@@ -0,0 +1,53 @@
+#include "nandworks/dispatch.hpp"
+
+#include "nandworks/cli_parser.hpp"
+#include "nandworks/command_context.hpp"
+
+#include <exception>
+#include <utility>
+
+namespace nandworks {
+
+int dispatch_command(CommandRegistry& registry,
+                     DriverContext& driver,
+                     const std::string& name,
+                     const std::vector<std::string>& args,
+                     bool verbose,
+                     std::ostream& out,
+                     std::ostream& err) {
+    const Command* command = registry.find(name);
+    if (command == nullptr) {
+        err << "Unknown command: " << name << "\n";
+        return 2;
+    }
+
+    ParsedCommand parsed;
+    try {
+        parsed = parse_command_arguments(*command, args);
+    } catch (const std::exception& ex) {
+        err << "Argument error: " << ex.what() << "\n";
+        print_command_usage(*command, err);
+        return 3;
+    }
+    if (parsed.help_requested) {
+        print_command_usage(*command, out);
+        return 0;
+    }
+    if (command->requires_root && !driver.caller_is_root()) {
+        err << "Command '" << command->name << "' requires root privileges." << "\n";
+        return 5;
+    }
+
+    CommandContext context{registry, driver, *command, std::move(parsed.arguments), out, err,
+                           verbose, parsed.force, parsed.help_requested};
+    try {
+        return command->handler(context);
+    } catch (const std::exception& ex) {
+        err << "Command '" << command->name << "' failed: " << ex.what() << "\n";
+    } catch (...) {
+        err << "Command '" << command->name << "' failed with an unknown error." << "\n";
+    }
+    return 4;
+}
+
+} // namespace nandworks
@@ -1,11 +1,16 @@
 #include "nandworks/driver_context.hpp"
 
+#include <cstdlib>
 #include <utility>
 
+#include <unistd.h>
+
 namespace nandworks {
 
 DriverContext::DriverContext(bool verbose)
-    : verbose_(verbose) {}
+    : verbose_(verbose),
+      caller_root_(::geteuid() == 0),
+      forward_to_daemon_(std::getenv("NANDWORKS_NO_DAEMON") == nullptr) {}
 
 DriverContext::~DriverContext() {
     shutdown();
@@ -19,12 +24,26 @@ onfi_interface& DriverContext::require_onfi() {
 }
 
 onfi_interface& DriverContext::require_onfi_started(param_type type) {
+    return require_session(SessionLevel::Identified, type);
+}
+
+onfi_interface& DriverContext::require_session(SessionLevel level, param_type type) {
     onfi_interface& controller = require_onfi();
-    if (!started_) {
+    if (level_ < level) {
         try {
-            controller.get_started(type, verbose_);
-            started_ = true;
-            start_type_ = type;
+            if (level_ < SessionLevel::Bus) {
+                controller.open_bus(verbose_);
+                level_ = SessionLevel::Bus;
+            }
+            if (level_ < SessionLevel::Reset && level >= SessionLevel::Reset) {
+                controller.device_initialization(verbose_);
+                level_ = SessionLevel::Reset;
+            }
+            if (level_ < SessionLevel::Identified && level >= SessionLevel::Identified) {
+                controller.identify_targets(type, verbose_);
+                level_ = SessionLevel::Identified;
+                start_type_ = type;
+            }
         } catch (...) {
             try {
                 controller.deinitialize_onfi(verbose_);
@@ -32,11 +51,11 @@ onfi_interface& DriverContext::require_onfi_started(param_type type) {
                 // Suppress cleanup exceptions during failure recovery.
             }
             onfi_.reset();
-            started_ = false;
+            level_ = SessionLevel::None;
             throw;
         }
-    } else if (type != start_type_) {
-        controller.read_parameters(type, /*bytewise*/true, verbose_);
+    } else if (level == SessionLevel::Identified && type != start_type_) {
+        controller.read_parameters_cached(type, /*bytewise*/true, verbose_);
         start_type_ = type;
     }
     return controller;
@@ -44,13 +63,13 @@ onfi_interface& DriverContext::require_onfi_started(param_type type) {
 
 void DriverContext::shutdown() noexcept {
     if (onfi_) {
-        if (started_) {
+        if (level_ != SessionLevel::None) {
             try {
                 onfi_->deinitialize_onfi(verbose_);
             } catch (...) {
                 // Suppress exceptions during shutdown.
             }
-            started_ = false;
+            level_ = SessionLevel::None;
         }
         onfi_.reset();
     }
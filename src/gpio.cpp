@@ -1,4 +1,5 @@
 #include "gpio.hpp"
+#include "gpio_regs.hpp"
 #include <bcm2835.h>
 #include <sched.h>
 #include <sys/mman.h>
@@ -14,11 +15,20 @@ namespace {
     bool g_scheduler_elevated = false;
     int g_prev_policy = SCHED_OTHER;
     struct sched_param g_prev_param = {};
-    bool g_memory_locked = false;
     bool g_affinity_pinned = false;
     cpu_set_t g_prev_affinity;
     bool g_prev_affinity_valid = false;
+#if !NANDWORKS_HAL_SIM
+    bool g_memory_locked = false;
     int g_pinned_cpu = 0;
+#endif
+
+    // Last value written to (or read from) GPFSEL0..GPFSEL3
+    uint32_t g_fsel_shadow[kGpioFselRegs] = {0, 0, 0, 0};
+
+    inline volatile uint32_t* fsel_reg(uint8_t index) {
+        return bcm2835_gpio + (BCM2835_GPFSEL0 / 4) + index;
+    }
 }
 
 bool gpio_init() {
@@ -32,6 +42,14 @@ bool gpio_init() {
         return false;
     }
 
+    gpio_refresh_fsel_shadow();
+
+#if NANDWORKS_HAL_SIM
+    // The simulated register file has no timing to protect; stay an ordinary process
+    // so CI runners without CAP_SYS_NICE can use it.
+    g_init_refcount = 1;
+    return true;
+#else
     if (!g_memory_locked) {
         if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
             std::cerr << "Warning: mlockall failed (" << std::strerror(errno) << ")" << std::endl;
@@ -93,18 +111,72 @@ bool gpio_init() {
     g_scheduler_elevated = true;
     g_init_refcount = 1;
     return true;
+#endif
 }
 
 void gpio_set_direction(uint8_t pin, bool is_output) {
-    bcm2835_gpio_fsel(pin, is_output ? BCM2835_GPIO_FSEL_OUTP : BCM2835_GPIO_FSEL_INPT);
+    const uint8_t mode = is_output ? BCM2835_GPIO_FSEL_OUTP : BCM2835_GPIO_FSEL_INPT;
+    if (pin >= 32) {
+        bcm2835_gpio_fsel(pin, mode);
+        return;
+    }
+    const uint8_t index = pin / 10;
+    const uint8_t shift = (pin % 10) * 3;
+    const uint32_t field = static_cast<uint32_t>(BCM2835_GPIO_FSEL_MASK) << shift;
+    const uint32_t bits = static_cast<uint32_t>(mode) << shift;
+    if ((g_fsel_shadow[index] & field) == bits) {
+        return;
+    }
+    g_fsel_shadow[index] = (g_fsel_shadow[index] & ~field) | bits;
+    bcm2835_peri_write(fsel_reg(index), g_fsel_shadow[index]);
+}
+
+GpioFselImage gpio_make_fsel_image(const uint8_t* pins, uint8_t count, bool is_output) {
+    GpioFselImage image{};
+    const uint32_t mode = is_output ? BCM2835_GPIO_FSEL_OUTP : BCM2835_GPIO_FSEL_INPT;
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t pin = pins[i];
+        if (pin >= 32) {
+            throw std::invalid_argument("gpio_make_fsel_image only covers GPIO 0..31");
+        }
+        const uint8_t shift = (pin % 10) * 3;
+        image.mask[pin / 10] |= static_cast<uint32_t>(BCM2835_GPIO_FSEL_MASK) << shift;
+        image.bits[pin / 10] |= mode << shift;
+    }
+    return image;
+}
+
+bool gpio_apply_fsel_image(const GpioFselImage& image) {
+    bool wrote = false;
+    for (uint8_t index = 0; index < kGpioFselRegs; ++index) {
+        if (image.mask[index] == 0) continue;
+        if ((g_fsel_shadow[index] & image.mask[index]) == image.bits[index]) continue;
+        g_fsel_shadow[index] = (g_fsel_shadow[index] & ~image.mask[index]) | image.bits[index];
+        bcm2835_peri_write(fsel_reg(index), g_fsel_shadow[index]);
+        wrote = true;
+    }
+    return wrote;
+}
+
+void gpio_refresh_fsel_shadow() {
+    for (uint8_t index = 0; index < kGpioFselRegs; ++index) {
+        g_fsel_shadow[index] = bcm2835_peri_read(fsel_reg(index));
+    }
 }
 
 void gpio_write(uint8_t pin, bool value) {
-    bcm2835_gpio_write(pin, value);
+    if (pin >= 32) {
+        bcm2835_gpio_write(pin, value);
+        return;
+    }
+    gpio_reg_write0(pin, value);
 }
 
 bool gpio_read(uint8_t pin) {
-    return bcm2835_gpio_lev(pin);
+    if (pin >= 32) {
+        return bcm2835_gpio_lev(pin);
+    }
+    return (gpio_reg_levels0() >> pin) & 0x1;
 }
 
 void gpio_set_pud(uint8_t pin, uint8_t pud) {
@@ -112,25 +184,24 @@ void gpio_set_pud(uint8_t pin, uint8_t pud) {
 }
 
 void gpio_set_high(uint8_t pin) {
-    bcm2835_gpio_set(pin);
+    gpio_write(pin, true);
 }
 
 void gpio_set_low(uint8_t pin) {
-    bcm2835_gpio_clr(pin);
+    gpio_write(pin, false);
 }
 
 void gpio_set_multi(uint32_t mask) {
-    bcm2835_gpio_set_multi(mask);
+    gpio_reg_set0(mask);
 }
 
 void gpio_clr_multi(uint32_t mask) {
-    bcm2835_gpio_clr_multi(mask);
+    gpio_reg_clr0(mask);
 }
 
 uint32_t gpio_read_levels0() {
     // Read the level register for GPIO 0..31 in one shot.
-    // Use the mapped GPIO base plus the GPLEV0 offset (word offset).
-    return bcm2835_peri_read(bcm2835_gpio + (BCM2835_GPLEV0 / 4));
+    return gpio_reg_levels0();
 }
 
 void gpio_shutdown() {
@@ -1,10 +1,14 @@
 #include "microprocessor_interface.hpp"
 #include "gpio.hpp"
+#include "gpio_regs.hpp"
 #include "timing.hpp"
 #include "hardware_locations.hpp"
+#include "dq_bus.hpp"
 #include <bcm2835.h>
 #include <cstdint>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include "logging.hpp"
 
 #if defined(__GNUC__)
@@ -14,55 +18,120 @@
 #endif
 
 namespace {
-    static uint32_t dq_all_mask = 0;
-    alignas(32) static uint32_t dq_set_mask[256];
-    static bool dq_lut_inited = false;
-
-    constexpr uint8_t kDqPins[] = {
-        GPIO_DQ0, GPIO_DQ1, GPIO_DQ2, GPIO_DQ3,
-        GPIO_DQ4, GPIO_DQ5, GPIO_DQ6, GPIO_DQ7,
-    };
-
     constexpr uint32_t bit(uint8_t pin) { return static_cast<uint32_t>(1u) << pin; }
 
-    inline uint32_t read_levels0_fast() {
-        return bcm2835_peri_read(bcm2835_gpio + (BCM2835_GPLEV0 / 4));
+    constexpr uint32_t kIdleLowMask = bit(GPIO_ALE) | bit(GPIO_CLE);
+    constexpr uint32_t kWeMask = bit(GPIO_WE);
+
+    // One WE#-latched cycle: WE# low with the zero lines, the one lines, WE# high.
+    // Same three stores (and pacing points) as a data-in burst word (see dq_bus.hpp).
+    template <bool Paced>
+    inline void strobe_we(uint8_t value, const StrobePacing& pacing) {
+        const uint32_t ones = dq_set_mask(value);
+        gpio_reg_clr0(kWeMask | (dq_all_mask() & ~ones));
+        gpio_reg_set0(ones);
+        strobe_delay<Paced>(pacing.we_low);
+        gpio_reg_set0(kWeMask);
+        strobe_delay<Paced>(pacing.we_high);
     }
 
-    void init_dq_lut() {
-        if (dq_lut_inited) return;
-        dq_all_mask = 0;
-        for (uint8_t pin : kDqPins) {
-            dq_all_mask |= bit(pin);
+    template <bool Paced>
+    void strobe_we_bytes(const uint8_t* bytes, uint32_t count, const StrobePacing& pacing) {
+        for (uint32_t i = 0; i < count; ++i) {
+            strobe_we<Paced>(bytes[i], pacing);
         }
-        for (int v = 0; v < 256; ++v) {
-            uint32_t mask = 0;
-            if (v & 0x01) mask |= bit(GPIO_DQ0);
-            if (v & 0x02) mask |= bit(GPIO_DQ1);
-            if (v & 0x04) mask |= bit(GPIO_DQ2);
-            if (v & 0x08) mask |= bit(GPIO_DQ3);
-            if (v & 0x10) mask |= bit(GPIO_DQ4);
-            if (v & 0x20) mask |= bit(GPIO_DQ5);
-            if (v & 0x40) mask |= bit(GPIO_DQ6);
-            if (v & 0x80) mask |= bit(GPIO_DQ7);
-            dq_set_mask[v] = mask;
+    }
+}
+
+std::vector<ChipTarget> parse_chip_targets(const char* spec) {
+    std::vector<ChipTarget> targets;
+    const char* p = spec;
+    auto parse_pin = [&p, spec]() -> uint8_t {
+        char* end = nullptr;
+        const long value = std::strtol(p, &end, 10);
+        if (end == p || value < 0 || value > 31) {
+            throw std::invalid_argument(std::string("bad pin in target list: ") + spec);
         }
-        dq_lut_inited = true;
+        p = end;
+        return static_cast<uint8_t>(value);
+    };
+    while (true) {
+        ChipTarget target{parse_pin(), GPIO_RB};
+        if (*p == ':') {
+            ++p;
+            target.rb_pin = parse_pin();
+        }
+        targets.push_back(target);
+        if (*p == '\0') break;
+        if (*p++ != ',') throw std::invalid_argument(std::string("bad separator in target list: ") + spec);
     }
+    validate_chip_targets(targets);
+    return targets;
+}
 
-    // Eagerly initialize the LUT at load time so the hot path stays branch-free.
-    struct DqLutInitializer {
-        DqLutInitializer() { init_dq_lut(); }
+void validate_chip_targets(const std::vector<ChipTarget>& targets) {
+    struct BusPin { uint8_t pin; const char* name; };
+    static constexpr BusPin kBusPins[] = {
+        {GPIO_DQ0, "DQ0"}, {GPIO_DQ1, "DQ1"}, {GPIO_DQ2, "DQ2"}, {GPIO_DQ3, "DQ3"},
+        {GPIO_DQ4, "DQ4"}, {GPIO_DQ5, "DQ5"}, {GPIO_DQ6, "DQ6"}, {GPIO_DQ7, "DQ7"},
+        {GPIO_DQS, "DQS"}, {GPIO_DQSC, "DQS#"}, {GPIO_WE, "WE#"}, {GPIO_RE, "RE#"},
+        {GPIO_CLE, "CLE"}, {GPIO_ALE, "ALE"}, {GPIO_WP, "WP#"},
     };
-    static const DqLutInitializer kDqLutInitializer{};
+    auto reject = [](const char* role, size_t index, uint8_t pin, const std::string& reason) {
+        throw std::invalid_argument(std::string(role) + " pin " + std::to_string(pin) + " of target " +
+                                    std::to_string(index) + " " + reason);
+    };
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const ChipTarget& t = targets[i];
+        for (const BusPin& bus : kBusPins) {
+            if (t.ce_pin == bus.pin) reject("CE#", i, t.ce_pin, std::string("is the ") + bus.name + " bus pin");
+            if (t.rb_pin == bus.pin) reject("R/B#", i, t.rb_pin, std::string("is the ") + bus.name + " bus pin");
+        }
+        for (size_t j = 0; j < targets.size(); ++j) {
+            if (j < i && targets[j].ce_pin == t.ce_pin) {
+                reject("CE#", i, t.ce_pin, "is already the CE# of target " + std::to_string(j));
+            }
+            if (targets[j].rb_pin == t.ce_pin) {
+                reject("CE#", i, t.ce_pin, "is the R/B# of target " + std::to_string(j));
+            }
+        }
+    }
+}
+
+void interface::set_targets(const std::vector<ChipTarget>& targets) {
+    if (targets.empty()) throw std::invalid_argument("at least one CE# target is required");
+    validate_chip_targets(targets);
+    uint32_t ce_all = 0;
+    for (const ChipTarget& t : targets) ce_all |= bit(t.ce_pin);
+    targets_ = targets;
+    idle_high_mask_ = ce_all | bit(GPIO_RE) | bit(GPIO_WE);
+    target_ = targets_.size(); // force the masks to refresh
+    select_target(0);
+}
+
+void interface::select_target(size_t index) {
+    if (index >= targets_.size()) throw std::out_of_range("CE# target index out of range");
+    if (index == target_) return;
+    target_ = index;
+    ce_mask_ = bit(targets_[index].ce_pin);
+    rb_mask_ = bit(targets_[index].rb_pin);
+    rb_waiter_.set_pin(targets_[index].rb_pin);
+}
 
-    constexpr uint32_t kRbMask = bit(GPIO_RB);
+bool interface::has_private_rb(size_t index) const {
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        if (i != index && targets_[i].rb_pin == targets_.at(index).rb_pin) return false;
+    }
+    return true;
+}
+
+void interface::set_strobe_timing_mode(uint8_t mode) {
+    pacing_ = make_strobe_pacing(onfi_async_timing(mode), strobe_calibration());
 }
 
 // Helper to set DQ pins using LUT for speed
 HOT_ATTR void interface::set_dq_pins(uint8_t data) const {
-    // Single masked write keeps to one peripheral op.
-    bcm2835_gpio_write_mask(dq_set_mask[data], dq_all_mask);
+    gpio_reg_write_mask0(dq_set_mask(data), dq_all_mask());
 }
 
 void interface::open_interface_debug_file() {}
@@ -78,11 +147,12 @@ void interface::set_pin_direction_inactive() const {
     gpio_set_direction(GPIO_ALE, true); gpio_write(GPIO_ALE, 0);
     gpio_set_direction(GPIO_RE, true); gpio_write(GPIO_RE, 1);
     gpio_set_direction(GPIO_WE, true); gpio_write(GPIO_WE, 1);
-    gpio_set_direction(GPIO_CE, true); gpio_write(GPIO_CE, 1);
-
-    // Set RB_PIN to input with pull-up
-    gpio_set_direction(GPIO_RB, false);
-    gpio_set_pud(GPIO_RB, BCM2835_GPIO_PUD_UP);
+    // Every CE# deselected; every R/B# (shared or not) an input with pull-up
+    for (const ChipTarget& t : targets_) {
+        gpio_set_direction(t.ce_pin, true); gpio_write(t.ce_pin, 1);
+        gpio_set_direction(t.rb_pin, false);
+        gpio_set_pud(t.rb_pin, BCM2835_GPIO_PUD_UP);
+    }
 
     // Data bus defaults to outputs pulled low
     set_datalines_direction_default();
@@ -93,42 +163,35 @@ void interface::set_pin_direction_inactive() const {
 }
 
 void interface::set_ce_low() const {
-    gpio_write(GPIO_CE, 0);
+    gpio_write(ce_pin(), 0);
 }
 
 void interface::set_default_pin_values() const {
-    gpio_write(GPIO_CE, 1);
-    gpio_write(GPIO_RE, 1);
-    gpio_write(GPIO_WE, 1);
-    gpio_write(GPIO_ALE, 0);
-    gpio_write(GPIO_CLE, 0);
+    // CE#, RE#, WE# inactive high; ALE, CLE inactive low
+    gpio_set_multi(idle_high_mask_);
+    gpio_clr_multi(kIdleLowMask);
 
     set_datalines_direction_default();
 
-    // Set DQS and DQSc to input when idle
+    // Set DQS and DQSc to input when idle (no-ops once already there)
     gpio_set_direction(GPIO_DQS, false);
     gpio_set_direction(GPIO_DQSC, false);
 }
 
 void interface::set_datalines_direction_default() const {
-    for (uint8_t pin : kDqPins) {
-        gpio_set_direction(pin, true);
-    }
+    // Redundant transitions are skipped against the GPFSEL shadow
+    gpio_apply_fsel_image(dq_fsel_image(true));
     set_dq_pins(0x00); // Reset DQ pins to low
 }
 
 void interface::set_datalines_direction_input() const {
-    for (uint8_t pin : kDqPins) {
-        gpio_set_direction(pin, false);
-    }
+    gpio_apply_fsel_image(dq_fsel_image(false));
 }
 
 void interface::restore_control_pins(bool release_data_bus) const {
-    gpio_write(GPIO_CE, 1);
-    gpio_write(GPIO_WE, 1);
-    gpio_write(GPIO_RE, 1);
-    gpio_write(GPIO_ALE, 0);
-    gpio_write(GPIO_CLE, 0);
+    gpio_reg_set0(idle_high_mask_);
+    gpio_reg_clr0(kIdleLowMask);
+    gpio_reg_barrier();
 
     if (release_data_bus) {
         set_datalines_direction_default();
@@ -137,15 +200,47 @@ void interface::restore_control_pins(bool release_data_bus) const {
     }
 }
 
-void interface::send_command(uint8_t command_to_send) const {
-    gpio_write(GPIO_CE, 0);
-    gpio_write(GPIO_CLE, 1);
+void interface::latch_command(uint8_t command_to_send) const {
+    gpio_reg_barrier();
+    gpio_reg_set0(bit(GPIO_CLE));
+    if (pacing_.active()) {
+        strobe_we<true>(command_to_send, pacing_);
+    } else {
+        strobe_we<false>(command_to_send, pacing_);
+    }
+    gpio_reg_clr0(bit(GPIO_CLE));
+    gpio_reg_barrier();
+}
 
-    bcm2835_gpio_clr(GPIO_WE);
-    set_dq_pins(command_to_send);
-    bcm2835_gpio_set(GPIO_WE);
+void interface::latch_addresses(const uint8_t *address_to_send, uint8_t num_address_bytes) const {
+    gpio_reg_barrier();
+    gpio_reg_set0(bit(GPIO_ALE));
+    if (pacing_.active()) {
+        strobe_we_bytes<true>(address_to_send, num_address_bytes, pacing_);
+    } else {
+        strobe_we_bytes<false>(address_to_send, num_address_bytes, pacing_);
+    }
+    gpio_reg_clr0(bit(GPIO_ALE));
+    gpio_reg_barrier();
+}
+
+void interface::latch_data(const uint8_t *data_to_send, uint32_t num_data) const {
+    // Precompute the whole register stream first so the strobe loop is stores only.
+    dq_build_data_in_burst(data_to_send, num_data, burst_words_);
+
+    GpioReg0Sink sink;
+    gpio_reg_barrier();
+    if (pacing_.active()) {
+        dq_emit_data_in_burst<true>(burst_words_.data(), burst_words_.size(), sink, pacing_);
+    } else {
+        dq_emit_data_in_burst<false>(burst_words_.data(), burst_words_.size(), sink);
+    }
+    gpio_reg_barrier();
+}
 
-    gpio_write(GPIO_CLE, 0);
+void interface::send_command(uint8_t command_to_send) const {
+    set_ce_low();
+    latch_command(command_to_send);
     restore_control_pins(false);
 }
 
@@ -153,15 +248,8 @@ void interface::send_addresses(const uint8_t *address_to_send, uint8_t num_addre
                                                               bool verbose) const {
     LOG_HAL_DEBUG_IF(verbose, "Sending %u address bytes", static_cast<unsigned>(num_address_bytes));
 
-    gpio_write(GPIO_CE, 0);
-    gpio_write(GPIO_ALE, 1);
-
-    for (uint8_t i = 0; i < num_address_bytes; ++i) {
-        bcm2835_gpio_clr(GPIO_WE);
-        set_dq_pins(address_to_send[i]);
-        bcm2835_gpio_set(GPIO_WE);
-    }
-
+    set_ce_low();
+    latch_addresses(address_to_send, num_address_bytes);
     restore_control_pins(false);
 
     (void)verbose;
@@ -169,17 +257,13 @@ void interface::send_addresses(const uint8_t *address_to_send, uint8_t num_addre
 
 void interface::send_data(const uint8_t *data_to_send, uint16_t num_data) const {
     if (interface_type == asynchronous) {
-        gpio_write(GPIO_CE, 0);
-        for (uint16_t i = 0; i < num_data; ++i) {
-            bcm2835_gpio_clr(GPIO_WE);
-            set_dq_pins(data_to_send[i]);
-            bcm2835_gpio_set(GPIO_WE);
-        }
+        set_ce_low();
+        latch_data(data_to_send, num_data);
         restore_control_pins(false);
     } else {
         set_datalines_direction_default();
 
-        gpio_write(GPIO_CE, 0);
+        set_ce_low();
         gpio_write(GPIO_WE, 1);
 
         gpio_set_direction(GPIO_DQS, true);
@@ -191,11 +275,13 @@ void interface::send_data(const uint8_t *data_to_send, uint16_t num_data) const
 
         gpio_write(GPIO_DQS, 0);
         bool dqs_state = false;
+        gpio_reg_barrier();
         for (uint16_t i = 0; i < num_data; ++i) {
             set_dq_pins(data_to_send[i]);
             dqs_state = !dqs_state;
-            bcm2835_gpio_write(GPIO_DQS, dqs_state); // Toggle DQS without a read
+            gpio_reg_write0(GPIO_DQS, dqs_state); // Toggle DQS without a read
         }
+        gpio_reg_barrier();
         restore_control_pins(true);
     }
 }
@@ -204,7 +290,7 @@ bool interface::wait_ready(uint64_t timeout_ns) const {
     const uint64_t deadline = get_timestamp_ns() + timeout_ns;
     uint32_t spin = 0;
     while (true) {
-        if (read_levels0_fast() & kRbMask) return true;
+        if (gpio_reg_levels0() & rb_mask_) return true;
         if ((spin++ & 0xFF) == 0) { // amortize the clock_gettime cost
             if (get_timestamp_ns() >= deadline) return false;
         }
@@ -212,8 +298,21 @@ bool interface::wait_ready(uint64_t timeout_ns) const {
 }
 
 void interface::wait_ready_blocking() const {
-    while ((read_levels0_fast() & kRbMask) == 0) {
+    while ((gpio_reg_levels0() & rb_mask_) == 0) {
         // tight spin, minimal overhead; a nop keeps the pipeline busy without touching memory
         asm volatile("nop");
     }
 }
+
+void interface::wait_ready_blocking(RbWaitOp op) const {
+    rb_waiter_.wait(op);
+}
+
+void interface::set_wait_spin_window(uint64_t spin_ns) {
+    for (size_t i = 0; i < static_cast<size_t>(RbWaitOp::Count); ++i) {
+        const RbWaitOp op = static_cast<RbWaitOp>(i);
+        RbWaitPolicy policy = rb_waiter_.policy(op);
+        policy.spin_ns = spin_ns;
+        rb_waiter_.set_policy(op, policy);
+    }
+}
@@ -23,5 +23,11 @@ void to_col_row_address(uint32_t pages_per_block,
     }
 }
 
+unsigned int lun_block_index(uint32_t blocks_per_lun, unsigned int lun, unsigned int block) {
+    unsigned int block_bits = 0;
+    while ((1u << block_bits) < blocks_per_lun) ++block_bits;
+    return (lun << block_bits) | block;
+}
+
 } // namespace onfi
 
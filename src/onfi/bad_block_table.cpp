@@ -0,0 +1,102 @@
+#include "onfi/bad_block_table.hpp"
+#include "onfi/device.hpp"
+#include "onfi/param_cache.hpp"
+#include "onfi/param_page.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace onfi {
+
+namespace {
+
+constexpr char kMagic[4] = {'N', 'W', 'B', 'B'};
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderBytes = sizeof(kMagic) + 1 + 4;
+
+} // namespace
+
+void BadBlockTable::mark_bad(uint32_t block, bool bad)
+{
+    if (block >= blocks_) return;
+    const uint8_t bit = static_cast<uint8_t>(1u << (block % 8));
+    if (bad) {
+        bits_[block / 8] |= bit;
+    } else {
+        bits_[block / 8] &= static_cast<uint8_t>(~bit);
+    }
+}
+
+uint32_t BadBlockTable::bad_count() const
+{
+    uint32_t count = 0;
+    for (uint8_t byte : bits_) {
+        for (; byte; byte &= static_cast<uint8_t>(byte - 1)) ++count;
+    }
+    return count;
+}
+
+std::vector<uint32_t> BadBlockTable::bad_blocks() const
+{
+    std::vector<uint32_t> out;
+    for (uint32_t block = 0; block < blocks_; ++block) {
+        if (is_bad(block)) out.push_back(block);
+    }
+    return out;
+}
+
+bool BadBlockTable::save(const std::string& path) const
+{
+    if (path.empty()) return false;
+    std::vector<uint8_t> file(kMagic, kMagic + sizeof(kMagic));
+    file.push_back(kVersion);
+    for (int i = 0; i < 4; ++i) file.push_back(static_cast<uint8_t>(blocks_ >> (8 * i)));
+    file.insert(file.end(), bits_.begin(), bits_.end());
+    const uint16_t crc = onfi_crc16(file.data(), file.size());
+    file.push_back(static_cast<uint8_t>(crc & 0xFF));
+    file.push_back(static_cast<uint8_t>(crc >> 8));
+    return write_cache_file(path, file.data(), file.size());
+}
+
+bool BadBlockTable::load(const std::string& path, uint32_t expected_blocks)
+{
+    if (path.empty()) return false;
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const size_t bitmap = (static_cast<size_t>(expected_blocks) + 7) / 8;
+    if (file.size() != kHeaderBytes + bitmap + 2) return false;
+    if (!std::equal(kMagic, kMagic + sizeof(kMagic), file.begin()) || file[4] != kVersion) return false;
+
+    uint32_t blocks = 0;
+    for (int i = 0; i < 4; ++i) blocks |= static_cast<uint32_t>(file[5 + i]) << (8 * i);
+    const size_t crc_at = file.size() - 2;
+    const uint16_t crc = static_cast<uint16_t>(file[crc_at] | (file[crc_at + 1] << 8));
+    if (blocks != expected_blocks || onfi_crc16(file.data(), crc_at) != crc) return false;
+
+    blocks_ = blocks;
+    bits_.assign(file.begin() + kHeaderBytes, file.begin() + crc_at);
+    return true;
+}
+
+std::string bad_block_table_path(const uint8_t* id)
+{
+    return chip_cache_path(id, ".bbt");
+}
+
+bool attach_bad_block_table(NandDevice& device, const uint8_t* id, bool rescan)
+{
+    const std::string path = bad_block_table_path(id);
+    const uint32_t blocks = device.geometry.blocks_per_lun * device.luns();
+    BadBlockTable table;
+    if (!rescan && table.load(path, blocks)) {
+        device.bad_blocks = std::move(table);
+        return true;
+    }
+    device.bad_blocks = device.scan_bad_blocks();
+    device.bad_blocks.save(path);
+    return false;
+}
+
+} // namespace onfi
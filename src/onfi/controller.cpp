@@ -1,26 +1,60 @@
 #include "onfi/controller.hpp"
+#include "onfi/sequence.hpp"
+
+#include <algorithm>
 
 namespace onfi {
 
 void OnfiController::reset() {
-    transport_.send_command(0xFF);
-    transport_.wait_ready_blocking();
+    Sequence seq;
+    seq.command(0xFF).wait_ready(RbWaitOp::Reset);
+    transport_.execute(seq);
 }
 
 void OnfiController::page_read(const uint8_t* addr, uint8_t addr_len, bool pre_zero_cmd) {
+    Sequence seq;
     // Optional preface command for certain chips (e.g., Toshiba toggle variant)
-    if (pre_zero_cmd) transport_.send_command(0x00);
+    if (pre_zero_cmd) seq.command(0x00);
 
-    transport_.send_command(0x00);
-    transport_.send_addresses(addr, addr_len);
-    transport_.send_command(0x30);
-    transport_.wait_ready_blocking();
+    seq.command(0x00).address(addr, addr_len).command(0x30).wait_ready(RbWaitOp::Read);
+    transport_.execute(seq);
 }
 
 void OnfiController::change_read_column(const uint8_t* col2bytes) {
-    transport_.send_command(0x05);
-    transport_.send_addresses(col2bytes, 2);
-    transport_.send_command(0xE0);
+    Sequence seq;
+    seq.command(0x05).address(col2bytes, 2).command(0xE0).wait_ns(transport_.column_change_ns());
+    transport_.execute(seq);
+}
+
+void OnfiController::read_data_chunked(uint32_t column, uint8_t* dst, uint32_t n, uint32_t chunk) {
+    if (chunk == 0) chunk = n;
+    const uint32_t t_ccs = transport_.column_change_ns();
+    Sequence seq;
+    for (uint32_t done = 0; done < n; done += chunk) {
+        const uint32_t at = column + done;
+        const uint8_t col[2] = {static_cast<uint8_t>(at & 0xFF), static_cast<uint8_t>(at >> 8)};
+        seq.clear();
+        seq.command(0x05).address(col, 2).command(0xE0).wait_ns(t_ccs).data_out(dst + done, std::min(chunk, n - done));
+        transport_.execute(seq);
+    }
+}
+
+void OnfiController::cache_read_sequential() {
+    Sequence seq;
+    seq.command(0x31).wait_ready(RbWaitOp::Read);
+    transport_.execute(seq);
+}
+
+void OnfiController::cache_read_random(const uint8_t* addr, uint8_t addr_len) {
+    Sequence seq;
+    seq.command(0x00).address(addr, addr_len).command(0x31).wait_ready(RbWaitOp::Read);
+    transport_.execute(seq);
+}
+
+void OnfiController::cache_read_end() {
+    Sequence seq;
+    seq.command(0x3F).wait_ready(RbWaitOp::Read);
+    transport_.execute(seq);
 }
 
 void OnfiController::prefix_command(uint8_t cmd) {
@@ -28,49 +62,142 @@ void OnfiController::prefix_command(uint8_t cmd) {
 }
 
 void OnfiController::program_page(const uint8_t* addr5, const uint8_t* data, uint32_t len) {
-    transport_.send_command(0x80);
-    transport_.send_addresses(addr5, 5);
-    transport_.send_data(data, static_cast<uint16_t>(len));
-    transport_.send_command(0x10);
-    transport_.wait_ready_blocking();
+    program_page_confirm(addr5, data, len, 0x10);
+}
+
+void OnfiController::program_page_cache(const uint8_t* addr5, const uint8_t* data, uint32_t len) {
+    program_page_confirm(addr5, data, len, 0x15);
 }
 
 void OnfiController::program_page_confirm(const uint8_t* addr5, const uint8_t* data, uint32_t len, uint8_t confirm_cmd) {
-    transport_.send_command(0x80);
-    transport_.send_addresses(addr5, 5);
-    transport_.send_data(data, static_cast<uint16_t>(len));
-    transport_.send_command(confirm_cmd);
-    transport_.wait_ready_blocking();
+    Sequence seq;
+    seq.command(0x80).address(addr5, 5).data_in(data, len).command(confirm_cmd).wait_ready(RbWaitOp::Program);
+    transport_.execute(seq);
 }
 
 void OnfiController::erase_block(const uint8_t* row3) {
-    transport_.send_command(0x60);
-    transport_.send_addresses(row3, 3);
-    transport_.send_command(0xD0);
-    transport_.wait_ready_blocking();
+    Sequence seq;
+    seq.command(0x60).address(row3, 3).command(0xD0).wait_ready(RbWaitOp::Erase);
+    transport_.execute(seq);
+}
+
+void OnfiController::program_page_queue_plane(const uint8_t* addr5, const uint8_t* data, uint32_t len) {
+    Sequence seq;
+    seq.command(0x80).address(addr5, 5).data_in(data, len).command(0x11).wait_ready();
+    transport_.execute(seq);
+}
+
+void OnfiController::page_read_queue_plane(const uint8_t* addr, uint8_t addr_len) {
+    Sequence seq;
+    seq.command(0x00).address(addr, addr_len).command(0x32).wait_ready();
+    transport_.execute(seq);
+}
+
+void OnfiController::select_read_plane(const uint8_t* addr, uint8_t addr_len) {
+    Sequence seq;
+    seq.command(0x06).address(addr, addr_len).command(0xE0).wait_ns(transport_.column_change_ns());
+    transport_.execute(seq);
+}
+
+void OnfiController::erase_blocks_multi_plane(const uint8_t* rows, uint8_t count) {
+    Sequence seq;
+    for (uint8_t i = 0; i < count; ++i) seq.command(0x60).address(rows + 3 * i, 3);
+    seq.command(0xD0).wait_ready(RbWaitOp::Erase);
+    transport_.execute(seq);
 }
 
 void OnfiController::partial_erase_block(const uint8_t* row3, uint32_t loop_count) {
-    transport_.send_command(0x60);
-    transport_.send_addresses(row3, 3);
-    transport_.send_command(0xD0);
+    Sequence seq;
+    seq.command(0x60).address(row3, 3).command(0xD0);
+    transport_.execute(seq);
     transport_.delay_function(loop_count);
-    transport_.send_command(0xFF); // reset to terminate partial erase
-    transport_.wait_ready_blocking();
+
+    seq.clear();
+    seq.command(0xFF).wait_ready(RbWaitOp::Reset); // reset to terminate partial erase
+    transport_.execute(seq);
+}
+
+void OnfiController::copyback_read(const uint8_t* addr5) {
+    Sequence seq;
+    seq.command(0x00).address(addr5, 5).command(0x35).wait_ready(RbWaitOp::Read);
+    transport_.execute(seq);
+}
+
+void OnfiController::copyback_program(const uint8_t* addr5, const ColumnPatch* patches, size_t num_patches) {
+    const uint32_t t_ccs = transport_.column_change_ns();
+    Sequence seq;
+    seq.command(0x85).address(addr5, 5);
+    for (size_t i = 0; i < num_patches; ++i) {
+        const uint8_t column[2] = {static_cast<uint8_t>(patches[i].column & 0xFF),
+                                   static_cast<uint8_t>(patches[i].column >> 8)};
+        seq.command(0x85).address(column, 2).wait_ns(t_ccs).data_in(patches[i].data, patches[i].length);
+    }
+    seq.command(0x10).wait_ready(RbWaitOp::Program);
+    transport_.execute(seq);
+}
+
+void OnfiController::start_page_read(const uint8_t* addr, uint8_t addr_len) {
+    Sequence seq;
+    seq.command(0x00).address(addr, addr_len).command(0x30);
+    transport_.execute(seq);
+}
+
+void OnfiController::start_program_page(const uint8_t* addr5, const uint8_t* data, uint32_t len) {
+    Sequence seq;
+    seq.command(0x80).address(addr5, 5).data_in(data, len).command(0x10);
+    transport_.execute(seq);
+}
+
+void OnfiController::start_erase_block(const uint8_t* row3) {
+    Sequence seq;
+    seq.command(0x60).address(row3, 3).command(0xD0);
+    transport_.execute(seq);
+}
+
+uint8_t OnfiController::read_status_enhanced(const uint8_t* row3) {
+    uint8_t status = 0;
+    Sequence seq;
+    seq.command(0x78).address(row3, 3).data_out(&status, 1);
+    transport_.execute(seq);
+    return status;
+}
+
+uint8_t OnfiController::read_status() {
+    uint8_t status = 0;
+    Sequence seq;
+    seq.command(0x70).data_out(&status, 1);
+    transport_.execute(seq);
+    return status;
+}
+
+void OnfiController::read_selected_data(uint8_t* dst, uint32_t n) {
+    Sequence seq;
+    seq.command(0x00).data_out(dst, n);
+    transport_.execute(seq);
+}
+
+void OnfiController::suspend(uint8_t opcode) {
+    Sequence seq;
+    seq.command(opcode).wait_ready();
+    transport_.execute(seq);
+}
+
+void OnfiController::resume(uint8_t opcode) {
+    Sequence seq;
+    seq.command(opcode);
+    transport_.execute(seq);
 }
 
 void OnfiController::set_features(uint8_t address, const uint8_t data[4], FeatureCommand command) {
-    transport_.send_command(static_cast<uint8_t>(command));
-    transport_.send_addresses(&address, 1);
-    transport_.send_data(data, 4);
-    transport_.wait_ready_blocking();
+    Sequence seq;
+    seq.command(static_cast<uint8_t>(command)).address(&address, 1).data_in(data, 4).wait_ready();
+    transport_.execute(seq);
 }
 
 void OnfiController::get_features(uint8_t address, uint8_t out[4], FeatureCommand command) const {
-    transport_.send_command(static_cast<uint8_t>(command));
-    transport_.send_addresses(&address, 1);
-    transport_.wait_ready_blocking();
-    transport_.get_data(out, 4);
+    Sequence seq;
+    seq.command(static_cast<uint8_t>(command)).address(&address, 1).wait_ready().data_out(out, 4);
+    transport_.execute(seq);
 }
 
 void OnfiController::read_data(uint8_t* dst, uint16_t n) const {
@@ -81,4 +208,8 @@ uint8_t OnfiController::get_status() {
     return transport_.get_status();
 }
 
+int OnfiController::ready_line() const {
+    return transport_.ready_line();
+}
+
 } // namespace onfi
@@ -1,14 +1,81 @@
 #include "onfi/device.hpp"
+#include "timing.hpp"
 #include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 //#include "logging.hpp"  // add if needed for verbose prints
 
 namespace onfi {
 
+namespace {
+
+std::vector<uint16_t> selected_pages(uint32_t pages_per_block, bool complete_block,
+                                     const uint16_t* page_indices, uint16_t num_pages) {
+    std::vector<uint16_t> pages;
+    if (complete_block) {
+        pages.resize(pages_per_block);
+        for (uint32_t p = 0; p < pages_per_block; ++p) pages[p] = static_cast<uint16_t>(p);
+    } else {
+        pages.assign(page_indices, page_indices + num_pages);
+    }
+    return pages;
+}
+
+uint32_t count_mismatches(const std::vector<uint8_t>& got, const uint8_t* expected, uint32_t total,
+                          uint32_t& bit_fail) {
+    uint32_t byte_fail = 0;
+    bit_fail = 0;
+    for (uint32_t i = 0; i < total; ++i) {
+        if (got[i] != expected[i]) {
+            ++byte_fail;
+            uint8_t diff = got[i] ^ expected[i];
+            bit_fail += __builtin_popcount(static_cast<unsigned int>(diff));
+        }
+    }
+    return byte_fail;
+}
+
+// Page image for program_block(s): the provided data, or zeros/random bytes that keep
+// the bad-block marker clear.
+std::vector<uint8_t> program_pattern(const Geometry& geometry, const uint8_t* provided_data,
+                                     bool including_spare, bool randomize) {
+    const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
+    std::vector<uint8_t> buf;
+    if (provided_data) {
+        buf.assign(provided_data, provided_data + total);
+    } else {
+        buf.assign(total, 0x00);
+        if (randomize) {
+            for (uint32_t i = 0; i < total; ++i) buf[i] = static_cast<uint8_t>(rand() % 255);
+        }
+        // Avoid marking bad block: set first spare byte != 0x00
+        if (including_spare && total > geometry.page_size_bytes) buf[geometry.page_size_bytes] = 0xFF;
+    }
+    return buf;
+}
+
+// Largest plane group issued as one operation (keeps the chain within Sequence capacity)
+constexpr size_t kMaxPlanesPerOperation = 4;
+// Column patches one copyback program carries (keeps it within Sequence capacity)
+constexpr size_t kMaxCopyPatches = 4;
+
+} // namespace
+
 void NandDevice::read_page(unsigned int block, unsigned int page, bool including_spare,
                            bool bytewise, std::vector<uint8_t>& out) const {
     const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
     out.assign(total, 0xFF);
+    read_range(block, page, 0, total, out.data(), bytewise);
+}
+
+void NandDevice::read_range(unsigned int block, unsigned int page, uint32_t column, uint32_t length,
+                            uint8_t* out, bool bytewise) const {
+    const uint32_t end = geometry.page_size_bytes + geometry.spare_size_bytes;
+    if (column > end || length > end - column) {
+        throw std::out_of_range("read range extends past the end of the page");
+    }
 
     uint8_t addr[8] = {0};
     const uint8_t addr_len = static_cast<uint8_t>(geometry.column_cycles + geometry.row_cycles);
@@ -19,16 +86,92 @@ void NandDevice::read_page(unsigned int block, unsigned int page, bool including
     ctrl_.page_read(addr, addr_len, needs_pre_zero_cmd);
 
     if (bytewise) {
-        uint8_t col[2] = {0, 0};
-        for (uint32_t i = 0; i < total; ++i) {
-            col[1] = static_cast<uint8_t>(i / 256);
-            col[0] = static_cast<uint8_t>(i % 256);
-            ctrl_.change_read_column(col);
-            ctrl_.read_data(&out[i], 1);
+        ctrl_.read_data_chunked(column, out, length, bytewise_chunk);
+        return;
+    }
+    if (column != 0) {
+        const uint8_t col[2] = {static_cast<uint8_t>(column % 256), static_cast<uint8_t>(column / 256)};
+        ctrl_.change_read_column(col);
+    }
+    ctrl_.read_data(out, static_cast<uint16_t>(length));
+}
+
+void NandDevice::read_spare(unsigned int block, unsigned int page, std::vector<uint8_t>& out) const {
+    out.assign(geometry.spare_size_bytes, 0xFF);
+    read_range(block, page, geometry.page_size_bytes, geometry.spare_size_bytes, out.data());
+}
+
+std::vector<unsigned int> NandDevice::marker_pages() const {
+    std::vector<unsigned int> pages{0};
+    const bool multi_level = chip == micron_mlc || chip == micron_tlc || chip == toshiba_tlc_toggle;
+    if (multi_level && geometry.pages_per_block > 1) pages.push_back(geometry.pages_per_block - 1);
+    return pages;
+}
+
+bool NandDevice::is_bad_block(unsigned int block) const {
+    for (unsigned int page : marker_pages()) {
+        uint8_t marker = 0xFF;
+        read_range(block, page, geometry.page_size_bytes, 1, &marker);
+        if (marker == 0x00) return true;
+    }
+    return false;
+}
+
+bool NandDevice::is_bad(unsigned int block) const {
+    // Undo lun_block(): the LUN bits sit above ceil(log2(blocks_per_lun)) block bits
+    unsigned int block_bits = 0;
+    while ((1u << block_bits) < geometry.blocks_per_lun) ++block_bits;
+    return is_bad(block >> block_bits, block & ((1u << block_bits) - 1));
+}
+
+BadBlockTable NandDevice::scan_bad_blocks() const {
+    const uint32_t per_lun = geometry.blocks_per_lun;
+    BadBlockTable table(per_lun * luns());
+    if (!use_cache_read(false)) {
+        for (uint32_t lun = 0; lun < luns(); ++lun) {
+            for (uint32_t b = 0; b < per_lun; ++b) {
+                table.mark_bad(lun * per_lun + b, is_bad_block(lun_block(lun, b)));
+            }
         }
-    } else {
-        ctrl_.read_data(out.data(), static_cast<uint16_t>(total));
+        return table;
     }
+
+    const std::vector<unsigned int> pages = marker_pages();
+    const uint8_t spare[2] = {static_cast<uint8_t>(geometry.page_size_bytes % 256),
+                              static_cast<uint8_t>(geometry.page_size_bytes / 256)};
+    uint8_t addr[8] = {0};
+    const uint8_t addr_len = static_cast<uint8_t>(geometry.column_cycles + geometry.row_cycles);
+    auto check = [&](uint32_t index) {
+        uint8_t marker = 0xFF;
+        ctrl_.change_read_column(spare);
+        ctrl_.read_data(&marker, 1);
+        if (marker == 0x00) table.mark_bad(index);
+    };
+
+    // One pipeline per LUN, since 31h only chains rows of the LUN it was started on
+    for (uint32_t lun = 0; lun < luns(); ++lun) {
+        std::vector<std::pair<uint32_t, unsigned int>> rows;  // (block within LUN, page)
+        rows.reserve(static_cast<size_t>(per_lun) * pages.size());
+        for (uint32_t b = 0; b < per_lun; ++b) {
+            for (unsigned int page : pages) rows.emplace_back(b, page);
+        }
+        if (rows.empty()) continue;
+
+        auto load = [&](size_t i) {
+            to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                               lun_block(lun, rows[i].first), rows[i].second, addr);
+        };
+        load(0);
+        ctrl_.page_read(addr, addr_len);
+        for (size_t i = 1; i < rows.size(); ++i) {
+            load(i);
+            ctrl_.cache_read_random(addr, addr_len);
+            check(lun * per_lun + rows[i - 1].first);
+        }
+        ctrl_.cache_read_end();
+        check(lun * per_lun + rows.back().first);
+    }
+    return table;
 }
 
 void NandDevice::program_page(unsigned int block, unsigned int page, const uint8_t* data,
@@ -50,6 +193,149 @@ void NandDevice::erase_block(unsigned int block) const {
     ctrl_.erase_block(addr + geometry.column_cycles);
 }
 
+bool NandDevice::copy_page(unsigned int src_block, unsigned int src_page,
+                           unsigned int dst_block, unsigned int dst_page,
+                           const ColumnPatch* patches, size_t num_patches) const {
+    if (num_patches > kMaxCopyPatches) {
+        throw std::invalid_argument("copy_page takes at most four patches");
+    }
+    const uint32_t total = geometry.page_size_bytes + geometry.spare_size_bytes;
+    for (size_t i = 0; i < num_patches; ++i) {
+        if (static_cast<uint32_t>(patches[i].column) + patches[i].length > total) {
+            throw std::out_of_range("copy patch extends past the end of the page");
+        }
+    }
+
+    // Copyback programs from the source plane's page register
+    if (!capabilities.copyback() || plane_of(src_block) != plane_of(dst_block)) {
+        std::vector<uint8_t> buf;
+        read_page(src_block, src_page, /*including_spare*/true, /*bytewise*/false, buf);
+        for (size_t i = 0; i < num_patches; ++i) {
+            std::copy(patches[i].data, patches[i].data + patches[i].length, buf.begin() + patches[i].column);
+        }
+        program_page(dst_block, dst_page, buf.data(), /*including_spare*/true);
+        return (ctrl_.get_status() & 0x01) == 0;
+    }
+
+    uint8_t src[8] = {0};
+    uint8_t dst[8] = {0};
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       src_block, src_page, src);
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       dst_block, dst_page, dst);
+    ctrl_.copyback_read(src);
+    ctrl_.copyback_program(dst, patches, num_patches);
+    return (ctrl_.get_status() & 0x01) == 0;
+}
+
+bool NandDevice::copy_block(unsigned int src_block, unsigned int dst_block,
+                            bool complete_block,
+                            const uint16_t* page_indices,
+                            uint16_t num_pages,
+                            const ColumnPatch* patches, size_t num_patches) const {
+    auto pages = selected_pages(geometry.pages_per_block, complete_block, page_indices, num_pages);
+    // Pages of a block must be programmed in ascending order
+    std::sort(pages.begin(), pages.end());
+    bool ok = true;
+    for (uint16_t page : pages) {
+        if (!copy_page(src_block, page, dst_block, page, patches, num_patches)) ok = false;
+    }
+    return ok;
+}
+
+std::vector<std::vector<unsigned int>> NandDevice::plane_groups(const unsigned int* blocks, size_t count,
+                                                                bool multi_plane) const {
+    std::vector<std::vector<unsigned int>> groups;
+    const size_t limit = multi_plane ? std::min<size_t>(planes(), kMaxPlanesPerOperation) : 1;
+    const uint32_t plane_mask = planes() - 1;
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned int block = blocks[i];
+        bool joins = !groups.empty() && groups.back().size() < limit;
+        if (joins) {
+            for (unsigned int member : groups.back()) {
+                const bool same_plane = (member & plane_mask) == (block & plane_mask);
+                const bool same_upper = (member & ~plane_mask) == (block & ~plane_mask);
+                if (same_plane || (!same_upper && !capabilities.multi_plane_any_block())) joins = false;
+            }
+        }
+        if (joins) {
+            groups.back().push_back(block);
+        } else {
+            groups.push_back({block});
+        }
+    }
+    return groups;
+}
+
+std::vector<EraseGroup> NandDevice::erase_blocks(const unsigned int* blocks, size_t count, bool keep_going,
+                                                const EraseProgress& progress) const {
+    std::vector<EraseGroup> failures;
+    for (auto& group : plane_groups(blocks, count, capabilities.multi_plane_program_erase())) {
+        if (group.size() == 1) {
+            erase_block(group[0]);
+        } else {
+            uint8_t rows[3 * kMaxPlanesPerOperation] = {0};
+            for (size_t i = 0; i < group.size(); ++i) {
+                uint8_t addr[8] = {0};
+                to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                                   group[i], 0, addr);
+                std::copy(addr + geometry.column_cycles, addr + geometry.column_cycles + 3, rows + 3 * i);
+            }
+            ctrl_.erase_blocks_multi_plane(rows, static_cast<uint8_t>(group.size()));
+        }
+        EraseGroup result;
+        result.status = ctrl_.get_status();
+        result.blocks = std::move(group);
+        if (progress) progress(result);
+        if (result.failed()) {
+            failures.push_back(std::move(result));
+            if (!keep_going) break;
+        }
+    }
+    return failures;
+}
+
+bool NandDevice::program_page_multi_plane(const unsigned int* blocks, const uint8_t* const* data, size_t count,
+                                          unsigned int page, bool including_spare) const {
+    if (count == 0) return true;
+    const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
+    uint8_t addr[8] = {0};
+    for (size_t i = 0; i + 1 < count; ++i) {
+        to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                           blocks[i], page, addr);
+        ctrl_.program_page_queue_plane(addr, data[i], total);
+    }
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       blocks[count - 1], page, addr);
+    ctrl_.program_page(addr, data[count - 1], total);
+    return (ctrl_.get_status() & 0x01) == 0;
+}
+
+void NandDevice::read_page_multi_plane(const unsigned int* blocks, size_t count, unsigned int page,
+                                       bool including_spare, std::vector<std::vector<uint8_t>>& out) const {
+    const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
+    const uint8_t addr_len = static_cast<uint8_t>(geometry.column_cycles + geometry.row_cycles);
+    out.assign(count, std::vector<uint8_t>(total, 0xFF));
+    if (count == 0) return;
+
+    uint8_t addr[8] = {0};
+    for (size_t i = 0; i + 1 < count; ++i) {
+        to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                           blocks[i], page, addr);
+        ctrl_.page_read_queue_plane(addr, addr_len);
+    }
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       blocks[count - 1], page, addr);
+    ctrl_.page_read(addr, addr_len);
+
+    for (size_t i = 0; i < count; ++i) {
+        to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                           blocks[i], page, addr);
+        ctrl_.select_read_plane(addr, addr_len);
+        ctrl_.read_data(out[i].data(), static_cast<uint16_t>(total));
+    }
+}
+
 void NandDevice::partial_erase_block(unsigned int block, unsigned int page_in_block, uint32_t loop_count) const {
     uint8_t addr[8] = {0};
     to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
@@ -97,6 +383,46 @@ void NandDevice::read_tlc_subpages(unsigned int block, unsigned int page, DataSi
     sink.flush();
 }
 
+bool NandDevice::use_cache_read(bool bytewise) const {
+    // The Toshiba TLC flow prefixes every read; keep it on plain page reads
+    return capabilities.cache_read() && !bytewise && chip != toshiba_tlc_toggle;
+}
+
+void NandDevice::read_pages(unsigned int block, const uint16_t* pages, uint32_t count,
+                            bool including_spare, bool bytewise, const PageVisitor& visit) const {
+    std::vector<uint8_t> buf;
+    if (count < 2 || !use_cache_read(bytewise)) {
+        for (uint32_t i = 0; i < count; ++i) {
+            read_page(block, pages[i], including_spare, bytewise, buf);
+            visit(pages[i], buf);
+        }
+        return;
+    }
+
+    const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
+    buf.assign(total, 0xFF);
+    uint8_t addr[8] = {0};
+    const uint8_t addr_len = static_cast<uint8_t>(geometry.column_cycles + geometry.row_cycles);
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       block, pages[0], addr);
+    ctrl_.page_read(addr, addr_len);
+
+    for (uint32_t i = 1; i < count; ++i) {
+        if (pages[i] == pages[i - 1] + 1) {
+            ctrl_.cache_read_sequential();
+        } else {
+            to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                               block, pages[i], addr);
+            ctrl_.cache_read_random(addr, addr_len);
+        }
+        ctrl_.read_data(buf.data(), static_cast<uint16_t>(total));
+        visit(pages[i - 1], buf);
+    }
+    ctrl_.cache_read_end();
+    ctrl_.read_data(buf.data(), static_cast<uint16_t>(total));
+    visit(pages[count - 1], buf);
+}
+
 void NandDevice::read_block(unsigned int block,
                             bool complete_block,
                             const uint16_t* page_indices,
@@ -104,25 +430,20 @@ void NandDevice::read_block(unsigned int block,
                             bool including_spare,
                             bool bytewise,
                             DataSink& sink) const {
-    if (complete_block) {
-        for (uint32_t p = 0; p < geometry.pages_per_block; ++p) {
-            std::vector<uint8_t> page;
-            read_page(block, p, including_spare, bytewise, page);
-            sink.write(page.data(), page.size());
-            sink.newline();
-        }
-    } else {
-        for (uint16_t i = 0; i < num_pages; ++i) {
-            std::vector<uint8_t> page;
-            read_page(block, page_indices[i], including_spare, bytewise, page);
-            sink.write(page.data(), page.size());
-            sink.newline();
-        }
-    }
+    const auto pages = selected_pages(geometry.pages_per_block, complete_block, page_indices, num_pages);
+    read_pages(block, pages.data(), static_cast<uint32_t>(pages.size()), including_spare, bytewise,
+               [&](unsigned int, const std::vector<uint8_t>& data) {
+                   sink.write(data.data(), data.size());
+                   sink.newline();
+               });
     sink.flush();
 }
 
-void NandDevice::program_block(unsigned int block,
+bool NandDevice::use_cache_program() const {
+    return capabilities.cache_program() && chip != toshiba_tlc_toggle;
+}
+
+bool NandDevice::program_block(unsigned int block,
                                bool complete_block,
                                const uint16_t* page_indices,
                                uint16_t num_pages,
@@ -130,27 +451,232 @@ void NandDevice::program_block(unsigned int block,
                                bool including_spare,
                                bool randomize) const {
     const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
-    std::vector<uint8_t> buf;
-    if (provided_data) {
-        buf.assign(provided_data, provided_data + total);
-    } else {
-        buf.assign(total, 0x00);
-        if (randomize) {
-            for (uint32_t i = 0; i < total; ++i) buf[i] = static_cast<uint8_t>(rand() % 255);
+    const std::vector<uint8_t> buf = program_pattern(geometry, provided_data, including_spare, randomize);
+
+    auto pages = selected_pages(geometry.pages_per_block, complete_block, page_indices, num_pages);
+    std::sort(pages.begin(), pages.end());
+
+    bool ok = true;
+    if (!use_cache_program() || pages.size() < 2) {
+        for (uint16_t idx : pages) {
+            program_page(block, idx, buf.data(), including_spare);
+            if (ctrl_.get_status() & 0x01) ok = false;
         }
-        // Avoid marking bad block: set first spare byte != 0x00
-        if (including_spare && total > geometry.page_size_bytes) buf[geometry.page_size_bytes] = 0xFF;
+        return ok;
     }
 
-    if (complete_block) {
-        for (uint32_t p = 0; p < geometry.pages_per_block; ++p) {
-            program_page(block, p, buf.data(), including_spare);
+    // Each 15h returns once the cache register is free, so the next page's data-in
+    // overlaps the array programming the previous one. With SR6 (RDY) set, FAILC (SR1)
+    // reports the page before; the closing 10h waits for the array, after which SR5
+    // (ARDY) validates FAIL (SR0) for the last page and FAILC for the one before it.
+    uint8_t addr[8] = {0};
+    for (size_t i = 0; i + 1 < pages.size(); ++i) {
+        to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                           block, pages[i], addr);
+        ctrl_.program_page_cache(addr, buf.data(), total);
+        const uint8_t status = ctrl_.get_status();
+        if ((status & 0x40) && (status & 0x02)) ok = false;
+    }
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       block, pages.back(), addr);
+    ctrl_.program_page(addr, buf.data(), total);
+    const uint8_t status = ctrl_.get_status();
+    if ((status & 0x20) && (status & 0x03)) ok = false;
+    return ok;
+}
+
+uint8_t NandDevice::lun_status(unsigned int lun) const {
+    uint8_t addr[8] = {0};
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       lun_block(lun, 0), 0, addr);
+    return ctrl_.read_status_enhanced(addr + geometry.column_cycles);
+}
+
+bool NandDevice::run_lun_operations(std::vector<LunOperation>& ops) const {
+    bool ok = true;
+    if (luns() < 2 || !capabilities.multi_lun_operations()) {
+        for (LunOperation& op : ops) {
+            const unsigned int block = lun_block(op.lun, op.block);
+            if (op.kind == LunOperation::Kind::Read) {
+                read_page(block, op.page, op.including_spare, /*bytewise*/false, *op.out);
+                op.ok = true;
+            } else {
+                if (op.kind == LunOperation::Kind::Program) {
+                    program_page(block, op.page, op.data, op.including_spare);
+                } else {
+                    erase_block(block);
+                }
+                op.ok = (ctrl_.get_status() & 0x01) == 0;
+            }
+            ok = ok && op.ok;
+        }
+        return ok;
+    }
+
+    std::vector<std::deque<size_t>> queues(luns());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (ops[i].lun >= luns()) throw std::out_of_range("LUN index out of range");
+        queues[ops[i].lun].push_back(i);
+    }
+
+    constexpr size_t kIdle = static_cast<size_t>(-1);
+    std::vector<size_t> in_flight(luns(), kIdle);
+    size_t remaining = ops.size();
+    while (remaining > 0) {
+        for (unsigned int lun = 0; lun < luns(); ++lun) {
+            // 78h both reports the LUN's state and selects it for the commands that follow
+            const uint8_t status = lun_status(lun);
+            if (in_flight[lun] == kIdle) {
+                if (queues[lun].empty() || !(status & 0x40)) continue;
+                start_operation(ops[queues[lun].front()]);
+                in_flight[lun] = queues[lun].front();
+                queues[lun].pop_front();
+                continue;
+            }
+
+            if ((status & 0x60) != 0x60) continue;
+            if (!finish_operation(ops[in_flight[lun]], status)) ok = false;
+            in_flight[lun] = kIdle;
+            --remaining;
+        }
+    }
+    return ok;
+}
+
+bool NandDevice::run_suspendable(LunOperation& op, std::vector<LunOperation>& reads) const {
+    if (op.kind == LunOperation::Kind::Read) throw std::invalid_argument("only a program or erase can be suspended");
+    const SuspendPolicy& policy = suspend_policy;
+    size_t next = 0;
+    auto serve = [&](size_t until) {
+        for (; next < until; ++next) {
+            LunOperation& read = reads[next];
+            read_page(lun_block(read.lun, read.block), read.page, read.including_spare, /*bytewise*/false, *read.out);
+            read.ok = true;
+            ++suspend_stats_.reads_served;
         }
+    };
+
+    start_operation(op);
+    uint64_t resumed_at = get_timestamp_ns();
+    uint32_t suspends = 0;
+    uint8_t status = 0;
+    while (((status = ctrl_.read_status()) & 0x60) != 0x60) {
+        if (policy.suspend_command == 0 || next == reads.size() || suspends == policy.max_suspends) continue;
+        if (get_timestamp_ns() - resumed_at < policy.min_run_ns) continue;
+
+        // An operation that completes before the suspend lands ignores it (and the
+        // resume); the loop then sees it ready.
+        const uint64_t start = get_timestamp_ns();
+        ctrl_.suspend(policy.suspend_command);
+        const size_t window = policy.reads_per_suspend == 0 ? reads.size() : policy.reads_per_suspend;
+        serve(std::min(reads.size(), next + window));
+        ctrl_.resume(policy.resume_command);
+        resumed_at = get_timestamp_ns();
+        const uint64_t suspended = resumed_at - start;
+        ++suspends;
+        ++suspend_stats_.suspends;
+        suspend_stats_.suspended_ns_total += suspended;
+        suspend_stats_.suspended_ns_max = std::max(suspend_stats_.suspended_ns_max, suspended);
+    }
+    const bool ok = finish_operation(op, status);
+    serve(reads.size());
+    return ok;
+}
+
+void NandDevice::start_operation(const LunOperation& op) const {
+    uint8_t addr[8] = {0};
+    to_col_row_address(geometry.pages_per_block, geometry.column_cycles, geometry.row_cycles,
+                       lun_block(op.lun, op.block),
+                       op.kind == LunOperation::Kind::Erase ? 0 : op.page, addr);
+    const uint32_t total = geometry.page_size_bytes + (op.including_spare ? geometry.spare_size_bytes : 0);
+    if (op.kind == LunOperation::Kind::Read) {
+        ctrl_.start_page_read(addr, static_cast<uint8_t>(geometry.column_cycles + geometry.row_cycles));
+    } else if (op.kind == LunOperation::Kind::Program) {
+        ctrl_.start_program_page(addr, op.data, total);
+    } else {
+        ctrl_.start_erase_block(addr + geometry.column_cycles);
+    }
+}
+
+bool NandDevice::finish_operation(LunOperation& op, uint8_t status) const {
+    if (op.kind == LunOperation::Kind::Read) {
+        const uint32_t total = geometry.page_size_bytes + (op.including_spare ? geometry.spare_size_bytes : 0);
+        op.out->assign(total, 0xFF);
+        ctrl_.read_selected_data(op.out->data(), total);
+        op.ok = true;
     } else {
-        std::vector<uint16_t> sorted(page_indices, page_indices + num_pages);
-        std::sort(sorted.begin(), sorted.end());
-        for (uint16_t idx : sorted) program_page(block, idx, buf.data(), including_spare);
+        op.ok = (status & 0x01) == 0;
     }
+    return op.ok;
+}
+
+bool run_target_operations(const std::vector<const NandDevice*>& targets, std::vector<LunOperation>& ops) {
+    std::vector<std::deque<size_t>> queues(targets.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (ops[i].target >= targets.size()) throw std::out_of_range("CE# target index out of range");
+        queues[ops[i].target].push_back(i);
+    }
+
+    constexpr size_t kIdle = static_cast<size_t>(-1);
+    std::vector<size_t> in_flight(targets.size(), kIdle);
+    size_t remaining = ops.size();
+    bool ok = true;
+    while (remaining > 0) {
+        for (size_t t = 0; t < targets.size(); ++t) {
+            if (in_flight[t] == kIdle && queues[t].empty()) continue;
+            const NandDevice& device = *targets[t];
+            // A private R/B# answers without a bus cycle; a shared one says nothing
+            // about this target, so ask the target itself.
+            if (device.ready_line() == 0) continue;
+            const uint8_t status = device.read_status();
+            if (in_flight[t] == kIdle) {
+                if (!(status & 0x40)) continue;
+                device.start_operation(ops[queues[t].front()]);
+                in_flight[t] = queues[t].front();
+                queues[t].pop_front();
+                continue;
+            }
+
+            if ((status & 0x60) != 0x60) continue;
+            if (!device.finish_operation(ops[in_flight[t]], status)) ok = false;
+            in_flight[t] = kIdle;
+            --remaining;
+        }
+    }
+    return ok;
+}
+
+bool NandDevice::program_blocks(const unsigned int* blocks,
+                                size_t num_blocks,
+                                bool complete_block,
+                                const uint16_t* page_indices,
+                                uint16_t num_pages,
+                                const uint8_t* provided_data,
+                                bool including_spare,
+                                bool randomize) const {
+    // A single block keeps program_block's cache program chain
+    const bool multi_plane = capabilities.multi_plane_program_erase() && chip != toshiba_tlc_toggle;
+    if (!multi_plane || num_blocks == 1) {
+        bool ok = true;
+        for (size_t i = 0; i < num_blocks; ++i) {
+            if (!program_block(blocks[i], complete_block, page_indices, num_pages, provided_data,
+                               including_spare, randomize)) ok = false;
+        }
+        return ok;
+    }
+
+    const std::vector<uint8_t> buf = program_pattern(geometry, provided_data, including_spare, randomize);
+    auto pages = selected_pages(geometry.pages_per_block, complete_block, page_indices, num_pages);
+    std::sort(pages.begin(), pages.end());
+
+    bool ok = true;
+    for (const auto& group : plane_groups(blocks, num_blocks, true)) {
+        const std::vector<const uint8_t*> data(group.size(), buf.data());
+        for (uint16_t page : pages) {
+            if (!program_page_multi_plane(group.data(), data.data(), group.size(), page, including_spare)) ok = false;
+        }
+    }
+    return ok;
 }
 
 bool NandDevice::verify_program_page(unsigned int block, unsigned int page,
@@ -162,17 +688,23 @@ bool NandDevice::verify_program_page(unsigned int block, unsigned int page,
                                      uint32_t* out_bit_errors) const {
     (void)verbose;
     const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
-    std::vector<uint8_t> got;
-    read_page(block, page, including_spare, /*bytewise*/false, got);
+    return verify_range(block, page, 0, total, expected, max_allowed_errors, out_byte_errors, out_bit_errors);
+}
 
-    uint32_t byte_fail = 0, bit_fail = 0;
-    for (uint32_t i = 0; i < total; ++i) {
-        if (got[i] != expected[i]) {
-            ++byte_fail;
-            uint8_t diff = got[i] ^ expected[i];
-            bit_fail += __builtin_popcount(static_cast<unsigned int>(diff));
-        }
-    }
+bool NandDevice::verify_range(unsigned int block, unsigned int page,
+                              uint32_t column, uint32_t length,
+                              const uint8_t* expected,
+                              int max_allowed_errors,
+                              uint32_t* out_byte_errors,
+                              uint32_t* out_bit_errors) const {
+    std::vector<uint8_t> got(length, 0xFF);
+    read_range(block, page, column, length, got.data());
+
+    std::vector<uint8_t> default_buf;
+    if (!expected) { default_buf.assign(length, 0x00); expected = default_buf.data(); }
+
+    uint32_t bit_fail = 0;
+    const uint32_t byte_fail = count_mismatches(got, expected, length, bit_fail);
     if (out_byte_errors) *out_byte_errors = byte_fail;
     if (out_bit_errors) *out_bit_errors = bit_fail;
     return static_cast<int>(byte_fail) <= max_allowed_errors;
@@ -193,15 +725,13 @@ bool NandDevice::verify_program_block(unsigned int block,
     if (!exp) { default_buf.assign(total, 0x00); exp = default_buf.data(); }
 
     bool ok = true;
-    if (complete_block) {
-        for (uint32_t p = 0; p < geometry.pages_per_block; ++p) {
-            if (!verify_program_page(block, p, exp, including_spare, verbose, max_allowed_errors)) ok = false;
-        }
-    } else {
-        for (uint16_t i = 0; i < num_pages; ++i) {
-            if (!verify_program_page(block, page_indices[i], exp, including_spare, verbose, max_allowed_errors)) ok = false;
-        }
-    }
+    const auto pages = selected_pages(geometry.pages_per_block, complete_block, page_indices, num_pages);
+    read_pages(block, pages.data(), static_cast<uint32_t>(pages.size()), including_spare, /*bytewise*/false,
+               [&](unsigned int, const std::vector<uint8_t>& got) {
+                   uint32_t bit_fail = 0;
+                   const uint32_t byte_fail = count_mismatches(got, exp, total, bit_fail);
+                   if (static_cast<int>(byte_fail) > max_allowed_errors) ok = false;
+               });
     return ok;
 }
 
@@ -213,17 +743,12 @@ bool NandDevice::verify_erase_block(unsigned int block,
                                     bool verbose) const {
     (void)verbose;
     const uint32_t total = geometry.page_size_bytes + (including_spare ? geometry.spare_size_bytes : 0);
-    std::vector<uint8_t> got;
     bool ok = true;
-    auto check_page = [&](unsigned int page) {
-        read_page(block, page, including_spare, /*bytewise*/false, got);
-        for (uint32_t i = 0; i < total; ++i) if (got[i] != 0xFF) { ok = false; break; }
-    };
-    if (complete_block) {
-        for (uint32_t p = 0; p < geometry.pages_per_block; ++p) check_page(p);
-    } else {
-        for (uint16_t i = 0; i < num_pages; ++i) check_page(page_indices[i]);
-    }
+    const auto pages = selected_pages(geometry.pages_per_block, complete_block, page_indices, num_pages);
+    read_pages(block, pages.data(), static_cast<uint32_t>(pages.size()), including_spare, /*bytewise*/false,
+               [&](unsigned int, const std::vector<uint8_t>& got) {
+                   for (uint32_t i = 0; i < total; ++i) if (got[i] != 0xFF) { ok = false; break; }
+               });
     return ok;
 }
 
@@ -1,6 +1,8 @@
 #include "onfi/device_config.hpp"
 #include "onfi_interface.hpp"
 
+#include <stdexcept>
+
 namespace onfi {
 
 DeviceConfig make_device_config(const ::onfi_interface& source) {
@@ -9,10 +11,20 @@ DeviceConfig make_device_config(const ::onfi_interface& source) {
     config.geometry.spare_size_bytes = source.num_spare_bytes_in_page;
     config.geometry.pages_per_block = source.num_pages_in_block;
     config.geometry.blocks_per_lun = source.num_blocks;
+    config.geometry.luns = source.num_luns;
     config.geometry.column_cycles = source.num_column_cycles;
     config.geometry.row_cycles = source.num_row_cycles;
     config.interface_type = source.interface_type;
     config.chip = source.flash_chip;
+    config.capabilities = source.capabilities;
+    return config;
+}
+
+DeviceConfig make_device_config(const ::onfi_interface& source, unsigned int target) {
+    if (target >= source.target_geometry.size()) throw std::out_of_range("CE# target not identified");
+    DeviceConfig config = make_device_config(source);
+    config.geometry = source.target_geometry[target];
+    config.capabilities = source.target_capabilities[target];
     return config;
 }
 
@@ -10,7 +10,7 @@ void onfi_interface::disable_erase() {
         gpio_write(GPIO_WP, 0);
         return;
     }
-    wait_ready_blocking();
+    wait_ready_op(RbWaitOp::Generic);
     gpio_write(GPIO_WP, 0);
     erase_enabled_ = false;
 }
@@ -20,7 +20,7 @@ void onfi_interface::enable_erase() {
         gpio_write(GPIO_WP, 1);
         return;
     }
-    wait_ready_blocking();
+    wait_ready_op(RbWaitOp::Generic);
     gpio_write(GPIO_WP, 1);
     erase_enabled_ = true;
 }
@@ -35,11 +35,11 @@ void onfi_interface::erase_block(unsigned int my_block_number, bool verbose) {
     uint8_t *row_address = my_test_block_address + 2;
 
     enable_erase();
-    gpio_set_direction(GPIO_RB, false);
+    gpio_set_direction(rb_pin(), false);
 
     onfi::OnfiController ctrl(*this);
     // ensure ready then issue erase
-    wait_ready_blocking();
+    wait_ready_op(RbWaitOp::Generic);
     // Always perform erase; optionally time it
 #if PROFILE_TIME
     uint64_t start_time = get_timestamp_ns();
@@ -80,10 +80,10 @@ void onfi_interface::partial_erase_block(unsigned int my_block_number, unsigned
     uint8_t *row_address = my_test_block_address + 2;
 
     enable_erase();
-    gpio_set_direction(GPIO_RB, false);
+    gpio_set_direction(rb_pin(), false);
 
     onfi::OnfiController ctrl(*this);
-    wait_ready_blocking();
+    wait_ready_op(RbWaitOp::Generic);
 #if PROFILE_TIME
     time_info_file << "Partial Erasing block: ";
     uint64_t start_time = get_timestamp_ns();
@@ -94,7 +94,7 @@ void onfi_interface::partial_erase_block(unsigned int my_block_number, unsigned
     time_info_file << "  took " << (end_time - start_time) / 1000 << " microseconds\n";
 #endif
 
-    wait_ready_blocking();
+    wait_ready_op(RbWaitOp::Generic);
 
     LOG_ONFI_INFO_IF(verbose, "Inside Erase Fn: Address is: %02x,%02x,%02x.", row_address[0], row_address[1], row_address[2]);
 
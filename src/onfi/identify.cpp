@@ -6,6 +6,8 @@
 #include <cstdint>
 #include <array>
 #include "logging.hpp"
+#include "onfi/controller.hpp"
+#include "onfi/param_cache.hpp"
 #include "onfi/param_page.hpp"
 
 void onfi_interface::read_id() {
@@ -17,7 +19,7 @@ void onfi_interface::read_id() {
     send_addresses(&address_to_read);
     std::array<uint8_t, kUniqueIdLength> unique_bytes{};
 
-    while (gpio_read(GPIO_RB) == 0);
+    wait_ready_op(RbWaitOp::Read, true);
 
     get_data(unique_bytes.data(), unique_bytes.size());
     memcpy(unique_id, unique_bytes.data(), unique_bytes.size());
@@ -110,9 +112,9 @@ void onfi_interface::read_id() {
 
 // parameter page_number is the global page number in the chip
 // my_test_block_address is an array [c1,c2,r1,r2,r3]
-void onfi_interface::read_parameters(param_type ONFI_OR_JEDEC, bool bytewise, bool verbose) {
+void onfi_interface::read_parameters(param_type ONFI_OR_JEDEC, bool bytewise, bool verbose, uint32_t bytewise_chunk) {
     // make sure none of the LUNs are busy
-    while (gpio_read(GPIO_RB) == 0);
+    wait_ready_op(RbWaitOp::Generic);
 
     uint8_t address_to_send = 0x00;
     std::string type_parameter = "ONFI";
@@ -124,7 +126,7 @@ void onfi_interface::read_parameters(param_type ONFI_OR_JEDEC, bool bytewise, bo
     LOG_ONFI_INFO_IF(verbose, "Reading %s parameters", type_parameter.c_str());
 
     // make sure none of the LUNs are busy
-    while (gpio_read(GPIO_RB) == 0);
+    wait_ready_op(RbWaitOp::Generic);
 
     LOG_ONFI_DEBUG_IF(verbose, ".. sending command");
     // read ID command
@@ -137,7 +139,7 @@ void onfi_interface::read_parameters(param_type ONFI_OR_JEDEC, bool bytewise, bo
     //have some delay here and wait for busy signal again before reading the paramters
     // asm("nop"); // Replaced with pigpio delay if needed
     // make sure none of the LUNs are busy
-    while (gpio_read(GPIO_RB) == 0);
+    wait_ready_op(RbWaitOp::Read, true);
 
     LOG_ONFI_DEBUG_IF(verbose, ".. acquiring %s parameters", type_parameter.c_str());
     // now read the 256-bytes of data
@@ -146,16 +148,60 @@ void onfi_interface::read_parameters(param_type ONFI_OR_JEDEC, bool bytewise, bo
 
     if (not bytewise)
         get_data(ONFI_parameters, num_bytes_in_parameters);
+    else
+        onfi::OnfiController(*this).read_data_chunked(0, ONFI_parameters, num_bytes_in_parameters, bytewise_chunk);
+
+    parameter_page_crc_ok = false;
+    if (ONFI_OR_JEDEC == ONFI) {
+        parameter_page_crc_ok = onfi::parameter_page_crc_valid(ONFI_parameters);
+        if (!parameter_page_crc_ok) {
+            // Re-read the page with its two redundant copies in one burst; the original
+            // copy is checked again in case only the first transfer was disturbed
+            LOG_ONFI_WARN("Parameter page CRC mismatch, trying redundant copies");
+            uint8_t copies[3 * 256];
+            send_command(0xEC);
+            send_addresses(&address_to_send);
+            wait_ready_op(RbWaitOp::Read, true);
+            get_data(copies, sizeof(copies));
+            for (int copy = 0; copy < 3 && !parameter_page_crc_ok; ++copy) {
+                if (onfi::parameter_page_crc_valid(copies + 256 * copy)) {
+                    memcpy(ONFI_parameters, copies + 256 * copy, num_bytes_in_parameters);
+                    parameter_page_crc_ok = true;
+                    LOG_ONFI_INFO_IF(verbose, "Using parameter page copy %d", copy);
+                }
+            }
+            if (!parameter_page_crc_ok) LOG_ONFI_WARN("No parameter page copy passed its CRC");
+        }
+    }
 
-    uint8_t col_address[2] = {0, 0};
-    if(DEBUG_ONFI) printf("-------------------------------------------------\n");
-    for (uint16_t idx = 0; idx < num_bytes_in_parameters; idx++) {
-        if (bytewise) {
-            col_address[1] = idx / 256;
-            col_address[0] = idx % 256;
-            change_read_column(col_address);
-            get_data(ONFI_parameters + idx, 1);
+    LOG_ONFI_DEBUG_IF(verbose, ".. acquired %s parameters", type_parameter.c_str());
+    decode_parameters(ONFI_OR_JEDEC, ONFI_parameters, verbose);
+}
+
+bool onfi_interface::read_parameters_cached(param_type ONFI_OR_JEDEC, bool bytewise, bool verbose) {
+    const uint8_t* id = reinterpret_cast<const uint8_t*>(unique_id);
+    if (ONFI_OR_JEDEC == ONFI) {
+        uint8_t cached[onfi::kParameterPageBytes];
+        if (onfi::load_cached_parameter_page(id, cached)) {
+            LOG_ONFI_INFO_IF(verbose, "Using cached parameter page %s", onfi::parameter_cache_path(id).c_str());
+            parameter_page_crc_ok = true;
+            decode_parameters(ONFI_OR_JEDEC, cached, verbose);
+            return true;
         }
+    }
+    read_parameters(ONFI_OR_JEDEC, bytewise, verbose);
+    if (ONFI_OR_JEDEC == ONFI && parameter_page_crc_ok) {
+        onfi::store_cached_parameter_page(id, parameter_page);
+    }
+    return false;
+}
+
+void onfi_interface::decode_parameters(param_type ONFI_OR_JEDEC, const uint8_t* ONFI_parameters, bool verbose) {
+    const std::string type_parameter = (ONFI_OR_JEDEC == JEDEC) ? "JEDEC" : "ONFI";
+    if (ONFI_parameters != parameter_page) memcpy(parameter_page, ONFI_parameters, sizeof(parameter_page));
+
+    if(DEBUG_ONFI) printf("-------------------------------------------------\n");
+    for (uint16_t idx = 0; idx < sizeof(parameter_page); idx++) {
         if(DEBUG_ONFI) {
             if (idx % 20 == 0)
                 printf("\n");
@@ -169,8 +215,6 @@ void onfi_interface::read_parameters(param_type ONFI_OR_JEDEC, bool bytewise, bo
     if(DEBUG_ONFI) printf("\n");
     if(DEBUG_ONFI) printf("-------------------------------------------------\n");
 
-    LOG_ONFI_DEBUG_IF(verbose, ".. acquired %s parameters", type_parameter.c_str());
-
     uint8_t ret_whole, ret_decimal;
 
     // following function is irrelevant for JEDEC Page
@@ -184,8 +228,17 @@ void onfi_interface::read_parameters(param_type ONFI_OR_JEDEC, bool bytewise, bo
     num_spare_bytes_in_page = static_cast<uint16_t>(g.spare_size_bytes);
     num_pages_in_block = static_cast<uint16_t>(g.pages_per_block);
     num_blocks = static_cast<uint16_t>(g.blocks_per_lun);
+    num_luns = static_cast<uint8_t>(g.luns);
     num_column_cycles = g.column_cycles;
     num_row_cycles = g.row_cycles;
+    async_timing_modes = 0;
+    capabilities = onfi::Capabilities{};
+    if (ONFI_OR_JEDEC == ONFI) {
+        capabilities = onfi::parse_capabilities(ONFI_parameters);
+        async_timing_modes = static_cast<uint16_t>(ONFI_parameters[129] | (ONFI_parameters[130] << 8));
+        const uint32_t t_r_us = onfi::parse_max_read_time_us(ONFI_parameters[138], ONFI_parameters[137]);
+        if (t_r_us != 0) set_wait_spin_window(static_cast<uint64_t>(t_r_us) * 1000);
+    }
     // Extract manufacturer information (Bytes 32-43)
     memcpy(manufacturer_id, &ONFI_parameters[32], 12);
     manufacturer_id[12] = '\0'; // Null-terminate the string
@@ -1,21 +1,35 @@
 #include "onfi_interface.hpp"
 #include "gpio.hpp"
+#include <algorithm>
 #include <cstdint>
 #include "logging.hpp"
+#include "onfi/device_config.hpp"
 
 void onfi_interface::get_started(param_type ONFI_OR_JEDEC, bool verbose) {
-    bool bytewise = false;
-    initialize_onfi(verbose);
-
-#if PROFILE_TIME
-    open_time_profile_file();
-#endif
+    open_bus(verbose);
 
     /**for the NAND chip, let us initialize the chip
     .. this should follow a pattern of power cycle as mentioned in the datasheet
     .. then we will do a reset operation
     */
     device_initialization(verbose);
+    identify_targets(ONFI_OR_JEDEC, verbose);
+}
+
+void onfi_interface::open_bus(bool verbose) {
+    initialize_onfi(verbose);
+
+#if PROFILE_TIME
+    open_time_profile_file();
+#endif
+
+    set_pin_direction_inactive();
+    set_default_pin_values();
+}
+
+void onfi_interface::identify_targets(param_type ONFI_OR_JEDEC, bool verbose) {
+    bool bytewise = false;
+    select_target(0);
     read_id();
 
     /**
@@ -29,11 +43,42 @@ void onfi_interface::get_started(param_type ONFI_OR_JEDEC, bool verbose) {
         bytewise = false;
     }
 
-    read_parameters(ONFI_OR_JEDEC, bytewise, verbose);
+    // Identify the other targets first so the fields end up describing target 0
+    target_geometry.assign(target_count(), onfi::Geometry{});
+    target_capabilities.assign(target_count(), onfi::Capabilities{});
+    uint16_t common_modes = 0xFFFF;
+    uint32_t largest_page = 0;
+    for (size_t t = target_count(); t-- > 0;) {
+        select_target(t);
+        if (t != 0) reset_device(verbose);
+        // read_id() ran on target 0, so only its page can come from the cache
+        if (t == 0) {
+            read_parameters_cached(ONFI_OR_JEDEC, bytewise, verbose);
+        } else {
+            read_parameters(ONFI_OR_JEDEC, bytewise, verbose);
+        }
+        const onfi::DeviceConfig config = onfi::make_device_config(*this);
+        target_geometry[t] = config.geometry;
+        target_capabilities[t] = config.capabilities;
+        if (async_timing_modes != 0) common_modes &= async_timing_modes;
+        largest_page = std::max<uint32_t>(largest_page, config.geometry.page_size_bytes + config.geometry.spare_size_bytes);
+    }
+
+    // Size the data-out capture buffer for a full page so reads never allocate mid-session
+    ensure_capture(largest_page);
 
-    // Set timing mode to 4 (25ns tRC/tWC)
-    uint8_t timing_mode_data[4] = {0x04, 0x00, 0x00, 0x00};
-    set_features(0x01, timing_mode_data, onfi::FeatureCommand::Set);
+    // Set timing mode 4 (25ns tRC/tWC), or the fastest slower mode every target reports,
+    // and pace the strobes to match
+    uint8_t mode = 4;
+    if (common_modes != 0xFFFF) {
+        while (mode > 0 && !(common_modes & (1u << mode))) --mode;
+    }
+    uint8_t timing_mode_data[4] = {mode, 0x00, 0x00, 0x00};
+    for (size_t t = target_count(); t-- > 0;) {
+        select_target(t);
+        set_features(0x01, timing_mode_data, onfi::FeatureCommand::Set);
+    }
+    set_strobe_timing_mode(mode);
 }
 
 
@@ -93,8 +138,9 @@ void onfi_interface::device_initialization(bool verbose) {
     set_ce_low();
 
     // Wait for R/B signal to go high
+    // (skipped under StatusPoll, where R/B# may not be wired; the reset itself is polled)
     if (verbose) LOG_ONFI_DEBUG("Waiting for R/B signal to go high");
-    wait_ready_blocking();
+    if (!polls_status(RbWaitOp::Reset)) wait_ready_blocking();
 
     // now issue RESET command
     if (verbose) LOG_ONFI_INFO("Issuing reset");
@@ -113,5 +159,5 @@ void onfi_interface::reset_device(bool verbose) {
     // oxff is reset command
     send_command(0xff);
     // No fixed delay; just wait for ready with a timeout
-    wait_ready_blocking();
+    wait_ready_op(RbWaitOp::Reset);
 }
@@ -1,14 +1,40 @@
 #include "onfi_interface.hpp"
 #include "gpio.hpp"
+#include "gpio_regs.hpp"
+#include "dq_bus.hpp"
 #include "timing.hpp"
 #include <bcm2835.h>
 #include <cstdio>
 #include <cstring>
+#include <stdexcept>
 #include "logging.hpp"
 #include "onfi/controller.hpp"
 #include "onfi/address.hpp"
+#include "onfi/sequence.hpp"
 #include "onfi/types.hpp"
 
+namespace {
+    // Guard delays between phases of a held-CE# sequence (timing mode 0 worst case).
+    // The per-call path met these implicitly through its pin restores.
+    constexpr uint64_t kTadlNs = 200; // last address WE# high to first data-in WE# high
+    constexpr uint64_t kTwhrNs = 120; // command/address WE# high to first RE# low
+    constexpr uint64_t kTwbNs = 100;  // WE# high to R/B# low
+    constexpr uint64_t kTrhwNs = 200; // RE# high to the next WE# low
+
+    // Asynchronous data-out strobes; RE# low is padded so DQ is valid (tREA) at the sample
+    template <bool Paced>
+    void capture_re_strobes(uint32_t* levels, uint32_t count, const StrobePacing& pacing) {
+        const uint32_t re_mask = static_cast<uint32_t>(1u) << GPIO_RE;
+        for (uint32_t i = 0; i < count; ++i) {
+            gpio_reg_clr0(re_mask);                 // drive RE low
+            strobe_delay<Paced>(pacing.re_low);
+            levels[i] = gpio_reg_levels0();         // sample DQ
+            gpio_reg_set0(re_mask);                 // latch on rising edge
+            strobe_delay<Paced>(pacing.re_high);
+        }
+    }
+}
+
 uint8_t* onfi_interface::ensure_scratch(size_t size) {
     if (scratch_buffer_.size() < size) {
         scratch_buffer_.resize(size);
@@ -16,14 +42,33 @@ uint8_t* onfi_interface::ensure_scratch(size_t size) {
     return scratch_buffer_.data();
 }
 
+uint32_t* onfi_interface::ensure_capture(size_t count) const {
+    if (capture_levels_.size() < count) {
+        capture_levels_.resize(count);
+    }
+    return capture_levels_.data();
+}
+
 uint8_t onfi_interface::get_status() {
     // 0x70 is the command for getting status register value
-    send_command(0x70);
     uint8_t status = 0;
-    get_data(&status, 1);
+    onfi::Sequence seq;
+    seq.wait_ready().command(0x70).data_out(&status, 1);
+    execute(seq);
     return status;
 }
 
+int onfi_interface::ready_line() const {
+    if (!has_private_rb(selected_target())) return -1;
+    return gpio_read(rb_pin()) ? 1 : 0;
+}
+
+uint32_t onfi_interface::column_change_ns() const {
+    const size_t target = selected_target();
+    if (target < target_capabilities.size()) return target_capabilities[target].column_change_ns;
+    return capabilities.column_change_ns;
+}
+
 void onfi_interface::print_status_on_fail() {
     uint8_t status = get_status();
     if (status & 0x01) {
@@ -36,15 +81,11 @@ void onfi_interface::get_data(uint8_t *data_received, uint16_t num_data) const {
         // Ensure caller knows: this will drive CE low and put DQ into input mode, then restore defaults.
         set_default_pin_values();
         set_datalines_direction_input();
-        wait_ready_blocking();
-        gpio_write(GPIO_CE, 0);
+        // under StatusPoll the caller already polled; R/B# may not be wired
+        if (!polls_status(RbWaitOp::Read)) wait_ready_blocking();
+        set_ce_low();
 
-        // Loop through the number of data to be received
-        for (uint16_t i = 0; i < num_data; ++i) {
-            bcm2835_gpio_clr(GPIO_RE);              // drive RE low
-            data_received[i] = read_dq_pins();      // read DQ
-            bcm2835_gpio_set(GPIO_RE);              // latch on rising edge
-        }
+        read_data_held(data_received, num_data);
 
         set_datalines_direction_default();
         set_default_pin_values();
@@ -56,29 +97,31 @@ void onfi_interface::get_data(uint8_t *data_received, uint16_t num_data) const {
         // Ensure caller knows: this will drive CE low and put DQ into input mode, then restore defaults.
         set_default_pin_values();
         set_datalines_direction_input();
-        gpio_write(GPIO_CE, 0);
+        set_ce_low();
 
         // Initialize RE/DQS
-        bcm2835_gpio_clr(GPIO_RE);
-        bcm2835_gpio_set(GPIO_DQS);
+        gpio_reg_write0(GPIO_RE, false);
+        gpio_reg_write0(GPIO_DQS, true);
         gpio_set_direction(GPIO_DQS, true);
         gpio_set_direction(GPIO_DQSC, true);
-        bcm2835_gpio_clr(GPIO_DQS);
-        bcm2835_gpio_set(GPIO_RE);
+        gpio_reg_write0(GPIO_DQS, false);
+        gpio_reg_write0(GPIO_RE, true);
 
         bool re_level = true;
         bool dqs_level = false;
+        uint32_t* levels = ensure_capture(num_data);
+        gpio_reg_barrier();
         for (uint16_t i = 0; i < num_data; ++i) {
-            data_received[i] = read_dq_pins();
+            levels[i] = gpio_reg_levels0();
 
             re_level = !re_level;
-            if (re_level) bcm2835_gpio_set(GPIO_RE);
-            else bcm2835_gpio_clr(GPIO_RE);
+            gpio_reg_write0(GPIO_RE, re_level);
             dqs_level = !dqs_level;
-            if (dqs_level) bcm2835_gpio_set(GPIO_DQS);
-            else bcm2835_gpio_clr(GPIO_DQS);
+            gpio_reg_write0(GPIO_DQS, dqs_level);
         }
-        bcm2835_gpio_set(GPIO_RE);
+        gpio_reg_write0(GPIO_RE, true);
+        gpio_reg_barrier();
+        dq_decode_levels(levels, num_data, data_received);
 
         set_datalines_direction_default();
         set_default_pin_values();
@@ -87,6 +130,153 @@ void onfi_interface::get_data(uint8_t *data_received, uint16_t num_data) const {
     }
 }
 
+void onfi_interface::read_data_held(uint8_t *data_received, uint32_t num_data) const {
+    set_datalines_direction_input();
+
+    // Capture raw level words while strobing; decoding happens after the burst
+    uint32_t* levels = ensure_capture(num_data);
+    const StrobePacing& pacing = strobe_pacing();
+    gpio_reg_barrier();
+    if (pacing.active()) {
+        capture_re_strobes<true>(levels, num_data, pacing);
+    } else {
+        capture_re_strobes<false>(levels, num_data, pacing);
+    }
+    gpio_reg_barrier();
+    dq_decode_levels(levels, num_data, data_received);
+}
+
+void onfi_interface::poll_status_held(RbWaitOp op) const {
+    const RbWaitPolicy& policy = wait_policy(op);
+    latch_command(0x70);
+    busy_wait_ns(kTwhrNs);
+    set_datalines_direction_input();
+
+    // DQ stays an input; each RE# strobe returns the current status byte
+    uint32_t* level = ensure_capture(1);
+    const StrobePacing& pacing = strobe_pacing();
+    const uint64_t start = get_timestamp_ns();
+    uint64_t last_busy = start;
+    uint64_t reads = 0;
+    while (true) {
+        gpio_reg_barrier();
+        if (pacing.active()) {
+            capture_re_strobes<true>(level, 1, pacing);
+        } else {
+            capture_re_strobes<false>(level, 1, pacing);
+        }
+        gpio_reg_barrier();
+        uint8_t status = 0;
+        dq_decode_levels(level, 1, &status);
+        ++reads;
+
+        const uint64_t now = get_timestamp_ns();
+        if (status & 0x40) {
+            record_status_poll(op, now - start, reads, now - last_busy);
+            return;
+        }
+        if (policy.timeout_ns != 0 && now - start >= policy.timeout_ns) {
+            record_status_poll(op, now - start, reads, 0);
+            restore_control_pins(false);
+            set_datalines_direction_default();
+            throw std::runtime_error("READ STATUS poll timed out");
+        }
+        last_busy = now;
+        if (policy.poll_interval_ns) busy_wait_ns(policy.poll_interval_ns);
+    }
+}
+
+bool onfi_interface::polls_status(RbWaitOp op) const {
+    return interface_type == asynchronous && wait_policy(op).mode == RbWaitMode::StatusPoll;
+}
+
+void onfi_interface::wait_ready_op(RbWaitOp op, bool data_follows) const {
+    if (!polls_status(op)) {
+        wait_ready_blocking(op);
+        return;
+    }
+    set_default_pin_values();
+    set_ce_low();
+    poll_status_held(op);
+    busy_wait_ns(kTrhwNs);
+    set_datalines_direction_default();
+    // 00h leaves status mode so a following data-out reads the register
+    if (data_follows) latch_command(0x00);
+    restore_control_pins(false);
+}
+
+void onfi_interface::execute(const onfi::Sequence& sequence) {
+    if (interface_type != asynchronous) {
+        onfi::Transport::execute(sequence);
+        return;
+    }
+
+    using Op = onfi::Sequence::Op;
+    bool latched = false;   // a WE# edge since the last wait or data-out
+    bool bus_input = false; // DQ left as input by a data-out phase
+
+    set_default_pin_values();
+    set_ce_low();
+    for (const onfi::Sequence::MicroOp* op = sequence.begin(); op != sequence.end(); ++op) {
+        switch (op->op) {
+        case Op::Command:
+        case Op::Address:
+        case Op::DataIn:
+            if (bus_input) {
+                busy_wait_ns(kTrhwNs);
+                set_datalines_direction_default();
+                bus_input = false;
+            }
+            if (op->op == Op::Command) {
+                latch_command(op->value);
+            } else if (op->op == Op::Address) {
+                latch_addresses(sequence.address_bytes(*op), static_cast<uint8_t>(op->length));
+                if (op + 1 != sequence.end() && op[1].op == Op::DataIn) busy_wait_ns(kTadlNs);
+            } else {
+                latch_data(op->src, op->length);
+            }
+            latched = true;
+            break;
+        case Op::DataOut:
+            if (latched) busy_wait_ns(kTwhrNs);
+            read_data_held(op->dst, op->length);
+            latched = false;
+            bus_input = true;
+            break;
+        case Op::WaitReady: {
+            if (latched) busy_wait_ns(kTwbNs);
+            const RbWaitOp kind = static_cast<RbWaitOp>(op->value);
+            if (wait_policy(kind).mode != RbWaitMode::StatusPoll) {
+                wait_ready_blocking(kind);
+                latched = false;
+                break;
+            }
+            if (bus_input) {
+                busy_wait_ns(kTrhwNs);
+                set_datalines_direction_default();
+            }
+            poll_status_held(kind);
+            busy_wait_ns(kTrhwNs);
+            set_datalines_direction_default();
+            bus_input = false;
+            latched = false;
+            // 00h leaves status mode so the data that follows comes from the register
+            const bool data_follows = (op + 1 != sequence.end() && op[1].op == Op::DataOut);
+            if (data_follows || kind == RbWaitOp::Read) {
+                latch_command(0x00);
+                latched = true;
+            }
+            break;
+        }
+        case Op::Delay:
+            busy_wait_ns(op->length);
+            break;
+        }
+    }
+    restore_control_pins(false);
+    if (bus_input) set_datalines_direction_default();
+}
+
 void onfi_interface::set_features(uint8_t address, const uint8_t *data_to_send, onfi::FeatureCommand command) {
     onfi::OnfiController ctrl(*this);
     ctrl.set_features(address, data_to_send, command);
@@ -0,0 +1,95 @@
+#include "onfi/param_cache.hpp"
+#include "onfi/param_page.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace onfi {
+
+bool unique_id_valid(const uint8_t* id)
+{
+    bool all_same = true;
+    for (size_t i = 0; i < kUniqueIdBytes / 2; ++i) {
+        if ((uint8_t)(id[i] ^ id[i + kUniqueIdBytes / 2]) != 0xFF) return false;
+        all_same = all_same && id[i] == id[0];
+    }
+    // An all-00h/FFh ID is what a floating or unsupported bus looks like
+    return !(all_same && (id[0] == 0x00 || id[0] == 0xFF));
+}
+
+std::string parameter_cache_dir()
+{
+    if (const char* dir = std::getenv("NANDWORKS_PARAM_CACHE")) return dir;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) return std::string(xdg) + "/nandworks";
+    if (const char* home = std::getenv("HOME"); home && *home) return std::string(home) + "/.cache/nandworks";
+    return std::string();
+}
+
+std::string chip_cache_path(const uint8_t* id, const char* extension)
+{
+    const std::string dir = parameter_cache_dir();
+    if (dir.empty() || !unique_id_valid(id)) return std::string();
+    // The complement half carries no information
+    std::string name;
+    for (size_t i = 0; i < kUniqueIdBytes / 2; ++i) {
+        char hex[3];
+        std::snprintf(hex, sizeof(hex), "%02x", id[i]);
+        name += hex;
+    }
+    return dir + "/" + name + extension;
+}
+
+std::string parameter_cache_path(const uint8_t* id)
+{
+    return chip_cache_path(id, ".onfi");
+}
+
+bool write_cache_file(const std::string& path, const uint8_t* data, size_t length)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    if (error) return false;
+
+    // Write-then-rename so a concurrent session never reads a torn entry
+    const std::string temp = path + "." + std::to_string(::getpid());
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length))) {
+            file.close();
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+bool load_cached_parameter_page(const uint8_t* id, uint8_t* params)
+{
+    const std::string path = parameter_cache_path(id);
+    if (path.empty()) return false;
+    std::ifstream file(path, std::ios::binary);
+    uint8_t page[kParameterPageBytes];
+    if (!file.read(reinterpret_cast<char*>(page), sizeof(page)) || file.peek() != EOF) return false;
+    if (!parameter_page_crc_valid(page)) return false;
+    std::copy(page, page + sizeof(page), params);
+    return true;
+}
+
+void store_cached_parameter_page(const uint8_t* id, const uint8_t* params)
+{
+    const std::string path = parameter_cache_path(id);
+    if (!path.empty()) write_cache_file(path, params, kParameterPageBytes);
+}
+
+} // namespace onfi
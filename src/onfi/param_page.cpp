@@ -7,6 +7,23 @@ static inline uint32_t u32_from_bytes(uint8_t b3, uint8_t b2, uint8_t b1, uint8_
     return (((uint32_t)b3 << 24) | ((uint32_t)b2 << 16) | ((uint32_t)b1 << 8) | (uint32_t)b0);
 }
 
+uint16_t onfi_crc16(const uint8_t* data, size_t length)
+{
+    uint16_t crc = 0x4F4E;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= (uint16_t)((uint16_t)data[i] << 8);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool parameter_page_crc_valid(const uint8_t* p)
+{
+    return onfi_crc16(p, 254) == (uint16_t)(((uint16_t)p[255] << 8) | p[254]);
+}
+
 Version decode_onfi_version(uint8_t byte4, uint8_t byte5)
 {
     Version v;
@@ -51,12 +68,39 @@ uint32_t parse_blocks_per_lun(uint8_t b99, uint8_t b98, uint8_t b97, uint8_t b96
     return v;
 }
 
+uint32_t parse_max_read_time_us(uint8_t b138, uint8_t b137)
+{
+    uint32_t v = ((uint32_t)b138 << 8) | (uint32_t)b137;
+    if (v == 0xFFFFu) return 0;
+    return v;
+}
+
+Capabilities parse_capabilities(const uint8_t* p)
+{
+    Capabilities caps;
+    caps.features          = (uint16_t)(((uint16_t)p[7] << 8) | p[6]);
+    caps.optional_commands = (uint16_t)(((uint16_t)p[9] << 8) | p[8]);
+    // Erased or blank pages read back all ones; trust nothing from them
+    if (caps.features == 0xFFFFu) caps.features = 0;
+    if (caps.optional_commands == 0xFFFFu) caps.optional_commands = 0;
+    // Byte 113 bits 0-3: interleaved (plane) address bits; more than 8 planes is not plausible
+    const uint8_t plane_bits = (uint8_t)(p[113] & 0x0F);
+    if (p[113] != 0xFF && plane_bits <= 3) {
+        caps.plane_address_bits = plane_bits;
+        caps.multi_plane_attributes = p[114];
+    }
+    const uint16_t t_ccs = (uint16_t)(((uint16_t)p[140] << 8) | p[139]);
+    if (t_ccs != 0 && t_ccs != 0xFFFFu) caps.column_change_ns = t_ccs;
+    return caps;
+}
+
 void parse_geometry_from_parameters(const uint8_t* p, Geometry& out)
 {
     out.page_size_bytes   = parse_page_size(p[83], p[82], p[81], p[80]);
     out.spare_size_bytes  = parse_spare_size(p[85], p[84]);
     out.pages_per_block   = parse_pages_per_block(p[95], p[94], p[93], p[92]);
     out.blocks_per_lun    = parse_blocks_per_lun(p[99], p[98], p[97], p[96]);
+    out.luns              = (p[100] == 0 || p[100] == 0xFF) ? 1u : p[100];
     out.column_cycles     = (p[101] & 0xF0) >> 4;
     out.row_cycles        = (p[101] & 0x0F);
 }
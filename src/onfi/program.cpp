@@ -175,7 +175,7 @@ void onfi_interface::program_page_tlc_toshiba_subpage(unsigned int my_block_numb
 
         
         // check if it is out of Busy cycle
-        wait_ready_blocking();
+        wait_ready_op(RbWaitOp::Program);
 #if PROFILE_TIME
     uint64_t end_time = get_timestamp_ns();
     time_info_file << "  took " << (end_time - start_time) / 1000 << " microseconds\n";
@@ -272,7 +272,7 @@ void onfi_interface::program_page_tlc_toshiba(unsigned int my_block_number, unsi
 
         
         // check if it is out of Busy cycle
-        wait_ready_blocking();
+        wait_ready_op(RbWaitOp::Program);
 #if PROFILE_TIME
     uint64_t end_time = get_timestamp_ns();
     time_info_file << "  took " << (end_time - start_time) / 1000 << " microseconds\n";
@@ -316,7 +316,7 @@ void onfi_interface::program_page_tlc_toshiba(unsigned int my_block_number, unsi
 
         
         // check if it is out of Busy cycle
-        while (gpio_read(GPIO_RB) == 0);
+        wait_ready_op(RbWaitOp::Program);
 #if PROFILE_TIME
     uint64_t end_time2 = get_timestamp_ns();
     time_info_file << "  took " << (end_time2 - start_time2) / 1000 << " microseconds\n";
@@ -360,7 +360,7 @@ void onfi_interface::program_page_tlc_toshiba(unsigned int my_block_number, unsi
 
         
         // check if it is out of Busy cycle
-        while (gpio_read(GPIO_RB) == 0);
+        wait_ready_op(RbWaitOp::Program);
 #if PROFILE_TIME
     uint64_t end_time3 = get_timestamp_ns();
     time_info_file << "  took " << (end_time3 - start_time3) / 1000 << " microseconds\n";
@@ -434,7 +434,7 @@ void onfi_interface::partial_program_page(unsigned int my_block_number, unsigned
     time_info_file << "  took " << (end_time - start_time) / 1000 << " microseconds\n";
 #endif
     // check if it is out of Busy cycle
-    wait_ready_blocking();
+    wait_ready_op(RbWaitOp::Program);
 
     uint8_t status = 0;
     status = get_status();
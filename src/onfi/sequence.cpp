@@ -0,0 +1,101 @@
+#include "onfi/sequence.hpp"
+#include "onfi/transport.hpp"
+#include "timing.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace onfi {
+
+Sequence::MicroOp& Sequence::push(Op op) {
+    if (op_count_ >= kMaxOps) {
+        throw std::length_error("ONFI sequence exceeds micro-op capacity");
+    }
+    MicroOp& slot = ops_[op_count_++];
+    slot.op = op;
+    slot.value = 0;
+    slot.length = 0;
+    slot.src = nullptr;
+    slot.dst = nullptr;
+    return slot;
+}
+
+Sequence& Sequence::command(uint8_t cmd) {
+    push(Op::Command).value = cmd;
+    return *this;
+}
+
+Sequence& Sequence::address(const uint8_t* bytes, uint8_t count) {
+    if (address_used_ + count > kMaxAddressBytes) {
+        throw std::length_error("ONFI sequence exceeds address pool capacity");
+    }
+    MicroOp& slot = push(Op::Address);
+    slot.value = static_cast<uint8_t>(address_used_);
+    slot.length = count;
+    std::memcpy(address_pool_ + address_used_, bytes, count);
+    address_used_ += count;
+    return *this;
+}
+
+Sequence& Sequence::data_in(const uint8_t* data, uint32_t count) {
+    MicroOp& slot = push(Op::DataIn);
+    slot.length = count;
+    slot.src = data;
+    return *this;
+}
+
+Sequence& Sequence::data_out(uint8_t* dst, uint32_t count) {
+    MicroOp& slot = push(Op::DataOut);
+    slot.length = count;
+    slot.dst = dst;
+    return *this;
+}
+
+Sequence& Sequence::wait_ready(RbWaitOp kind) {
+    push(Op::WaitReady).value = static_cast<uint8_t>(kind);
+    return *this;
+}
+
+Sequence& Sequence::wait_ns(uint32_t ns) {
+    push(Op::Delay).length = ns;
+    return *this;
+}
+
+// Fallback for transports without a native interpreter: one call per phase.
+void Transport::execute(const Sequence& sequence) {
+    for (const Sequence::MicroOp& op : sequence) {
+        switch (op.op) {
+        case Sequence::Op::Command:
+            send_command(op.value);
+            break;
+        case Sequence::Op::Address:
+            send_addresses(sequence.address_bytes(op), static_cast<uint8_t>(op.length));
+            break;
+        case Sequence::Op::DataIn:
+            if (op.length > std::numeric_limits<uint16_t>::max()) {
+                throw std::invalid_argument("Payload length exceeds transport capabilities");
+            }
+            send_data(op.src, static_cast<uint16_t>(op.length));
+            break;
+        case Sequence::Op::DataOut:
+            if (op.length > std::numeric_limits<uint16_t>::max()) {
+                throw std::invalid_argument("Read length exceeds transport capabilities");
+            }
+            get_data(op.dst, static_cast<uint16_t>(op.length));
+            break;
+        case Sequence::Op::WaitReady:
+            wait_ready_blocking();
+            break;
+        case Sequence::Op::Delay:
+            busy_wait_ns(op.length);
+            break;
+        }
+    }
+}
+
+void Transport::select_target(unsigned int target) {
+    if (target != 0) throw std::out_of_range("transport has a single CE# target");
+}
+
+} // namespace onfi
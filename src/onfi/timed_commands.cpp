@@ -18,23 +18,23 @@ struct BusyWindow {
     bool timed_out = false;
 };
 
-void wait_for_ready_high(uint64_t timeout_ns) {
-    if (gpio_read(GPIO_RB) != 0) {
+void wait_for_ready_high(uint8_t rb_pin, uint64_t timeout_ns) {
+    if (gpio_read(rb_pin) != 0) {
         return;
     }
     const uint64_t start = get_timestamp_ns();
-    while (gpio_read(GPIO_RB) == 0) {
+    while (gpio_read(rb_pin) == 0) {
         if ((get_timestamp_ns() - start) > timeout_ns) {
             throw std::runtime_error("Timed out waiting for device to become ready before issuing command");
         }
     }
 }
 
-BusyWindow measure_busy_cycle(uint64_t assert_timeout_ns, uint64_t busy_timeout_ns) {
+BusyWindow measure_busy_cycle(uint8_t rb_pin, uint64_t assert_timeout_ns, uint64_t busy_timeout_ns) {
     BusyWindow window{};
 
     const uint64_t assert_start = get_timestamp_ns();
-    while (gpio_read(GPIO_RB) != 0) {
+    while (gpio_read(rb_pin) != 0) {
         if ((get_timestamp_ns() - assert_start) > assert_timeout_ns) {
             window.timed_out = true;
             return window;
@@ -43,7 +43,7 @@ BusyWindow measure_busy_cycle(uint64_t assert_timeout_ns, uint64_t busy_timeout_
 
     window.busy_detected = true;
     const uint64_t busy_start = get_timestamp_ns();
-    while (gpio_read(GPIO_RB) == 0) {
+    while (gpio_read(rb_pin) == 0) {
         if ((get_timestamp_ns() - busy_start) > busy_timeout_ns) {
             window.duration_ns = get_timestamp_ns() - busy_start;
             window.timed_out = true;
@@ -55,6 +55,39 @@ BusyWindow measure_busy_cycle(uint64_t assert_timeout_ns, uint64_t busy_timeout_
     return window;
 }
 
+// StatusPoll variant: the window is the whole 70h poll, busy if more than one status
+// byte was needed; the policy's timeout_ns bounds it
+BusyWindow measure_busy_status(const onfi_interface &onfi, RbWaitOp op, bool data_follows) {
+    BusyWindow window{};
+    const uint64_t reads_before = onfi.wait_stats(op).status_reads;
+    const uint64_t start = get_timestamp_ns();
+    try {
+        onfi.wait_ready_op(op, data_follows);
+    } catch (const std::runtime_error &) {
+        window.timed_out = true;
+    }
+    window.duration_ns = get_timestamp_ns() - start;
+    window.busy_detected = onfi.wait_stats(op).status_reads - reads_before > 1;
+    return window;
+}
+
+BusyWindow measure_busy(const onfi_interface &onfi, RbWaitOp op, bool data_follows) {
+    if (onfi.polls_status(op)) {
+        return measure_busy_status(onfi, op, data_follows);
+    }
+    return measure_busy_cycle(onfi.rb_pin(), kBusyAssertTimeoutNs, kDefaultBusyTimeoutNs);
+}
+
+// Ready before a new command; under StatusPoll R/B# may not be wired
+void guard_ready(const onfi_interface &onfi, RbWaitOp op) {
+    if (onfi.polls_status(op)) {
+        onfi.wait_ready_op(op);
+        return;
+    }
+    gpio_set_direction(onfi.rb_pin(), false);
+    wait_for_ready_high(onfi.rb_pin(), kGuardReadyTimeoutNs);
+}
+
 OperationTiming make_timing(const BusyWindow &window, uint8_t status) {
     OperationTiming timing{};
     timing.duration_ns = window.duration_ns;
@@ -88,14 +121,13 @@ OperationTiming erase_block(onfi_interface &onfi,
     uint8_t *row_address = address + onfi.num_column_cycles;
 
     onfi.enable_erase();
-    gpio_set_direction(GPIO_RB, false);
-    wait_for_ready_high(kGuardReadyTimeoutNs);
+    guard_ready(onfi, RbWaitOp::Erase);
 
     onfi.send_command(0x60);
     onfi.send_addresses(row_address, static_cast<uint8_t>(onfi.num_row_cycles));
     onfi.send_command(0xD0);
 
-    const BusyWindow busy = measure_busy_cycle(kBusyAssertTimeoutNs, kDefaultBusyTimeoutNs);
+    const BusyWindow busy = measure_busy(onfi, RbWaitOp::Erase, false);
 
     const uint8_t status = onfi.get_status();
     onfi.disable_erase();
@@ -126,15 +158,14 @@ OperationTiming program_page(onfi_interface &onfi,
     onfi.convert_pagenumber_to_columnrow_address(block, page, address, verbose);
 
     onfi.enable_erase();
-    gpio_set_direction(GPIO_RB, false);
-    wait_for_ready_high(kGuardReadyTimeoutNs);
+    guard_ready(onfi, RbWaitOp::Program);
 
     onfi.send_command(0x80);
     onfi.send_addresses(address, static_cast<uint8_t>(onfi.num_column_cycles + onfi.num_row_cycles));
     onfi.send_data(data, static_cast<uint16_t>(length));
     onfi.send_command(0x10);
 
-    const BusyWindow busy = measure_busy_cycle(kBusyAssertTimeoutNs, kDefaultBusyTimeoutNs);
+    const BusyWindow busy = measure_busy(onfi, RbWaitOp::Program, false);
 
     const uint8_t status = onfi.get_status();
     onfi.disable_erase();
@@ -167,8 +198,7 @@ OperationTiming read_page(onfi_interface &onfi,
     uint8_t address[8] = {0};
     onfi.convert_pagenumber_to_columnrow_address(block, page, address, verbose);
 
-    gpio_set_direction(GPIO_RB, false);
-    wait_for_ready_high(kGuardReadyTimeoutNs);
+    guard_ready(onfi, RbWaitOp::Read);
 
     const bool pre_zero = (onfi.flash_chip == toshiba_tlc_toggle);
     if (pre_zero) {
@@ -178,7 +208,7 @@ OperationTiming read_page(onfi_interface &onfi,
     onfi.send_addresses(address, static_cast<uint8_t>(onfi.num_column_cycles + onfi.num_row_cycles));
     onfi.send_command(0x30);
 
-    const BusyWindow busy = measure_busy_cycle(kBusyAssertTimeoutNs, kDefaultBusyTimeoutNs);
+    const BusyWindow busy = measure_busy(onfi, RbWaitOp::Read, fetch_data);
 
     if (fetch_data) {
         onfi.get_data(destination, static_cast<uint16_t>(length));
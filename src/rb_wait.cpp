@@ -0,0 +1,291 @@
+#include "rb_wait.hpp"
+#include "gpio_regs.hpp"
+#include "hardware_locations.hpp"
+#include "timing.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#if !NANDWORKS_HAL_SIM && __has_include(<linux/gpio.h>)
+#include <linux/gpio.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#if defined(GPIO_V2_GET_LINE_IOCTL)
+#define RB_WAIT_HAVE_EDGE 1
+#endif
+#endif
+
+#ifndef RB_WAIT_HAVE_EDGE
+#define RB_WAIT_HAVE_EDGE 0
+#endif
+
+namespace {
+    // GPLEV0 polls between clock reads while spinning inside a bounded window
+    constexpr uint32_t kSpinClockStride = 64;
+
+    // Upper bound on one epoll park so a lost edge degrades into polling, not a hang
+    constexpr int kEdgeParkMs = 1;
+
+    constexpr uint64_t kCalibrationSliceNs = 10000;
+    constexpr int kCalibrationSamples = 5;
+    constexpr uint64_t kMinSleepNs = 1000;
+
+    void sleep_ns(uint64_t ns) {
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000ull);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000ull);
+        while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR) {
+        }
+    }
+
+    void record_wake(RbWaitStats& stats, uint64_t latency_ns) {
+        stats.wake_latency_total_ns += latency_ns;
+        stats.wake_latency_max_ns = std::max(stats.wake_latency_max_ns, latency_ns);
+    }
+}
+
+const char* rb_wait_mode_name(RbWaitMode mode) {
+    switch (mode) {
+    case RbWaitMode::Spin: return "spin";
+    case RbWaitMode::SpinThenSleep: return "spin+sleep";
+    case RbWaitMode::SpinThenEdge: return "spin+edge";
+    case RbWaitMode::StatusPoll: return "status-poll";
+    }
+    return "unknown";
+}
+
+const char* rb_wait_op_name(RbWaitOp op) {
+    switch (op) {
+    case RbWaitOp::Generic: return "generic";
+    case RbWaitOp::Read: return "read";
+    case RbWaitOp::Program: return "program";
+    case RbWaitOp::Erase: return "erase";
+    case RbWaitOp::Reset: return "reset";
+    case RbWaitOp::Count: break;
+    }
+    return "unknown";
+}
+
+RbWaiter::RbWaiter()
+    : pin_(GPIO_RB), mask_(static_cast<uint32_t>(1u) << GPIO_RB), edge_(&edges_[GPIO_RB]) {
+    // tR is short enough that parking costs more than it saves; tPROG and tBERS are
+    // hundreds of microseconds to milliseconds, so those park after the spin window.
+    policies_[index(RbWaitOp::Program)].mode = RbWaitMode::SpinThenEdge;
+    policies_[index(RbWaitOp::Erase)].mode = RbWaitMode::SpinThenEdge;
+    policies_[index(RbWaitOp::Reset)].mode = RbWaitMode::SpinThenSleep;
+}
+
+RbWaiter::~RbWaiter() {
+    release_edges();
+}
+
+void RbWaiter::set_pin(uint8_t pin) {
+    if (pin >= kBankPins) throw std::out_of_range("R/B# pin outside GPIO bank 0");
+    pin_ = pin;
+    mask_ = static_cast<uint32_t>(1u) << pin;
+    edge_ = &edges_[pin];
+}
+
+void RbWaiter::release_edges() {
+    for (EdgeLine& edge : edges_) {
+        if (edge.epoll_fd >= 0) close(edge.epoll_fd);
+        if (edge.line_fd >= 0) close(edge.line_fd);
+        edge = EdgeLine{};
+    }
+}
+
+bool RbWaiter::ready() const {
+    return (gpio_reg_levels0() & mask_) != 0;
+}
+
+void RbWaiter::reset_stats() {
+    for (RbWaitStats& s : stats_) s.reset();
+}
+
+void RbWaiter::record_status_poll(RbWaitOp op, uint64_t elapsed_ns, uint64_t reads, uint64_t latency_ns) {
+    RbWaitStats& stats = stats_[index(op)];
+    ++stats.waits;
+    ++stats.status_polls;
+    stats.total_ns += elapsed_ns;
+    stats.status_reads += reads;
+    stats.poll_latency_total_ns += latency_ns;
+    stats.poll_latency_max_ns = std::max(stats.poll_latency_max_ns, latency_ns);
+}
+
+void RbWaiter::wait(RbWaitOp op) {
+    const RbWaitPolicy& policy = policies_[index(op)];
+    RbWaitStats& stats = stats_[index(op)];
+    ++stats.waits;
+
+    if (policy.mode == RbWaitMode::Spin || policy.mode == RbWaitMode::StatusPoll) {
+        const uint64_t start = get_timestamp_ns();
+        while (!ready()) {
+            asm volatile("nop");
+        }
+        stats.total_ns += get_timestamp_ns() - start;
+        return;
+    }
+
+    const uint64_t start = get_timestamp_ns();
+    uint64_t now = start;
+    uint32_t spin = 0;
+    while (!ready()) {
+        if (spin++ % kSpinClockStride != 0) continue;
+        now = get_timestamp_ns();
+        if (now - start < policy.spin_ns) continue;
+
+        ++stats.parked;
+        if (policy.mode == RbWaitMode::SpinThenEdge && edge_available()) {
+            park_edge(stats, now);
+        } else {
+            park_sleep(policy, stats, now);
+        }
+        break;
+    }
+    stats.total_ns += get_timestamp_ns() - start;
+}
+
+void RbWaiter::park_sleep(const RbWaitPolicy& policy, RbWaitStats& stats, uint64_t last_busy_ns) {
+    const uint64_t overshoot = sleep_overshoot_ns();
+    const uint64_t request = policy.sleep_slice_ns > overshoot + kMinSleepNs
+        ? policy.sleep_slice_ns - overshoot
+        : kMinSleepNs;
+    while (true) {
+        sleep_ns(request);
+        const uint64_t now = get_timestamp_ns();
+        if (ready()) {
+            record_wake(stats, now - last_busy_ns);
+            return;
+        }
+        last_busy_ns = now;
+    }
+}
+
+uint64_t RbWaiter::sleep_overshoot_ns() {
+    if (!calibrated_) {
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < kCalibrationSamples; ++i) {
+            const uint64_t before = get_timestamp_ns();
+            sleep_ns(kCalibrationSliceNs);
+            const uint64_t elapsed = get_timestamp_ns() - before;
+            best = std::min(best, elapsed > kCalibrationSliceNs ? elapsed - kCalibrationSliceNs : 0);
+        }
+        overshoot_ns_ = best;
+        calibrated_ = true;
+    }
+    return overshoot_ns_;
+}
+
+#if RB_WAIT_HAVE_EDGE
+
+namespace {
+    // Clock the kernel stamps line events with
+    uint64_t monotonic_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+}
+
+bool RbWaiter::edge_available() {
+    EdgeLine& edge = *edge_;
+    if (edge.tried) return edge.epoll_fd >= 0;
+    edge.tried = true;
+
+    const char* chip = std::getenv("ONFI_GPIOCHIP");
+    const int chip_fd = open(chip ? chip : "/dev/gpiochip0", O_RDONLY | O_CLOEXEC);
+    if (chip_fd < 0) return false;
+
+    struct gpio_v2_line_request request;
+    std::memset(&request, 0, sizeof(request));
+    request.offsets[0] = pin_;
+    request.num_lines = 1;
+    request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING;
+    std::strncpy(request.consumer, "nandworks-rb", sizeof(request.consumer) - 1);
+    const int rc = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request);
+    close(chip_fd);
+    if (rc < 0 || request.fd < 0) return false;
+
+    edge.line_fd = request.fd;
+    fcntl(edge.line_fd, F_SETFL, fcntl(edge.line_fd, F_GETFL) | O_NONBLOCK);
+
+    edge.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (edge.epoll_fd < 0) {
+        close(edge.line_fd);
+        edge.line_fd = -1;
+        return false;
+    }
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = edge.line_fd;
+    if (epoll_ctl(edge.epoll_fd, EPOLL_CTL_ADD, edge.line_fd, &ev) != 0) {
+        close(edge.epoll_fd);
+        close(edge.line_fd);
+        edge.epoll_fd = -1;
+        edge.line_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void RbWaiter::drain_events() {
+    struct gpio_v2_line_event event;
+    while (read(edge_->line_fd, &event, sizeof(event)) == static_cast<ssize_t>(sizeof(event))) {
+    }
+}
+
+void RbWaiter::park_edge(RbWaitStats& stats, uint64_t last_busy_ns) {
+    // Edges queued by earlier operations would wake us immediately; drop them, then
+    // re-check the level so a rise between the last poll and arming is not missed.
+    drain_events();
+    if (ready()) {
+        record_wake(stats, get_timestamp_ns() - last_busy_ns);
+        return;
+    }
+
+    while (true) {
+        struct epoll_event ev;
+        const int n = epoll_wait(edge_->epoll_fd, &ev, 1, kEdgeParkMs);
+        uint64_t edge_ns = 0;
+        if (n > 0) {
+            struct gpio_v2_line_event event;
+            while (read(edge_->line_fd, &event, sizeof(event)) == static_cast<ssize_t>(sizeof(event))) {
+                edge_ns = event.timestamp_ns;
+            }
+        }
+        if (ready()) {
+            if (edge_ns != 0) {
+                const uint64_t woke = monotonic_ns();
+                ++stats.edge_wakeups;
+                record_wake(stats, woke > edge_ns ? woke - edge_ns : 0);
+            } else {
+                record_wake(stats, get_timestamp_ns() - last_busy_ns);
+            }
+            return;
+        }
+        last_busy_ns = get_timestamp_ns();
+    }
+}
+
+#else
+
+bool RbWaiter::edge_available() {
+    edge_->tried = true;
+    return false;
+}
+
+void RbWaiter::drain_events() {
+}
+
+void RbWaiter::park_edge(RbWaitStats& stats, uint64_t last_busy_ns) {
+    park_sleep(RbWaitPolicy{}, stats, last_busy_ns);
+}
+
+#endif // RB_WAIT_HAVE_EDGE
@@ -21,7 +21,6 @@
 #include <string_view>
 #include <utility>
 #include <vector>
-#include <unistd.h>
 
 extern "C" {
 #include "lua.hpp"
@@ -29,10 +28,6 @@ extern "C" {
 
 namespace {
 
-bool is_root_user() {
-    return ::geteuid() == 0;
-}
-
 std::string sanitize_identifier(std::string_view name) {
     std::string sanitized;
     sanitized.reserve(name.size());
@@ -873,7 +868,7 @@ int LuaEngine::invoke_command(const std::string& name, const std::vector<std::st
         return 0;
     }
 
-    if (command->requires_root && !is_root_user()) {
+    if (command->requires_root && !driver_.caller_is_root()) {
         err_ << "exec: command '" << command->name << "' requires root privileges\n";
         return 5;
     }
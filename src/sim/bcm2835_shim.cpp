@@ -0,0 +1,96 @@
+// Stand-in for the subset of libbcm2835 NANDWorks uses, backed by the simulated
+// register file. Linked instead of -lbcm2835 when building with HAL_BACKEND=sim.
+
+#include <bcm2835.h>
+
+#include "sim/nand_model.hpp"
+#include "sim/register_file.hpp"
+
+volatile uint32_t* bcm2835_gpio = sim::register_file().base();
+
+namespace {
+    uint32_t offset_of(volatile uint32_t* paddr) {
+        return static_cast<uint32_t>(paddr - bcm2835_gpio) * 4;
+    }
+}
+
+extern "C" {
+
+int bcm2835_init(void) {
+    sim::RegisterFile& regs = sim::register_file();
+    bcm2835_gpio = regs.base();
+    if (!regs.device()) regs.attach(&sim::default_nand_model());
+    return 1;
+}
+
+int bcm2835_close(void) {
+    return 1;
+}
+
+uint32_t bcm2835_peri_read(volatile uint32_t* paddr) {
+    return sim::register_file().load(offset_of(paddr));
+}
+
+uint32_t bcm2835_peri_read_nb(volatile uint32_t* paddr) {
+    return bcm2835_peri_read(paddr);
+}
+
+void bcm2835_peri_write(volatile uint32_t* paddr, uint32_t value) {
+    sim::register_file().store(offset_of(paddr), value);
+}
+
+void bcm2835_peri_write_nb(volatile uint32_t* paddr, uint32_t value) {
+    bcm2835_peri_write(paddr, value);
+}
+
+void bcm2835_peri_set_bits(volatile uint32_t* paddr, uint32_t value, uint32_t mask) {
+    const uint32_t current = bcm2835_peri_read(paddr);
+    bcm2835_peri_write(paddr, (current & ~mask) | (value & mask));
+}
+
+void bcm2835_gpio_fsel(uint8_t pin, uint8_t mode) {
+    volatile uint32_t* paddr = bcm2835_gpio + BCM2835_GPFSEL0 / 4 + (pin / 10);
+    const uint8_t shift = static_cast<uint8_t>((pin % 10) * 3);
+    bcm2835_peri_set_bits(paddr, static_cast<uint32_t>(mode) << shift,
+                          static_cast<uint32_t>(BCM2835_GPIO_FSEL_MASK) << shift);
+}
+
+void bcm2835_gpio_set(uint8_t pin) {
+    sim::register_file().store(pin < 32 ? BCM2835_GPSET0 : BCM2835_GPSET1, 1u << (pin % 32));
+}
+
+void bcm2835_gpio_clr(uint8_t pin) {
+    sim::register_file().store(pin < 32 ? BCM2835_GPCLR0 : BCM2835_GPCLR1, 1u << (pin % 32));
+}
+
+void bcm2835_gpio_set_multi(uint32_t mask) {
+    sim::register_file().store(BCM2835_GPSET0, mask);
+}
+
+void bcm2835_gpio_clr_multi(uint32_t mask) {
+    sim::register_file().store(BCM2835_GPCLR0, mask);
+}
+
+uint8_t bcm2835_gpio_lev(uint8_t pin) {
+    const uint32_t levels = sim::register_file().load(pin < 32 ? BCM2835_GPLEV0 : BCM2835_GPLEV1);
+    return (levels >> (pin % 32)) & 0x1 ? HIGH : LOW;
+}
+
+void bcm2835_gpio_write(uint8_t pin, uint8_t on) {
+    if (on) {
+        bcm2835_gpio_set(pin);
+    } else {
+        bcm2835_gpio_clr(pin);
+    }
+}
+
+void bcm2835_gpio_write_mask(uint32_t value, uint32_t mask) {
+    bcm2835_gpio_set_multi(value & mask);
+    bcm2835_gpio_clr_multi(~value & mask);
+}
+
+void bcm2835_gpio_set_pud(uint8_t pin, uint8_t pud) {
+    sim::register_file().set_pull(pin, pud);
+}
+
+} // extern "C"
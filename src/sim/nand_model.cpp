@@ -0,0 +1,665 @@
+#include "sim/nand_model.hpp"
+#include "dq_bus.hpp"
+#include "hardware_locations.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sim {
+
+namespace {
+    constexpr uint32_t bit(uint8_t pin) { return static_cast<uint32_t>(1u) << pin; }
+
+    constexpr uint32_t kWe = bit(GPIO_WE);
+    constexpr uint32_t kRe = bit(GPIO_RE);
+    constexpr uint32_t kCle = bit(GPIO_CLE);
+    constexpr uint32_t kAle = bit(GPIO_ALE);
+    constexpr uint32_t kWp = bit(GPIO_WP);
+
+    const uint8_t kId00[] = {0x2C, 0xF1, 0x80, 0x95, 0x02, 0x00, 0x00, 0x00};
+    const uint8_t kIdOnfi[] = {'O', 'N', 'F', 'I', 0x00, 0x00};
+    const char kUniqueIdPrefix[] = "NANDWORKS-SIM-"; // 14 of the 16 bytes
+
+    void put_le16(std::vector<uint8_t>& p, size_t at, uint32_t value) {
+        p[at] = static_cast<uint8_t>(value & 0xFF);
+        p[at + 1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    }
+
+    void put_le32(std::vector<uint8_t>& p, size_t at, uint32_t value) {
+        put_le16(p, at, value & 0xFFFF);
+        put_le16(p, at + 2, value >> 16);
+    }
+
+    void put_text(std::vector<uint8_t>& p, size_t at, size_t width, const char* text) {
+        const size_t len = std::strlen(text);
+        for (size_t i = 0; i < width; ++i) {
+            p[at + i] = static_cast<uint8_t>(i < len ? text[i] : ' ');
+        }
+    }
+
+    // ONFI parameter page CRC-16: polynomial 0x8005, initial value 0x4F4E.
+    uint16_t onfi_crc16(const uint8_t* data, size_t len) {
+        uint16_t crc = 0x4F4E;
+        for (size_t i = 0; i < len; ++i) {
+            crc ^= static_cast<uint16_t>(data[i]) << 8;
+            for (int b = 0; b < 8; ++b) {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x8005) : static_cast<uint16_t>(crc << 1);
+            }
+        }
+        return crc;
+    }
+}
+
+NandModel::NandModel(NandModelConfig config)
+    : config_(std::move(config)) {
+    build_parameter_page();
+    plane_registers_.assign(static_cast<size_t>(1) << config_.plane_address_bits, std::vector<uint8_t>());
+    while ((1u << block_bits_) < config_.blocks) ++block_bits_;
+    luns_.resize(config_.luns == 0 ? 1 : config_.luns);
+    for (LunContext& lun : luns_) lun.plane_registers = plane_registers_;
+    for (uint32_t block : config_.factory_bad_blocks) {
+        std::vector<uint8_t> page(page_bytes(), 0xFF);
+        page[config_.page_size] = 0x00;
+        array_[block * config_.pages_per_block] = std::move(page);
+    }
+}
+
+void NandModel::build_parameter_page() {
+    std::vector<uint8_t>& p = parameter_page_;
+    p.assign(256, 0x00);
+    p[0] = 'O'; p[1] = 'N'; p[2] = 'F'; p[3] = 'I';
+    put_le16(p, 4, 0x007E);            // ONFI 1.0 - 3.0
+    uint32_t features = 0;
+    if (config_.luns > 1) features |= 0x0002;              // multiple LUN operations
+    if (config_.plane_address_bits) features |= 0x0048;    // multi-plane program/erase and read
+    put_le16(p, 6, features);
+    put_le16(p, 8, 0x003F);            // PAGE CACHE PROGRAM, READ CACHE, GET/SET FEATURES,
+                                       // READ STATUS ENHANCED, COPYBACK, READ UNIQUE ID
+    put_text(p, 32, 12, "MICRON");
+    put_text(p, 44, 20, "NANDWORKS SIM SLC");
+    p[64] = 0x2C;
+    put_le32(p, 80, config_.page_size);
+    put_le16(p, 84, config_.spare_size);
+    put_le32(p, 92, config_.pages_per_block);
+    put_le32(p, 96, config_.blocks);
+    p[100] = static_cast<uint8_t>(config_.luns);
+    p[101] = static_cast<uint8_t>((config_.column_cycles << 4) | config_.row_cycles);
+    p[102] = 1;                        // bits per cell
+    put_le16(p, 103, static_cast<uint32_t>(config_.factory_bad_blocks.size()));
+    p[105] = 1; p[106] = 5;            // 10^5 P/E cycles
+    p[110] = 1;                        // programs per page
+    p[112] = 1;                        // ECC bits
+    p[113] = config_.plane_address_bits;
+    p[114] = 0x00;                     // planes share the upper block-address bits
+    p[128] = 10;
+    put_le16(p, 129, 0x003F);          // timing modes 0 - 5
+    put_le16(p, 133, 600);             // tPROG max (us)
+    put_le16(p, 135, 3000);            // tBERS max (us)
+    put_le16(p, 137, 50);              // tR max (us)
+    put_le16(p, 139, 200);             // tCCS min (ns)
+    const uint16_t crc = onfi_crc16(p.data(), 254);
+    put_le16(p, 254, crc);
+
+    // Models of different shape must not share a unique ID, or a host-side parameter
+    // page cache would mix them up; the page CRC stands in for a serial number
+    std::memcpy(unique_id_, kUniqueIdPrefix, 14);
+    unique_id_[14] = static_cast<uint8_t>(crc >> 8);
+    unique_id_[15] = static_cast<uint8_t>(crc & 0xFF);
+}
+
+uint8_t NandModel::status() const {
+    uint8_t value = write_protected_ ? 0x00 : 0x80;
+    if (!busy()) value |= 0x40;
+    if (!array_busy()) value |= 0x20;
+    if (last_failed_) value |= 0x01;
+    if (previous_failed_) value |= 0x02;
+    return value;
+}
+
+std::vector<uint8_t> NandModel::array_page(uint32_t row) const {
+    const auto it = array_.find(row);
+    if (it == array_.end()) return std::vector<uint8_t>(page_bytes(), 0xFF);
+    return it->second;
+}
+
+void NandModel::swap_context(LunContext& c) {
+    std::swap(page_register_, c.page_register);
+    std::swap(cache_register_, c.cache_register);
+    std::swap(plane_registers_, c.plane_registers);
+    std::swap(row_, c.row);
+    std::swap(column_, c.column);
+    std::swap(last_failed_, c.last_failed);
+    std::swap(previous_failed_, c.previous_failed);
+    std::swap(cache_chain_, c.cache_chain);
+    std::swap(cache_output_, c.cache_output);
+    std::swap(out_pos_, c.out_pos);
+    std::swap(busy_samples_, c.busy_samples);
+    std::swap(array_busy_samples_, c.array_busy_samples);
+    std::swap(suspended_samples_, c.suspended_samples);
+    std::swap(suspended_, c.suspended);
+    std::swap(suspendable_, c.suspendable);
+}
+
+void NandModel::select_lun(uint32_t lun) {
+    if (lun == selected_lun_ || lun >= luns_.size()) return;
+    swap_context(luns_[selected_lun_]); // park the selected LUN
+    swap_context(luns_[lun]);           // bring in the new one
+    selected_lun_ = lun;
+}
+
+void NandModel::power_cycle() {
+    pending_ = Pending::None;
+    address_count_ = 0;
+    accepting_data_ = false;
+    last_failed_ = false;
+    previous_failed_ = false;
+    cache_chain_ = false;
+    queued_programs_.clear();
+    queued_reads_.clear();
+    queued_erases_.clear();
+    out_source_ = nullptr;
+    out_pos_ = 0;
+    status_output_ = false;
+    driving_ = false;
+    busy_samples_ = 0;
+    array_busy_samples_ = 0;
+    suspended_samples_ = 0;
+    suspended_ = false;
+    suspendable_ = false;
+    cache_output_ = false;
+    for (LunContext& lun : luns_) {
+        lun.busy_samples = 0;
+        lun.array_busy_samples = 0;
+        lun.suspended_samples = 0;
+        lun.suspended = false;
+        lun.suspendable = false;
+        lun.last_failed = false;
+        lun.previous_failed = false;
+        lun.cache_chain = false;
+        lun.cache_output = false;
+    }
+}
+
+void NandModel::on_pins(uint32_t previous, uint32_t current, uint32_t host_outputs) {
+    write_protected_ = (current & kWp) == 0;
+    if (current & bit(config_.ce_pin)) {
+        driving_ = false;
+        return;
+    }
+
+    if (!(previous & kWe) && (current & kWe)) {
+        const uint8_t value = BoardDqMap::gather(current);
+        const bool cle = current & kCle;
+        const bool ale = current & kAle;
+        if (cle && !ale) {
+            command(value);
+        } else if (ale && !cle) {
+            address(value);
+        } else if (!cle && !ale) {
+            data_in(value);
+        }
+    }
+
+    if ((previous & kRe) && !(current & kRe)) {
+        if (host_outputs & dq_all_mask()) ++stats_.bus_conflicts;
+        out_latch_ = output_byte();
+        driving_ = true;
+    } else if (!(previous & kRe) && (current & kRe) && driving_) {
+        ++stats_.data_out_bytes;
+        if (!status_output_) ++out_pos_;
+        driving_ = false;
+    }
+}
+
+uint32_t NandModel::on_sample(uint32_t host_levels, uint32_t host_outputs, uint32_t& driven) {
+    (void)host_levels;
+    (void)host_outputs;
+    uint32_t busy_luns = busy_samples_ > 0 ? 1 : 0;
+    if (busy_samples_ > 0) --busy_samples_;
+    if (array_busy_samples_ > 0) --array_busy_samples_;
+    for (uint32_t i = 0; i < luns_.size(); ++i) {
+        if (i == selected_lun_) continue;
+        LunContext& lun = luns_[i];
+        if (lun.busy_samples > 0) {
+            ++busy_luns;
+            --lun.busy_samples;
+        }
+        if (lun.array_busy_samples > 0) --lun.array_busy_samples;
+    }
+    if (busy_luns > 1) ++stats_.concurrent_lun_samples;
+    const bool was_busy = busy_luns > 0;
+
+    const uint32_t rb = bit(config_.rb_pin);
+    driven = rb;
+    uint32_t levels = was_busy ? 0 : rb;
+    if (driving_) {
+        driven |= dq_all_mask();
+        levels |= BoardDqMap::spread(out_latch_);
+    }
+    return levels;
+}
+
+uint8_t NandModel::output_byte() const {
+    if (status_output_) return status();
+    if (out_source_ && out_pos_ < out_source_->size()) return (*out_source_)[out_pos_];
+    return 0x00;
+}
+
+void NandModel::stream(const std::vector<uint8_t>& source) {
+    out_source_ = &source;
+    out_pos_ = 0;
+    status_output_ = false;
+}
+
+uint32_t NandModel::decoded_row(size_t first) const {
+    uint32_t row = 0;
+    for (uint8_t i = 0; i < config_.row_cycles; ++i) {
+        row |= static_cast<uint32_t>(address_[first + i]) << (8 * i);
+    }
+    return row;
+}
+
+uint32_t NandModel::decoded_column() const {
+    return static_cast<uint32_t>(address_[0]) | (static_cast<uint32_t>(address_[1]) << 8);
+}
+
+uint32_t NandModel::lun_of(uint32_t row) const {
+    return (row / config_.pages_per_block) >> block_bits_;
+}
+
+bool NandModel::row_in_range(uint32_t row) const {
+    const uint32_t block = row / config_.pages_per_block;
+    return lun_of(row) < luns_.size() && (block & ((1u << block_bits_) - 1)) < config_.blocks;
+}
+
+uint32_t NandModel::plane_of(uint32_t row) const {
+    return (row / config_.pages_per_block) & ((1u << config_.plane_address_bits) - 1);
+}
+
+// One row per plane, all in the same group of planes (upper block-address bits)
+bool NandModel::valid_plane_set(const std::vector<uint32_t>& rows) {
+    if (rows.size() > 1) ++stats_.multi_plane_ops;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        for (size_t j = i + 1; j < rows.size(); ++j) {
+            const uint32_t bi = rows[i] / config_.pages_per_block;
+            const uint32_t bj = rows[j] / config_.pages_per_block;
+            if (plane_of(rows[i]) == plane_of(rows[j]) ||
+                (bi >> config_.plane_address_bits) != (bj >> config_.plane_address_bits)) {
+                ++stats_.plane_conflicts;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void NandModel::load_page(uint32_t row) {
+    ++stats_.page_reads;
+    page_register_ = array_page(row);
+}
+
+// The data register moves to the cache register for output; the array then loads
+// `next_row` into the data register unless the pipeline is ending (3Fh).
+void NandModel::cache_read(uint32_t next_row, bool load_next) {
+    ++stats_.cache_reads;
+    cache_register_ = page_register_;
+    cache_output_ = true;
+    stream(cache_register_);
+    busy_samples_ = config_.cache_busy_samples;
+    if (load_next) {
+        row_ = next_row;
+        load_page(row_);
+        array_busy_samples_ = config_.read_busy_samples;
+    }
+}
+
+bool NandModel::program_page(uint32_t row, const std::vector<uint8_t>& data) {
+    ++stats_.page_programs;
+    if (write_protected_ || !row_in_range(row)) return false;
+    auto it = array_.find(row);
+    if (it == array_.end()) {
+        array_[row] = data;
+    } else {
+        // Programming can only clear bits
+        for (size_t i = 0; i < it->second.size(); ++i) it->second[i] &= data[i];
+    }
+    return true;
+}
+
+void NandModel::commit_programs() {
+    std::vector<uint32_t> rows;
+    for (const auto& queued : queued_programs_) rows.push_back(queued.first);
+    rows.push_back(row_);
+    bool ok = valid_plane_set(rows);
+    if (ok) {
+        for (const auto& queued : queued_programs_) ok = program_page(queued.first, queued.second) && ok;
+        ok = program_page(row_, page_register_) && ok;
+    }
+    queued_programs_.clear();
+    last_failed_ = !ok;
+}
+
+bool NandModel::erase_block(uint32_t row) {
+    ++stats_.block_erases;
+    const uint32_t block = row / config_.pages_per_block;
+    const bool factory_bad = std::find(config_.factory_bad_blocks.begin(), config_.factory_bad_blocks.end(), block)
+                             != config_.factory_bad_blocks.end();
+    if (write_protected_ || !row_in_range(row) || factory_bad) return false;
+    for (uint32_t page = 0; page < config_.pages_per_block; ++page) {
+        array_.erase(block * config_.pages_per_block + page);
+    }
+    return true;
+}
+
+void NandModel::command(uint8_t cmd) {
+    ++stats_.commands;
+    if (config_.suspend_command != 0 && cmd == config_.suspend_command) {
+        // Only a program or erase in progress can be suspended
+        if (busy() && !suspended_ && suspendable_) {
+            ++stats_.suspends;
+            suspended_ = true;
+            suspended_samples_ = busy_samples_;
+            busy_samples_ = config_.suspend_busy_samples;
+        }
+        return;
+    }
+    if (suspended_ && cmd == config_.resume_command && pending_ != Pending::ReadSetup && !busy()) {
+        ++stats_.resumes;
+        suspended_ = false;
+        busy_samples_ = suspended_samples_;
+        suspended_samples_ = 0;
+        suspendable_ = true;
+        return;
+    }
+    if (busy() && cmd != 0x70 && cmd != 0x78 && cmd != 0xFF) {
+        ++stats_.ignored_while_busy;
+        return;
+    }
+    if (cmd != 0x70 && cmd != 0x78) suspendable_ = false;
+
+    switch (cmd) {
+    case 0xFF: // RESET
+        power_cycle();
+        busy_samples_ = config_.read_busy_samples;
+        break;
+    case 0x90: pending_ = Pending::ReadId; address_count_ = 0; break;
+    case 0xEC: pending_ = Pending::ParamPage; address_count_ = 0; break;
+    case 0xED: pending_ = Pending::UniqueId; address_count_ = 0; break;
+    case 0xEE:
+    case 0xD4: pending_ = Pending::GetFeatures; address_count_ = 0; break;
+    case 0xEF:
+    case 0xD5: pending_ = Pending::SetFeatures; address_count_ = 0; break;
+    case 0x70: status_output_ = true; break;
+    case 0x78: pending_ = Pending::StatusEnhanced; address_count_ = 0; break;
+    case 0x00:
+        // Read setup; without a following address it returns to data output
+        pending_ = Pending::ReadSetup;
+        address_count_ = 0;
+        status_output_ = false;
+        break;
+    case 0x30:
+    case 0x35: // COPYBACK READ loads the page register the same way
+        if (pending_ == Pending::ReadSetup && address_count_ >= config_.column_cycles + config_.row_cycles) {
+            if (cmd == 0x35) ++stats_.copyback_reads;
+            // Queued planes (32h) load together with this one
+            std::vector<uint32_t> rows = queued_reads_;
+            rows.push_back(row_);
+            queued_reads_.clear();
+            if (valid_plane_set(rows)) {
+                for (uint32_t row : rows) {
+                    load_page(row);
+                    plane_registers_[plane_of(row)] = page_register_;
+                }
+            }
+            cache_output_ = false;
+            stream(page_register_);
+            out_pos_ = column_;
+            busy_samples_ = config_.read_busy_samples;
+        }
+        pending_ = Pending::None;
+        break;
+    case 0x32:
+        if (pending_ == Pending::ReadSetup && address_count_ >= config_.column_cycles + config_.row_cycles) {
+            queued_reads_.push_back(row_);
+            busy_samples_ = config_.cache_busy_samples;
+        }
+        pending_ = Pending::None;
+        break;
+    case 0x06: pending_ = Pending::SelectPlane; address_count_ = 0; break;
+    case 0x31:
+        if (pending_ == Pending::ReadSetup && address_count_ >= config_.column_cycles + config_.row_cycles) {
+            cache_read(row_, true); // random: 00h-addr-31h, row_ latched from the address
+        } else {
+            cache_read(row_ + 1, true);
+        }
+        pending_ = Pending::None;
+        break;
+    case 0x3F:
+        cache_read(row_, false);
+        pending_ = Pending::None;
+        break;
+    case 0x05: pending_ = Pending::ChangeReadColumn; address_count_ = 0; break;
+    case 0xE0:
+        if (pending_ == Pending::ChangeReadColumn && address_count_ >= config_.column_cycles) {
+            stream(read_register());
+            out_pos_ = column_;
+        } else if (pending_ == Pending::SelectPlane && address_count_ >= config_.column_cycles + config_.row_cycles) {
+            page_register_ = plane_registers_[plane_of(row_)];
+            cache_output_ = false;
+            stream(page_register_);
+            out_pos_ = column_;
+        }
+        pending_ = Pending::None;
+        break;
+    case 0x80:
+        pending_ = Pending::Program;
+        address_count_ = 0;
+        accepting_data_ = false;
+        break;
+    case 0x85:
+        pending_ = Pending::ChangeWriteColumn;
+        address_count_ = 0;
+        accepting_data_ = false;
+        break;
+    case 0x10:
+    case 0x1A:
+        if (pending_ == Pending::Program || pending_ == Pending::ChangeWriteColumn) {
+            // FAILC only carries over within a cache program chain
+            previous_failed_ = cache_chain_ && last_failed_;
+            cache_chain_ = false;
+            commit_programs();
+            // R/B# also covers a cached program still running in the array
+            busy_samples_ = config_.program_busy_samples + array_busy_samples_;
+            array_busy_samples_ = 0;
+            suspendable_ = true;
+        }
+        pending_ = Pending::None;
+        accepting_data_ = false;
+        break;
+    case 0x15:
+        if (pending_ == Pending::Program || pending_ == Pending::ChangeWriteColumn) {
+            // The cache register frees once the array has finished the previous page
+            ++stats_.cache_programs;
+            previous_failed_ = cache_chain_ && last_failed_;
+            cache_chain_ = true;
+            commit_programs();
+            busy_samples_ = config_.cache_busy_samples + array_busy_samples_;
+            array_busy_samples_ = config_.program_busy_samples;
+        }
+        pending_ = Pending::None;
+        accepting_data_ = false;
+        break;
+    case 0x11:
+        if (pending_ == Pending::Program || pending_ == Pending::ChangeWriteColumn) {
+            queued_programs_.emplace_back(row_, page_register_);
+            busy_samples_ = config_.cache_busy_samples;
+        }
+        pending_ = Pending::None;
+        accepting_data_ = false;
+        break;
+    case 0x60:
+        // A second 60h before D0h queues the previous block for a multi-plane erase
+        if (pending_ == Pending::Erase && address_count_ >= config_.row_cycles) {
+            queued_erases_.push_back(decoded_row(0));
+        } else {
+            queued_erases_.clear();
+        }
+        pending_ = Pending::Erase;
+        address_count_ = 0;
+        break;
+    case 0xD0:
+        if (pending_ == Pending::Erase && address_count_ >= config_.row_cycles) {
+            std::vector<uint32_t> rows = queued_erases_;
+            rows.push_back(decoded_row(0));
+            bool ok = valid_plane_set(rows);
+            if (ok) {
+                for (uint32_t row : rows) ok = erase_block(row) && ok;
+            }
+            last_failed_ = !ok;
+            busy_samples_ = config_.erase_busy_samples;
+            suspendable_ = true;
+        }
+        queued_erases_.clear();
+        pending_ = Pending::None;
+        break;
+    case 0x01:
+    case 0x02:
+    case 0x03:
+        break; // TLC page-select prefixes; meaningless on this SLC model
+    default:
+        ++stats_.unknown_commands;
+        pending_ = Pending::None;
+        break;
+    }
+}
+
+void NandModel::address(uint8_t value) {
+    ++stats_.address_cycles;
+    if (address_count_ < sizeof(address_)) address_[address_count_++] = value;
+    address_complete();
+}
+
+void NandModel::address_complete() {
+    const uint8_t full = static_cast<uint8_t>(config_.column_cycles + config_.row_cycles);
+    switch (pending_) {
+    case Pending::ReadId:
+        if (address_[0] == 0x00) {
+            scratch_.assign(kId00, kId00 + sizeof(kId00));
+        } else if (address_[0] == 0x20) {
+            scratch_.assign(kIdOnfi, kIdOnfi + sizeof(kIdOnfi));
+        } else {
+            scratch_.assign(8, 0x00);
+        }
+        stream(scratch_);
+        pending_ = Pending::None;
+        break;
+    case Pending::ParamPage:
+        ++stats_.parameter_page_reads;
+        scratch_.clear();
+        if (address_[0] == 0x00) {
+            for (uint32_t copy = 0; copy < 3; ++copy) {
+                scratch_.insert(scratch_.end(), parameter_page_.begin(), parameter_page_.end());
+                if (copy < config_.corrupt_parameter_copies) scratch_[copy * 256 + 80] ^= 0x01;
+            }
+        } else {
+            scratch_.assign(256, 0x00); // no JEDEC page
+        }
+        stream(scratch_);
+        busy_samples_ = config_.read_busy_samples;
+        pending_ = Pending::None;
+        break;
+    case Pending::UniqueId:
+        scratch_.clear();
+        for (int copy = 0; copy < 16; ++copy) {
+            for (int i = 0; i < 16; ++i) scratch_.push_back(unique_id_[i]);
+            for (int i = 0; i < 16; ++i) scratch_.push_back(static_cast<uint8_t>(~unique_id_[i]));
+        }
+        stream(scratch_);
+        busy_samples_ = config_.read_busy_samples;
+        pending_ = Pending::None;
+        break;
+    case Pending::GetFeatures:
+        scratch_.assign(features_[address_[0]], features_[address_[0]] + 4);
+        stream(scratch_);
+        busy_samples_ = config_.read_busy_samples;
+        pending_ = Pending::None;
+        break;
+    case Pending::SetFeatures:
+        feature_address_ = address_[0];
+        feature_count_ = 0;
+        break;
+    case Pending::ReadSetup:
+        if (address_count_ == full) {
+            select_lun(lun_of(decoded_row(config_.column_cycles)));
+            column_ = decoded_column();
+            row_ = decoded_row(config_.column_cycles);
+        }
+        break;
+    case Pending::ChangeReadColumn:
+        if (address_count_ == config_.column_cycles) column_ = decoded_column();
+        break;
+    case Pending::SelectPlane:
+        if (address_count_ == full) {
+            select_lun(lun_of(decoded_row(config_.column_cycles)));
+            column_ = decoded_column();
+            row_ = decoded_row(config_.column_cycles);
+        }
+        break;
+    case Pending::Program:
+        if (address_count_ == full) {
+            select_lun(lun_of(decoded_row(config_.column_cycles)));
+            column_ = decoded_column();
+            row_ = decoded_row(config_.column_cycles);
+            page_register_.assign(page_bytes(), 0xFF);
+            accepting_data_ = true;
+        }
+        break;
+    case Pending::ChangeWriteColumn:
+        if (address_count_ == config_.column_cycles) {
+            column_ = decoded_column();
+            accepting_data_ = true;
+        } else if (address_count_ == full) {
+            // COPYBACK PROGRAM: a full address keeps the page register and retargets it.
+            // The register belongs to the source plane, so the row must be on it too.
+            const uint32_t row = decoded_row(config_.column_cycles);
+            if (plane_of(row) != plane_of(row_) || lun_of(row) != selected_lun_) ++stats_.plane_conflicts;
+            row_ = row;
+            ++stats_.copyback_programs;
+        }
+        break;
+    case Pending::StatusEnhanced:
+        if (address_count_ == config_.row_cycles) {
+            select_lun(lun_of(decoded_row(0)));
+            status_output_ = true;
+            pending_ = Pending::None;
+        }
+        break;
+    case Pending::Erase:
+        if (address_count_ == config_.row_cycles) select_lun(lun_of(decoded_row(0)));
+        break;
+    case Pending::None:
+        break;
+    }
+}
+
+void NandModel::data_in(uint8_t value) {
+    ++stats_.data_in_bytes;
+    if (pending_ == Pending::SetFeatures) {
+        features_[feature_address_][feature_count_++] = value;
+        if (feature_count_ == 4) {
+            busy_samples_ = config_.read_busy_samples;
+            pending_ = Pending::None;
+        }
+        return;
+    }
+    if (accepting_data_ && column_ < page_register_.size()) {
+        page_register_[column_++] = value;
+    }
+}
+
+NandModel& default_nand_model() {
+    static NandModel model;
+    return model;
+}
+
+} // namespace sim
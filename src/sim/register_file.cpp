@@ -0,0 +1,138 @@
+#include "sim/register_file.hpp"
+
+#include <bcm2835.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace sim {
+
+RegisterFile::RegisterFile() {
+    std::memset(words_, 0, sizeof(words_));
+}
+
+void RegisterFile::refresh_outputs() {
+    uint32_t outputs = 0;
+    for (uint8_t pin = 0; pin < 32; ++pin) {
+        const uint32_t fsel = words_[(BCM2835_GPFSEL0 / 4) + pin / 10];
+        const uint32_t mode = (fsel >> ((pin % 10) * 3)) & BCM2835_GPIO_FSEL_MASK;
+        if (mode == BCM2835_GPIO_FSEL_OUTP) outputs |= static_cast<uint32_t>(1u) << pin;
+    }
+    outputs0_ = outputs;
+}
+
+uint32_t RegisterFile::host_levels0() const {
+    return (latch0_ & outputs0_) | (pull_up0_ & ~outputs0_);
+}
+
+void RegisterFile::notify() {
+    const uint32_t current = host_levels0();
+    if (current == last_host_) return;
+    const uint32_t previous = last_host_;
+    last_host_ = current;
+    if (device_) device_->on_pins(previous, current, outputs0_);
+}
+
+void RegisterFile::store(uint32_t offset, uint32_t value) {
+    switch (offset) {
+    case BCM2835_GPSET0:
+        ++counters_.set_stores;
+        latch0_ |= value;
+        break;
+    case BCM2835_GPCLR0:
+        ++counters_.clr_stores;
+        latch0_ &= ~value;
+        break;
+    case BCM2835_GPSET1:
+        ++counters_.set_stores;
+        latch1_ |= value;
+        break;
+    case BCM2835_GPCLR1:
+        ++counters_.clr_stores;
+        latch1_ &= ~value;
+        break;
+    case BCM2835_GPFSEL0:
+    case BCM2835_GPFSEL1:
+    case BCM2835_GPFSEL2:
+    case BCM2835_GPFSEL3:
+    case BCM2835_GPFSEL4:
+    case BCM2835_GPFSEL5:
+        ++counters_.fsel_stores;
+        words_[offset / 4] = value;
+        refresh_outputs();
+        break;
+    default:
+        ++counters_.other;
+        if (offset / 4 < kWords) words_[offset / 4] = value;
+        return;
+    }
+    notify();
+}
+
+uint32_t RegisterFile::load(uint32_t offset) {
+    switch (offset) {
+    case BCM2835_GPLEV0: {
+        ++counters_.level_loads;
+        const uint32_t host = host_levels0();
+        if (!device_) return host;
+        uint32_t driven = 0;
+        const uint32_t device_levels = device_->on_sample(host, outputs0_, driven);
+        return (host & ~driven) | (device_levels & driven);
+    }
+    case BCM2835_GPLEV1:
+        ++counters_.level_loads;
+        return latch1_;
+    case BCM2835_GPSET0:
+    case BCM2835_GPCLR0:
+    case BCM2835_GPSET1:
+    case BCM2835_GPCLR1:
+        ++counters_.other;
+        return 0; // write-only
+    default:
+        ++counters_.other;
+        return offset / 4 < kWords ? words_[offset / 4] : 0;
+    }
+}
+
+void RegisterFile::set_pull(uint8_t pin, uint8_t pud) {
+    if (pin >= 32) return;
+    const uint32_t mask = static_cast<uint32_t>(1u) << pin;
+    if (pud == BCM2835_GPIO_PUD_UP) {
+        pull_up0_ |= mask;
+    } else {
+        pull_up0_ &= ~mask;
+    }
+    notify();
+}
+
+void RegisterFile::attach(PinDevice* device) {
+    device_ = device;
+    last_host_ = host_levels0();
+}
+
+void PinBus::add(PinDevice* device) {
+    if (count_ == kMaxDevices) throw std::length_error("too many devices on the simulated bus");
+    devices_[count_++] = device;
+}
+
+void PinBus::on_pins(uint32_t previous, uint32_t current, uint32_t host_outputs) {
+    for (size_t i = 0; i < count_; ++i) devices_[i]->on_pins(previous, current, host_outputs);
+}
+
+uint32_t PinBus::on_sample(uint32_t host_levels, uint32_t host_outputs, uint32_t& driven) {
+    driven = 0;
+    uint32_t levels = ~static_cast<uint32_t>(0);
+    for (size_t i = 0; i < count_; ++i) {
+        uint32_t device_driven = 0;
+        const uint32_t device_levels = devices_[i]->on_sample(host_levels, host_outputs, device_driven);
+        levels &= device_levels | ~device_driven;
+        driven |= device_driven;
+    }
+    return levels & driven;
+}
+
+RegisterFile& register_file() {
+    static RegisterFile instance;
+    return instance;
+}
+
+} // namespace sim
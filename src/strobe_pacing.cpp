@@ -0,0 +1,88 @@
+#include "strobe_pacing.hpp"
+#include "gpio_regs.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // ONFI 4.x SDR timing table, modes 0..5 (ns)
+    const OnfiAsyncTiming kModes[] = {
+        //mode tWP tWH tWC  tDS tDH tRP tREH tRC  tREA
+        {0,    50, 30, 100, 40, 20, 50, 30,  100, 40},
+        {1,    25, 15, 45,  20, 10, 25, 15,  50,  30},
+        {2,    17, 15, 35,  15, 5,  17, 15,  35,  25},
+        {3,    15, 10, 30,  10, 5,  15, 10,  30,  20},
+        {4,    12, 10, 25,  10, 5,  12, 10,  25,  20},
+        {5,    10, 7,  20,  7,  5,  10, 7,   20,  16},
+    };
+
+    constexpr uint32_t kDelayCalibrationCycles = 200000;
+    constexpr int kAccessCalibrationCount = 20000;
+
+    StrobeCalibration calibrate() {
+        StrobeCalibration c{};
+
+        uint64_t start = get_timestamp_ns();
+        busy_wait_cycles(kDelayCalibrationCycles);
+        c.ns_per_delay_cycle = static_cast<double>(get_timestamp_ns() - start) / kDelayCalibrationCycles;
+
+        // A store of 0 to GPSET0 changes no pin but costs the same bus write
+        gpio_reg_barrier();
+        start = get_timestamp_ns();
+        for (int i = 0; i < kAccessCalibrationCount; ++i) gpio_reg_set0(0);
+        gpio_reg_barrier();
+        c.ns_per_store = static_cast<double>(get_timestamp_ns() - start) / kAccessCalibrationCount;
+
+        volatile uint32_t sink = 0;
+        start = get_timestamp_ns();
+        for (int i = 0; i < kAccessCalibrationCount; ++i) sink = gpio_reg_levels0();
+        (void)sink;
+        c.ns_per_load = static_cast<double>(get_timestamp_ns() - start) / kAccessCalibrationCount;
+        return c;
+    }
+
+    // Cycles covering `needed_ns` beyond what the loop already spends
+    uint32_t pad_cycles(double needed_ns, double natural_ns, double ns_per_cycle) {
+        const double missing = needed_ns - natural_ns;
+        if (missing <= 0.0 || ns_per_cycle <= 0.0) return 0;
+        return static_cast<uint32_t>(std::ceil(missing / ns_per_cycle));
+    }
+}
+
+const OnfiAsyncTiming& onfi_async_timing(uint8_t mode) {
+    if (mode >= sizeof(kModes) / sizeof(kModes[0])) {
+        throw std::out_of_range("ONFI timing mode must be 0..5");
+    }
+    return kModes[mode];
+}
+
+const StrobeCalibration& strobe_calibration() {
+    static const StrobeCalibration calibration = calibrate();
+    return calibration;
+}
+
+StrobePacing make_strobe_pacing(const OnfiAsyncTiming& t, const StrobeCalibration& c) {
+    StrobePacing p;
+    p.mode = t.mode;
+    const double s = c.ns_per_store;
+    const double cyc = c.ns_per_delay_cycle;
+
+    // Data-in/command/address cycle: [clr WE#+zeros] [set ones] (pad) [set WE#] (pad).
+    // WE# is low for two store slots, the full byte is set up for one, and WE# high
+    // plus data hold last one slot until the next cycle's first store.
+    const double we_low_ns = std::max<double>(t.t_wp - 2.0 * s, t.t_ds - s);
+    p.we_low = pad_cycles(we_low_ns, 0.0, cyc);
+    const double we_high_ns = std::max<double>(t.t_wh, t.t_dh);
+    p.we_high = pad_cycles(we_high_ns, s, cyc);
+    const double write_cycle = 3.0 * s + (p.we_low + p.we_high) * cyc;
+    if (write_cycle < t.t_wc) p.we_high += pad_cycles(t.t_wc, write_cycle, cyc);
+
+    // Data-out cycle: [clr RE#] (pad) [load GPLEV0] [set RE#] (pad).
+    // DQ must be valid (tREA) by the sample and RE# low for tRP in total.
+    p.re_low = pad_cycles(std::max<double>(t.t_rea, t.t_rp), c.ns_per_load, cyc);
+    p.re_high = pad_cycles(t.t_reh, s, cyc);
+    const double read_cycle = 2.0 * s + c.ns_per_load + (p.re_low + p.re_high) * cyc;
+    if (read_cycle < t.t_rc) p.re_high += pad_cycles(t.t_rc, read_cycle, cyc);
+    return p;
+}
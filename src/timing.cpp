@@ -1,17 +1,197 @@
 #include "timing.hpp"
+#include <cstdlib>
+#include <cstring>
 #include <time.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace {
+    // Length of the calibration window against CLOCK_MONOTONIC_RAW
+    constexpr uint64_t kCalibrationWindowNs = 2000000;
+    // Architected counter frequency (CNTFRQ) is trusted when calibration agrees this closely
+    constexpr double kNominalTolerance = 0.01;
+    constexpr int kReadCostSamples = 1000;
+
+    struct Timebase {
+        bool counter = false;
+        uint64_t base_ticks = 0;
+        uint64_t base_ns = 0;
+        uint64_t ns_mult = 0;   // ns per tick, 32.32 fixed point
+        uint64_t tick_mult = 0; // ticks per ns, 32.32 fixed point
+        TimebaseInfo info{"clock_gettime", 1000000000ull, 1.0, 0.0};
+    };
+
+    inline uint64_t clock_raw_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    // (value * mult) >> 32 without losing the high bits of the product
+    inline uint64_t mul_shift(uint64_t value, uint64_t mult) {
+#if defined(__SIZEOF_INT128__)
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(value) * mult) >> 32);
+#else
+        const uint64_t v_hi = value >> 32, v_lo = value & 0xFFFFFFFFu;
+        const uint64_t m_hi = mult >> 32, m_lo = mult & 0xFFFFFFFFu;
+        return ((v_hi * m_hi) << 32) + v_hi * m_lo + v_lo * m_hi + ((v_lo * m_lo) >> 32);
+#endif
+    }
+
+#if defined(__aarch64__)
+    constexpr const char* kCounterName = "cntvct";
+
+    inline uint64_t read_counter() {
+        uint64_t value;
+        asm volatile("isb; mrs %0, cntvct_el0" : "=r"(value) :: "memory");
+        return value;
+    }
+
+    uint64_t nominal_frequency() {
+        uint64_t value;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(value));
+        return value;
+    }
+
+    bool counter_usable() {
+        return true;
+    }
+#elif defined(__x86_64__)
+    constexpr const char* kCounterName = "tsc";
+
+    inline uint64_t read_counter() {
+        _mm_lfence();
+        return __rdtsc();
+    }
+
+    uint64_t nominal_frequency() {
+        return 0;
+    }
+
+    // Only an invariant TSC ticks at a constant rate across P-states and idle
+    bool counter_usable() {
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+        return (edx & (1u << 8)) != 0;
+    }
+#else
+    constexpr const char* kCounterName = "none";
+
+    inline uint64_t read_counter() {
+        return 0;
+    }
+
+    uint64_t nominal_frequency() {
+        return 0;
+    }
+
+    bool counter_usable() {
+        return false;
+    }
+#endif
+
+    // Counter value paired with the middle of the tightest clock_gettime bracket
+    void paired_sample(uint64_t& ticks, uint64_t& ns) {
+        uint64_t best_gap = UINT64_MAX;
+        for (int i = 0; i < 5; ++i) {
+            const uint64_t before = clock_raw_ns();
+            const uint64_t t = read_counter();
+            const uint64_t after = clock_raw_ns();
+            if (after - before < best_gap) {
+                best_gap = after - before;
+                ticks = t;
+                ns = before + (after - before) / 2;
+            }
+        }
+    }
+
+    inline uint64_t counter_ns(const Timebase& tb) {
+        const uint64_t t = read_counter();
+        return tb.base_ns + (t > tb.base_ticks ? mul_shift(t - tb.base_ticks, tb.ns_mult) : 0);
+    }
+
+    void measure_read_cost(Timebase& tb) {
+        volatile uint64_t sink = 0;
+        const uint64_t start = clock_raw_ns();
+        for (int i = 0; i < kReadCostSamples; ++i) {
+            sink = tb.counter ? counter_ns(tb) : clock_raw_ns();
+        }
+        (void)sink;
+        tb.info.read_cost_ns = static_cast<double>(clock_raw_ns() - start) / kReadCostSamples;
+    }
+
+    Timebase calibrate() {
+        Timebase tb;
+        struct timespec res;
+        if (clock_getres(CLOCK_MONOTONIC_RAW, &res) == 0) {
+            tb.info.resolution_ns = static_cast<double>(res.tv_sec) * 1e9 + static_cast<double>(res.tv_nsec);
+        }
+
+        const char* env = std::getenv("ONFI_TIMEBASE");
+        const bool forced_clock = env && std::strcmp(env, "clock") == 0;
+        if (forced_clock || !counter_usable()) {
+            measure_read_cost(tb);
+            return tb;
+        }
+
+        uint64_t t0 = 0, ns0 = 0, t1 = 0, ns1 = 0;
+        paired_sample(t0, ns0);
+        while (clock_raw_ns() - ns0 < kCalibrationWindowNs) {
+        }
+        paired_sample(t1, ns1);
+        if (t1 <= t0 || ns1 <= ns0) {
+            measure_read_cost(tb);
+            return tb;
+        }
+
+        uint64_t frequency = static_cast<uint64_t>(
+            static_cast<double>(t1 - t0) * 1e9 / static_cast<double>(ns1 - ns0));
+        const uint64_t nominal = nominal_frequency();
+        if (nominal != 0) {
+            const double error = (static_cast<double>(frequency) - static_cast<double>(nominal)) / static_cast<double>(nominal);
+            if (error < kNominalTolerance && error > -kNominalTolerance) frequency = nominal;
+        }
+
+        tb.counter = true;
+        tb.base_ticks = t1;
+        tb.base_ns = ns1;
+        tb.ns_mult = static_cast<uint64_t>(1e9 * 4294967296.0 / static_cast<double>(frequency));
+        tb.tick_mult = static_cast<uint64_t>(static_cast<double>(frequency) * 4294967296.0 / 1e9);
+        tb.info.source = kCounterName;
+        tb.info.frequency_hz = frequency;
+        tb.info.resolution_ns = 1e9 / static_cast<double>(frequency);
+        measure_read_cost(tb);
+        return tb;
+    }
+
+    const Timebase& timebase() {
+        static const Timebase tb = calibrate();
+        return tb;
+    }
+}
+
 // Get a timestamp in nanoseconds.
 uint64_t get_timestamp_ns() {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
-    return ts.tv_sec * 1000000000 + ts.tv_nsec;
+    const Timebase& tb = timebase();
+    if (!tb.counter) return clock_raw_ns();
+    return counter_ns(tb);
 }
 
 // Busy-wait for a specific number of nanoseconds.
 void busy_wait_ns(uint64_t ns) {
-    uint64_t start = get_timestamp_ns();
-    while (get_timestamp_ns() - start < ns);
+    const Timebase& tb = timebase();
+    if (!tb.counter) {
+        const uint64_t start = clock_raw_ns();
+        while (clock_raw_ns() - start < ns);
+        return;
+    }
+    // Compare raw ticks so the loop does no conversion per iteration
+    const uint64_t ticks = mul_shift(ns, tb.tick_mult);
+    const uint64_t start = read_counter();
+    while (read_counter() - start < ticks);
 }
 
 // Busy-wait for a specific number of cycles.
@@ -19,4 +199,8 @@ void busy_wait_cycles(uint32_t cycles) {
     for (uint32_t i = 0; i < cycles; ++i) {
         asm volatile("nop");
     }
-}
\ No newline at end of file
+}
+
+const TimebaseInfo& timebase_info() {
+    return timebase().info;
+}
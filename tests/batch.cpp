@@ -0,0 +1,118 @@
+#include "nandworks/command_context.hpp"
+#include "nandworks/command_registry.hpp"
+#include "nandworks/commands/batch.hpp"
+#include "nandworks/dispatch.hpp"
+#include "nandworks/driver_context.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace nandworks;
+
+namespace {
+
+int run_batch(CommandRegistry& registry, DriverContext& driver, const std::vector<std::string>& args,
+              std::string& out_text, std::string& err_text) {
+    std::ostringstream out, err;
+    const int status = dispatch_command(registry, driver, "batch", args, false, out, err);
+    out_text = out.str();
+    err_text = err.str();
+    return status;
+}
+
+} // namespace
+
+int main() {
+    ::setenv("NANDWORKS_NO_DAEMON", "1", 1);
+
+    int calls = 0;
+    CommandRegistry registry;
+    commands::register_batch_commands(registry);
+    registry.register_command(Command{
+        .name = "echo",
+        .aliases = {},
+        .summary = "",
+        .description = "",
+        .usage = "echo [words...]",
+        .options = {},
+        .min_positionals = 0,
+        .max_positionals = static_cast<std::size_t>(-1),
+        .safety = CommandSafety::Safe,
+        .requires_session = true,
+        .requires_root = false,
+        .handler = [&calls](const CommandContext& context) {
+            ++calls;
+            for (const auto& word : context.arguments.positionals()) context.out << word << '|';
+            return 0;
+        },
+    });
+    registry.register_command(Command{
+        .name = "fail",
+        .aliases = {},
+        .summary = "",
+        .description = "",
+        .usage = "fail",
+        .options = {},
+        .min_positionals = 0,
+        .max_positionals = 0,
+        .safety = CommandSafety::Safe,
+        .requires_session = true,
+        .requires_root = false,
+        .handler = [](const CommandContext& context) -> int {
+            context.err << "bad\n";
+            throw std::runtime_error("boom");
+        },
+    });
+
+    const std::string path = "/tmp/nandworks_batch_test." + std::to_string(::getpid()) + ".txt";
+    {
+        std::ofstream file(path);
+        file << "# comment line\n"
+             << "echo 'a b' c\n"
+             << "\n"
+             << "fail\n"
+             << "echo \"q\\\"\" \\x01\n"
+             << "batch nested\n"
+             << "missing\n";
+    }
+
+    DriverContext driver(false);
+    std::string out, err;
+
+    // Stops at the first failure, which the handler's exception maps to 4
+    assert(run_batch(registry, driver, {path}, out, err) == 4);
+    assert(calls == 1);
+    assert(out == "a b|c|");
+    assert(err.find("[batch:2] echo -> 0") != std::string::npos);
+    assert(err.find("[batch:4] fail -> 4") != std::string::npos);
+    assert(err.find("Batch: 2 commands, 1 failed.") != std::string::npos);
+
+    // JSON Lines with output captured per line and every line run
+    calls = 0;
+    assert(run_batch(registry, driver, {"--json", "--continue-on-error", path}, out, err) == 4);
+    assert(calls == 2);
+    assert(err.empty());
+    std::istringstream lines(out);
+    std::vector<std::string> records;
+    for (std::string line; std::getline(lines, line);) records.push_back(line);
+    assert(records.size() == 5);
+    assert(records[0].find("{\"line\":2,\"command\":\"echo\",\"status\":0,") == 0);
+    assert(records[0].find("\"stdout\":\"a b|c|\",\"stderr\":\"\"}") != std::string::npos);
+    assert(records[1].find("\"line\":4,\"command\":\"fail\",\"status\":4,") != std::string::npos);
+    assert(records[1].find("\"stderr\":\"bad\\nCommand 'fail' failed: boom\\n\"") != std::string::npos);
+    assert(records[2].find("\"stdout\":\"q\\\"|x01|\"") != std::string::npos);
+    assert(records[3].find("\"command\":\"batch\",\"status\":2,") != std::string::npos);
+    assert(records[4].find("\"command\":\"missing\",\"status\":2,") != std::string::npos);
+
+    assert(run_batch(registry, driver, {"/nonexistent/batch.txt"}, out, err) == 4);
+
+    ::unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "nandworks/command_context.hpp"
+#include "nandworks/command_registry.hpp"
+#include "nandworks/commands/batch.hpp"
+#include "nandworks/daemon.hpp"
+#include "nandworks/driver_context.hpp"
+
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace nandworks;
+
+int main() {
+    CommandRegistry registry;
+    registry.register_command(Command{
+        .name = "echo",
+        .aliases = {},
+        .summary = "",
+        .description = "",
+        .usage = "echo --tag <t> [words...]",
+        .options = {OptionSpec{"tag", 't', true, true, false, "t", ""}},
+        .min_positionals = 0,
+        .max_positionals = static_cast<std::size_t>(-1),
+        .safety = CommandSafety::Safe,
+        .requires_session = true,
+        .requires_root = false,
+        .handler = [](const CommandContext& context) {
+            // Binary payload, then text on both streams
+            const char raw[] = {'\0', '\x01', '\xFF', '\n'};
+            context.out.write(raw, sizeof(raw));
+            context.out << *context.arguments.value("tag");
+            for (const auto& word : context.arguments.positionals()) context.out << ' ' << word;
+            context.err << (context.verbose ? "verbose" : "quiet");
+            return 7;
+        },
+    });
+    registry.register_command(Command{
+        .name = "privileged",
+        .aliases = {},
+        .summary = "",
+        .description = "",
+        .usage = "privileged",
+        .options = {},
+        .min_positionals = 0,
+        .max_positionals = 0,
+        .safety = CommandSafety::Safe,
+        .requires_session = false,
+        .requires_root = true,
+        .handler = [](const CommandContext& context) {
+            context.out << "ran";
+            return 0;
+        },
+    });
+
+    // Stands in for `script`/`batch`: no session of its own, open to any local user
+    registry.register_command(Command{
+        .name = "runner",
+        .aliases = {},
+        .summary = "",
+        .description = "",
+        .usage = "runner",
+        .options = {},
+        .min_positionals = 0,
+        .max_positionals = 0,
+        .safety = CommandSafety::Safe,
+        .requires_session = false,
+        .requires_root = false,
+        .handler = [](const CommandContext&) { return 0; },
+    });
+
+    commands::register_batch_commands(registry);
+
+    const std::string path = "/tmp/nandworks_daemon_test." + std::to_string(::getpid()) + ".sock";
+    assert(connect_daemon(path) < 0);
+
+    DriverContext driver(false);
+    DaemonServer server(registry, driver, path);
+    server.set_client_timeout_ms(200);
+    server.listen(0666);  // reachable by the unprivileged client below
+    assert(!driver.forwards_to_daemon());
+
+    // A second daemon on the same socket is refused
+    bool refused = false;
+    try {
+        DaemonServer(registry, driver, path).listen();
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    assert(refused);
+
+    // A client that stalls mid-header is dropped once the timeout expires instead of
+    // holding up the requests queued behind it
+    const int stalled = connect_daemon(path);
+    assert(stalled >= 0);
+    assert(::send(stalled, "\x10\x00", 2, 0) == 2);
+
+    // The child serves; the probe and stalled connections are dropped without a request
+    const bool root = ::geteuid() == 0;
+    const unsigned long requests = root ? 10 : 6;
+    const pid_t child = ::fork();
+    assert(child >= 0);
+    if (child == 0) {
+        while (server.served() < requests) server.serve_next();
+        ::_exit(0);
+    }
+
+    {
+        std::ostringstream out, err;
+        DaemonRequest request;
+        request.verbose = true;
+        request.command = "echo";
+        request.args = {"--tag", "x", "a", "b"};
+        const int fd = connect_daemon(path);
+        assert(fd >= 0);
+        assert(forward_command(fd, request, out, err) == 7);
+        assert(out.str() == std::string("\0\x01\xFF\nx a b", 9));
+        assert(err.str() == "verbose");
+    }
+    {
+        std::ostringstream out, err;
+        DaemonRequest request;
+        request.command = "echo";
+        assert(forward_command(connect_daemon(path), request, out, err) == 3);
+        assert(err.str().find("--tag") != std::string::npos);
+    }
+    {
+        std::ostringstream out, err;
+        DaemonRequest request;
+        request.command = "missing";
+        assert(forward_command(connect_daemon(path), request, out, err) == 2);
+    }
+
+    char byte;
+    assert(::recv(stalled, &byte, 1, 0) == 0);
+    ::close(stalled);
+
+    // Root-only commands follow the client's credentials, not the daemon's
+    {
+        std::ostringstream out, err;
+        DaemonRequest request;
+        request.command = "privileged";
+        assert(forward_command(connect_daemon(path), request, out, err) == (root ? 0 : 5));
+    }
+    {
+        std::ostringstream out, err;
+        DaemonRequest request;
+        request.command = "runner";
+        assert(forward_command(connect_daemon(path), request, out, err) == (root ? 0 : 5));
+    }
+    // A forwarded batch runs its lines on the daemon's session instead of connecting
+    // back to the daemon's own socket
+    {
+        const std::string batch_path = path + ".batch";
+        std::ofstream(batch_path) << "echo --tag y\n";
+        std::ostringstream out, err;
+        DaemonRequest request;
+        request.command = "batch";
+        request.args = {batch_path};
+        assert(forward_command(connect_daemon(path), request, out, err) == (root ? 7 : 5));
+        if (root) assert(out.str().find('y') != std::string::npos);
+        ::unlink(batch_path.c_str());
+    }
+    if (root) {
+        std::ostringstream out, err;
+        DaemonRequest request;
+        request.cwd = "/nonexistent";
+        request.command = "echo";
+        request.args = {"--tag", "x"};
+        assert(forward_command(connect_daemon(path), request, out, err) == 1);
+    }
+    if (root) {
+        const pid_t unprivileged = ::fork();
+        assert(unprivileged >= 0);
+        if (unprivileged == 0) {
+            if (::setuid(65534) != 0) ::_exit(1);
+            std::ostringstream out, err;
+            DaemonRequest request;
+            request.command = "privileged";
+            int result = forward_command(connect_daemon(path), request, out, err);
+            if (result != 5 || !out.str().empty()) ::_exit(1);
+            // Sessionless commands would run code as root; the client's cwd is ignored
+            request.command = "runner";
+            if (forward_command(connect_daemon(path), request, out, err) != 5) ::_exit(2);
+            request.cwd = "/nonexistent";
+            request.command = "echo";
+            request.args = {"--tag", "x"};
+            result = forward_command(connect_daemon(path), request, out, err);
+            ::_exit(result == 7 ? 0 : 3);
+        }
+        int client_status = 0;
+        assert(::waitpid(unprivileged, &client_status, 0) == unprivileged);
+        assert(WIFEXITED(client_status) && WEXITSTATUS(client_status) == 0);
+    }
+
+    int status = 0;
+    assert(::waitpid(child, &status, 0) == child);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "dq_bus.hpp"
+#include "gpio.hpp"
+#include "hardware_locations.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kWeMask = static_cast<uint32_t>(1u) << GPIO_WE;
+
+uint8_t decode_dq(uint32_t levels) {
+    const uint8_t pins[] = {GPIO_DQ0, GPIO_DQ1, GPIO_DQ2, GPIO_DQ3, GPIO_DQ4, GPIO_DQ5, GPIO_DQ6, GPIO_DQ7};
+    uint8_t value = 0;
+    for (int b = 0; b < 8; ++b) {
+        value |= static_cast<uint8_t>(((levels >> pins[b]) & 0x1) << b);
+    }
+    return value;
+}
+
+// Replays a register trace against GPIO bank 0 output levels and records the DQ byte
+// present at every WE# rising edge, i.e. what the NAND would latch.
+struct Replay {
+    std::vector<uint8_t> latched;
+    uint32_t levels = 0;
+};
+
+Replay replay(const GpioWriteTrace& trace, uint32_t initial_levels) {
+    Replay result;
+    result.levels = initial_levels;
+    for (const auto& entry : trace.entries) {
+        const uint32_t before = result.levels;
+        if (entry.reg == GpioWriteTrace::Reg::Set) {
+            result.levels |= entry.value;
+        } else {
+            result.levels &= ~entry.value;
+        }
+        const bool we_rise = !(before & kWeMask) && (result.levels & kWeMask);
+        if (we_rise) {
+            // Data must already be stable before the store that raises WE#.
+            assert((before & dq_all_mask()) == (result.levels & dq_all_mask()));
+            result.latched.push_back(decode_dq(result.levels));
+        }
+    }
+    return result;
+}
+
+void check_payload(const std::vector<uint8_t>& payload) {
+    GpioWriteTrace reference;
+    dq_trace_data_in_reference(payload.data(), payload.size(), reference);
+
+    std::vector<DqBurstWord> words;
+    dq_build_data_in_burst(payload.data(), payload.size(), words);
+    assert(words.size() == payload.size());
+    GpioWriteTrace burst;
+    dq_emit_data_in_burst(words.data(), words.size(), burst);
+
+    // One WE# low store with its zero lines, one store for the ones, one WE# high store.
+    assert(burst.entries.size() == payload.size() * 3);
+    assert(reference.entries.size() == payload.size() * 4);
+
+    const uint32_t idle = kWeMask;
+    const Replay ref = replay(reference, idle);
+    const Replay got = replay(burst, idle);
+    assert(ref.latched == payload);
+    assert(got.latched == payload);
+    assert(ref.levels == got.levels);
+}
+
+// Synthetic GPLEV0 words: DQ lines carry `value`, every other line carries noise.
+void check_decode() {
+    std::vector<uint32_t> levels;
+    std::vector<uint8_t> expected;
+    std::srand(42);
+    for (int round = 0; round < 64; ++round) {
+        for (int v = 0; v < 256; ++v) {
+            const uint32_t noise = (static_cast<uint32_t>(std::rand()) << 16) ^ static_cast<uint32_t>(std::rand());
+            levels.push_back((noise & ~dq_all_mask()) | dq_set_mask(static_cast<uint8_t>(v)));
+            expected.push_back(static_cast<uint8_t>(v));
+        }
+    }
+    levels.push_back(0xFFFFFFFFu);
+    expected.push_back(0xFF);
+    levels.push_back(0u);
+    expected.push_back(0x00);
+
+    std::vector<uint8_t> table(levels.size());
+    std::vector<uint8_t> scalar(levels.size());
+    dq_decode_levels(levels.data(), levels.size(), table.data());
+    dq_decode_levels_scalar(levels.data(), levels.size(), scalar.data());
+    assert(table == expected);
+    assert(scalar == expected);
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        // dq_decode_level_word() is what interface::read_dq_pins() applies to GPLEV0
+        assert(dq_decode_level_word(levels[i]) == expected[i]);
+        assert(decode_dq(levels[i]) == expected[i]);
+    }
+}
+
+// Both codec specializations against the generic spread/gather definitions.
+template <typename Map>
+void check_codec() {
+    using Codec = DqCodec<Map>;
+    static_assert(Codec::shift_path == Map::contiguous, "specialization follows the wiring");
+    std::vector<uint32_t> levels;
+    std::vector<uint8_t> expected;
+    for (int v = 0; v < 256; ++v) {
+        const uint8_t value = static_cast<uint8_t>(v);
+        assert(Codec::set_mask(value) == Map::spread(value));
+        assert((Codec::set_mask(value) & ~Map::all_mask) == 0);
+        const uint32_t noisy = (0xA5C3F00Fu & ~Map::all_mask) | Map::spread(value);
+        assert(Codec::decode_word(noisy) == value);
+        levels.push_back(noisy);
+        expected.push_back(value);
+    }
+    std::vector<uint8_t> decoded(levels.size());
+    Codec::decode_levels(levels.data(), levels.size(), decoded.data());
+    assert(decoded == expected);
+
+    // The direction images dq_bus.cpp builds at static initialization, per GPFSEL register
+    const GpioFselImage input = gpio_make_fsel_image(Map::pins.data(), 8, false);
+    const GpioFselImage output = gpio_make_fsel_image(Map::pins.data(), 8, true);
+    uint32_t fields[kGpioFselRegs] = {};
+    for (uint8_t pin : Map::pins) fields[pin / 10] |= 0x7u << ((pin % 10) * 3);
+    for (uint8_t index = 0; index < kGpioFselRegs; ++index) {
+        assert(input.mask[index] == fields[index] && output.mask[index] == fields[index]);
+        assert(input.bits[index] == 0);
+        assert(output.bits[index] == (fields[index] & 0x49249249u));
+    }
+}
+
+using ContiguousMap = DqPinMap<4, 5, 6, 7, 8, 9, 10, 11>;
+using TopContiguousMap = DqPinMap<24, 25, 26, 27, 28, 29, 30, 31>;
+using ReversedMap = DqPinMap<11, 10, 9, 8, 7, 6, 5, 4>;
+
+static_assert(ContiguousMap::contiguous && DqCodec<ContiguousMap>::shift_path, "consecutive pins take the shift path");
+static_assert(!ReversedMap::contiguous, "descending pins are not a plain shift");
+static_assert(DqCodec<ContiguousMap>::set_mask(0xFF) == 0xFF0u, "shift path set mask");
+static_assert(DqCodec<ContiguousMap>::decode_word(0xFFFFFFFFu) == 0xFF, "shift path masks foreign lines");
+static_assert(DqCodec<BoardDqMap>::set_mask(0x01) == (1u << GPIO_DQ0), "board table generated at compile time");
+static_assert(dq_decode_level_word(dq_set_mask(0x5A)) == 0x5A, "board codec round-trips at compile time");
+
+} // namespace
+
+int main() {
+    for (int v = 0; v < 256; ++v) {
+        const uint8_t value = static_cast<uint8_t>(v);
+        assert((dq_set_mask(value) & ~dq_all_mask()) == 0);
+        assert(decode_dq(dq_set_mask(value)) == value);
+    }
+    assert((dq_all_mask() & kWeMask) == 0);
+
+    std::vector<uint8_t> every_value(256);
+    for (int v = 0; v < 256; ++v) every_value[v] = static_cast<uint8_t>(v);
+    check_payload(every_value);
+
+    std::vector<uint8_t> page(16384 + 2208);
+    std::srand(1234);
+    for (auto& byte : page) byte = static_cast<uint8_t>(std::rand() & 0xFF);
+    check_payload(page);
+
+    check_payload({});
+    check_payload({0x00});
+    check_payload({0xFF, 0x00, 0xFF});
+
+    check_decode();
+
+    check_codec<BoardDqMap>();
+    check_codec<ContiguousMap>();
+    check_codec<TopContiguousMap>();
+    check_codec<ReversedMap>();
+
+    const uint8_t out_of_bank[] = {32};
+    bool rejected = false;
+    try {
+        gpio_make_fsel_image(out_of_bank, 1, true);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <cassert>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 using namespace nandworks;
 
@@ -86,5 +87,19 @@ int main() {
     ParsedCommand forced = parse_command_arguments(stored_destructive, {"--force"});
     assert(forced.force);
 
+    const std::vector<std::string> words =
+        split_command_line("  read-page -b 3 --output 'a b.bin' \"x\\\"y\" c\\ d # trailing comment");
+    assert((words == std::vector<std::string>{"read-page", "-b", "3", "--output", "a b.bin", "x\"y", "c d"}));
+    assert(split_command_line("   # only a comment").empty());
+    assert((split_command_line("tag#not-comment") == std::vector<std::string>{"tag#not-comment"}));
+
+    threw = false;
+    try {
+        (void)split_command_line("echo 'unterminated");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
     return 0;
 }
@@ -0,0 +1,471 @@
+#include "onfi/controller.hpp"
+#include "onfi/device.hpp"
+#include "onfi/sequence.hpp"
+#include "onfi/transport.hpp"
+#include "microprocessor_interface.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if NANDWORKS_HAL_SIM
+#include "gpio.hpp"
+#include "onfi_interface.hpp"
+#include "sim/nand_model.hpp"
+#include "sim/register_file.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Records every phase the controller issues through the default Transport::execute().
+class RecordingTransport : public onfi::Transport {
+public:
+    mutable std::vector<std::string> log;
+    int executes = 0;
+
+    void send_command(uint8_t command) const override { log.push_back("C" + hex(command)); }
+    void send_addresses(const uint8_t* address, uint8_t count, bool) const override {
+        std::string entry = "A";
+        for (uint8_t i = 0; i < count; ++i) entry += hex(address[i]);
+        log.push_back(entry);
+    }
+    void send_data(const uint8_t*, uint16_t count) const override { log.push_back("I" + std::to_string(count)); }
+    void wait_ready_blocking() const override { log.push_back("W"); }
+    void delay_function(uint32_t) override { log.push_back("D"); }
+    void get_data(uint8_t* dst, uint16_t count) const override {
+        for (uint16_t i = 0; i < count; ++i) dst[i] = static_cast<uint8_t>(i + 1);
+        log.push_back("O" + std::to_string(count));
+    }
+    uint8_t get_status() override { return 0xE0; }
+    void select_target(unsigned int target) override { log.push_back("T" + std::to_string(target)); }
+
+    uint32_t column_change_ns() const override { return 300; }
+
+    // Settle delays are logged as "S<ns>" between the phases around them.
+    void execute(const onfi::Sequence& sequence) override {
+        ++executes;
+        onfi::Sequence run;
+        for (const onfi::Sequence::MicroOp& op : sequence) {
+            switch (op.op) {
+            case onfi::Sequence::Op::Command: run.command(op.value); break;
+            case onfi::Sequence::Op::Address:
+                run.address(sequence.address_bytes(op), static_cast<uint8_t>(op.length));
+                break;
+            case onfi::Sequence::Op::DataIn: run.data_in(op.src, op.length); break;
+            case onfi::Sequence::Op::DataOut: run.data_out(op.dst, op.length); break;
+            case onfi::Sequence::Op::WaitReady: run.wait_ready(static_cast<RbWaitOp>(op.value)); break;
+            case onfi::Sequence::Op::Delay:
+                onfi::Transport::execute(run);
+                run.clear();
+                log.push_back("S" + std::to_string(op.length));
+                break;
+            }
+        }
+        onfi::Transport::execute(run);
+    }
+
+private:
+    static std::string hex(uint8_t value) {
+        const char digits[] = "0123456789ABCDEF";
+        return std::string{digits[value >> 4], digits[value & 0xF]};
+    }
+};
+
+using Log = std::vector<std::string>;
+
+// A recording transport with a controller and a device on top of it; the device has
+// 8+4-byte pages, 64 pages per block and 2+3 address cycles.
+struct Rig {
+    RecordingTransport t;
+    onfi::OnfiController ctrl{t};
+    onfi::NandDevice dev{ctrl};
+
+    Rig() {
+        dev.geometry.page_size_bytes = 8;
+        dev.geometry.spare_size_bytes = 4;
+        dev.geometry.pages_per_block = 64;
+        dev.geometry.column_cycles = 2;
+        dev.geometry.row_cycles = 3;
+    }
+};
+
+#if NANDWORKS_HAL_SIM
+// Sits between the register file and the NAND model and logs the bus phases in order:
+// C command and A address latches, I data-in, O RE# strobes, W R/B# sampled busy.
+// Repeats of one phase collapse into one letter.
+class PhaseTrace : public sim::PinDevice {
+public:
+    explicit PhaseTrace(sim::NandModel& model) : model_(model) {}
+
+    std::string phases;
+    int ce_rises = 0;
+    bool ce_high_phase = false; // some phase ran with CE# high
+
+    void clear() {
+        phases.clear();
+        ce_rises = 0;
+        ce_high_phase = false;
+    }
+
+    void on_pins(uint32_t previous, uint32_t current, uint32_t host_outputs) override {
+        const auto rose = [&](uint8_t pin) { return !((previous >> pin) & 1) && ((current >> pin) & 1); };
+        const bool ce_low = !((current >> GPIO_CE) & 1);
+        if (rose(GPIO_CE)) ++ce_rises;
+        if (rose(GPIO_WE)) {
+            note(((current >> GPIO_CLE) & 1) ? 'C' : ((current >> GPIO_ALE) & 1) ? 'A' : 'I', ce_low);
+        }
+        if (rose(GPIO_RE)) note('O', ce_low);
+        model_.on_pins(previous, current, host_outputs);
+    }
+
+    uint32_t on_sample(uint32_t host_levels, uint32_t host_outputs, uint32_t& driven) override {
+        const uint32_t levels = model_.on_sample(host_levels, host_outputs, driven);
+        if (((driven >> GPIO_RB) & 1) && !((levels >> GPIO_RB) & 1)) note('W', !((host_levels >> GPIO_CE) & 1));
+        return levels;
+    }
+
+private:
+    void note(char phase, bool ce_low) {
+        if (phases.empty() || phases.back() != phase) phases += phase;
+        if (!ce_low) ce_high_phase = true;
+    }
+
+    sim::NandModel& model_;
+};
+
+// onfi_interface::execute() drops CE# once, keeps it low through the command, address,
+// data-in, wait and data-out phases, and raises it once at the end.
+void check_held_ce() {
+    const std::string cache_dir = "/tmp/nandworks_param_cache." + std::to_string(::getpid());
+    ::setenv("NANDWORKS_PARAM_CACHE", cache_dir.c_str(), 1);
+
+    sim::NandModelConfig config;
+    sim::NandModel model(config);
+    PhaseTrace trace(model);
+    sim::register_file().attach(&trace);
+
+    GpioSession session;
+    onfi_interface onfi;
+    onfi.get_started();
+
+    uint8_t addr[5] = {0};
+    onfi.convert_pagenumber_to_columnrow_address(3, 1, addr, false);
+    std::vector<uint8_t> page(onfi.num_bytes_in_page, 0x5A);
+    std::vector<uint8_t> readback(page.size());
+    onfi.enable_erase();
+
+    trace.clear();
+    onfi::Sequence program;
+    program.command(0x80).address(addr, 5).data_in(page.data(), static_cast<uint16_t>(page.size()))
+           .command(0x10).wait_ready(RbWaitOp::Program);
+    onfi.execute(program);
+    assert(trace.phases == "CAICW");
+    assert(trace.ce_rises == 1 && !trace.ce_high_phase);
+
+    trace.clear();
+    onfi::Sequence read;
+    read.command(0x00).address(addr, 5).command(0x30).wait_ready(RbWaitOp::Read)
+        .data_out(readback.data(), static_cast<uint16_t>(readback.size()));
+    onfi.execute(read);
+    assert(trace.phases == "CACWO");
+    assert(trace.ce_rises == 1 && !trace.ce_high_phase);
+    assert(readback == page);
+
+    // Under StatusPoll the wait is 70h and status strobes, then 00h, all inside the window
+    RbWaitPolicy poll{};
+    poll.mode = RbWaitMode::StatusPoll;
+    onfi.set_wait_policy(RbWaitOp::Read, poll);
+    trace.clear();
+    std::fill(readback.begin(), readback.end(), 0);
+    onfi.execute(read);
+    // (30h and 70h collapse into one C; busy status bytes alternate with busy samples)
+    const std::string& phases = trace.phases;
+    assert(phases.compare(0, 5, "CACWO") == 0);
+    assert(phases.size() > 7 && phases.compare(phases.size() - 2, 2, "CO") == 0);
+    assert(trace.ce_rises == 1 && !trace.ce_high_phase);
+    assert(readback == page);
+
+    sim::register_file().attach(nullptr);
+    std::filesystem::remove_all(cache_dir);
+}
+#endif
+
+} // namespace
+
+int main() {
+    const uint8_t addr5[5] = {0x00, 0x01, 0x02, 0x03, 0x04};
+    uint8_t payload[32] = {0};
+
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.page_read(addr5, 5);
+        assert((t.log == Log{"C00", "A0001020304", "C30", "W"}));
+        assert(t.executes == 1);
+    }
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.page_read(addr5, 5, true);
+        assert((t.log == Log{"C00", "C00", "A0001020304", "C30", "W"}));
+    }
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.program_page(addr5, payload, sizeof(payload));
+        assert((t.log == Log{"C80", "A0001020304", "I32", "C10", "W"}));
+        assert(t.executes == 1);
+    }
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.erase_block(addr5 + 2);
+        assert((t.log == Log{"C60", "A020304", "CD0", "W"}));
+    }
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.partial_erase_block(addr5 + 2, 10);
+        assert((t.log == Log{"C60", "A020304", "CD0", "D", "CFF", "W"}));
+        assert(t.executes == 2);
+    }
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        uint8_t out[4] = {0};
+        ctrl.get_features(0x01, out);
+        assert((t.log == Log{"CEE", "A01", "W", "O4"}));
+        assert(out[0] == 1 && out[3] == 4);
+    }
+
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.cache_read_random(addr5, 5);
+        ctrl.cache_read_sequential();
+        ctrl.cache_read_end();
+        assert((t.log == Log{"C00", "A0001020304", "C31", "W", "C31", "W", "C3F", "W"}));
+    }
+
+    // read_block pipelines through the cache register only when the device advertises it:
+    // consecutive pages use 31h, a jump uses 00h-addr-31h and the last page is fetched after 3Fh.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        dev.capabilities.optional_commands = 0x0002;
+
+        struct CountingSink : onfi::DataSink {
+            int pages = 0;
+            void write(const uint8_t*, std::size_t n) override { assert(n == 8); ++pages; }
+        } sink;
+        const uint16_t pages[] = {4, 5, 9};
+        dev.read_block(1, false, pages, 3, false, false, sink);
+        assert(sink.pages == 3);
+        assert((t.log == Log{"C00", "A0000440000", "C30", "W",
+                             "C31", "W", "O8",
+                             "C00", "A0000490000", "C31", "W", "O8",
+                             "C3F", "W", "O8"}));
+
+        t.log.clear();
+        dev.capabilities.optional_commands = 0;
+        sink.pages = 0;
+        dev.read_block(1, false, pages, 2, false, false, sink);
+        assert(sink.pages == 2);
+        assert((t.log == Log{"C00", "A0000440000", "C30", "W", "O8",
+                             "C00", "A0000450000", "C30", "W", "O8"}));
+    }
+
+    // program_block chains pages with 15h and closes the chain with 10h when the device
+    // advertises cache program.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        dev.capabilities.optional_commands = 0x0001;
+        const uint16_t pages[] = {6, 2, 3};
+        assert(dev.program_block(0, false, pages, 3, nullptr, false, false));
+        assert((t.log == Log{"C80", "A0000020000", "I8", "C15", "W",
+                             "C80", "A0000030000", "I8", "C15", "W",
+                             "C80", "A0000060000", "I8", "C10", "W"}));
+    }
+
+    // Multi-plane chains: queued planes end in 11h/32h, erase repeats 60h before one D0h,
+    // and 06h-E0h selects the plane whose register is streamed out.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.program_page_queue_plane(addr5, payload, 4);
+        ctrl.page_read_queue_plane(addr5, 5);
+        ctrl.select_read_plane(addr5, 5);
+        const uint8_t rows[6] = {0x40, 0x00, 0x00, 0x80, 0x00, 0x00};
+        ctrl.erase_blocks_multi_plane(rows, 2);
+        assert((t.log == Log{"C80", "A0001020304", "I4", "C11", "W",
+                             "C00", "A0001020304", "C32", "W",
+                             "C06", "A0001020304", "CE0", "S300",
+                             "C60", "A400000", "C60", "A800000", "CD0", "W"}));
+    }
+
+    // Plane groups hold one block per plane and, unless the device lifts the
+    // restriction, only blocks that share the bits above the plane bits.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        dev.capabilities.features = 0x0048;
+        dev.capabilities.plane_address_bits = 1;
+        assert(dev.planes() == 2 && dev.plane_of(7) == 1);
+        const unsigned int blocks[] = {0, 1, 2, 3, 5, 4, 7, 8};
+        const auto groups = dev.plane_groups(blocks, 8, true);
+        using Groups = std::vector<std::vector<unsigned int>>;
+        assert((groups == Groups{{0, 1}, {2, 3}, {5, 4}, {7}, {8}}));
+        dev.capabilities.multi_plane_attributes = 0x02;
+        assert((dev.plane_groups(blocks + 6, 2, true) == Groups{{7, 8}}));
+        assert((dev.plane_groups(blocks, 2, false) == Groups{{0}, {1}}));
+    }
+
+    // READ STATUS ENHANCED returns the status byte; LUN bits sit above the block bits.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        const uint8_t row[3] = {0x00, 0x00, 0x01};
+        assert(ctrl.read_status_enhanced(row) == 1);
+        assert((t.log == Log{"C78", "A000001", "O1"}));
+        assert(onfi::lun_block_index(1024, 1, 5) == 1029);
+        assert(onfi::lun_block_index(1000, 1, 0) == 1024);
+    }
+
+    // COPYBACK: 35h leaves the page in the register, 85h with a full address retargets
+    // it and every patch is a column change plus data before 10h.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.copyback_read(addr5);
+        const uint8_t spare[4] = {0xA5, 0x5A, 0x00, 0xFF};
+        const onfi::ColumnPatch patch{0x0800, spare, 4};
+        ctrl.copyback_program(addr5, &patch, 1);
+        assert((t.log == Log{"C00", "A0001020304", "C35", "W", "C85", "A0001020304", "C85", "A0008", "S300", "I4", "C10", "W"}));
+        assert(t.executes == 2);
+
+        // Four patches still fit one program; copy_page refuses a fifth up front
+        const onfi::ColumnPatch patches[5] = {{0, spare, 1}, {2, spare, 1}, {4, spare, 1}, {6, spare, 1}, {8, spare, 1}};
+        t.log.clear();
+        ctrl.copyback_program(addr5, patches, 4);
+        assert(t.log.size() == 20);
+        t.log.clear();
+        bool threw = false;
+        try {
+            dev.copy_page(0, 0, 1, 0, patches, 5);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw && t.log.empty());
+    }
+
+    // Chunked data-out repositions the column every `chunk` bytes; 0 reads one burst.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        uint8_t out[5];
+        ctrl.read_data_chunked(0x1FF, out, 5, 2);
+        assert((t.log == Log{"C05", "AFF01", "CE0", "S300", "O2", "C05", "A0102", "CE0", "S300", "O2",
+                             "C05", "A0302", "CE0", "S300", "O1"}));
+        assert(t.executes == 3);
+        t.log.clear();
+        ctrl.read_data_chunked(4, out, 5, 0);
+        assert((t.log == Log{"C05", "A0400", "CE0", "S300", "O5"}));
+    }
+
+    // Suspend waits for the LUN to accept reads; resume does not wait.
+    {
+        Rig rig;
+        auto& [t, ctrl, dev] = rig;
+        ctrl.suspend(0xB0);
+        ctrl.resume(0x30);
+        assert((t.log == Log{"CB0", "W", "C30"}));
+    }
+
+    // A target-bound transport selects its CE# before every operation and presents
+    // itself as a single-target transport.
+    {
+        RecordingTransport t;
+        onfi::TargetTransport target(t, 2);
+        onfi::OnfiController ctrl(target);
+        assert(ctrl.read_status() == 1);
+        assert((t.log == Log{"T2", "C70", "O1"}));
+        assert(ctrl.ready_line() == -1);
+        bool threw = false;
+        try {
+            target.select_target(1);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        assert(threw);
+
+        const std::vector<ChipTarget> targets = parse_chip_targets("22:17,7,9:8");
+        assert(targets.size() == 3);
+        assert(targets[0].ce_pin == 22 && targets[0].rb_pin == 17);
+        assert(targets[1].ce_pin == 7 && targets[1].rb_pin == GPIO_RB);
+        assert(targets[2].ce_pin == 9 && targets[2].rb_pin == 8);
+        threw = false;
+        try {
+            parse_chip_targets("22,,7");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+
+        // A bus line as CE# or R/B#, a shared CE#, or a CE# that is an R/B# line
+        for (const char* wiring : {"21", "22:19", "22,7,22", "22:7,7", "22,17"}) {
+            threw = false;
+            try {
+                parse_chip_targets(wiring);
+            } catch (const std::invalid_argument&) {
+                threw = true;
+            }
+            assert(threw);
+        }
+        threw = false;
+        try {
+            validate_chip_targets({{22, 17}, {GPIO_DQ0, 17}});
+        } catch (const std::invalid_argument& error) {
+            threw = std::string(error.what()).find(std::to_string(GPIO_DQ0)) != std::string::npos;
+        }
+        assert(threw);
+    }
+
+    // Address bytes are copied into the program, so the caller's buffer may change.
+    {
+        uint8_t column[2] = {0x10, 0x20};
+        onfi::Sequence seq;
+        seq.command(0x05).address(column, 2).command(0xE0);
+        column[0] = 0xFF;
+        RecordingTransport t;
+        t.execute(seq);
+        assert((t.log == Log{"C05", "A1020", "CE0"}));
+    }
+
+    // Capacity is fixed; overflowing it is reported rather than truncated.
+    {
+        onfi::Sequence seq;
+        for (std::size_t i = 0; i < onfi::Sequence::kMaxOps; ++i) seq.command(0x00);
+        bool threw = false;
+        try {
+            seq.wait_ready();
+        } catch (const std::length_error&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(seq.size() == onfi::Sequence::kMaxOps);
+    }
+
+#if NANDWORKS_HAL_SIM
+    check_held_ce();
+#endif
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "onfi_interface.hpp"
+#include "onfi/bad_block_table.hpp"
 #include "onfi/controller.hpp"
 #include "onfi/device.hpp"
 #include "onfi/device_config.hpp"
@@ -18,13 +19,32 @@
 
 namespace {
 
+// Reuses the bad-block table saved for this chip, scanning only on the first run. The
+// pick is re-probed, since the table does not see blocks that went bad after its scan.
 unsigned int pick_good_block(onfi_interface &onfi_instance) {
+    onfi::OnfiController ctrl(onfi_instance);
+    onfi::NandDevice dev(ctrl);
+    onfi::apply_device_config(onfi::make_device_config(onfi_instance), dev);
+    const auto* id = reinterpret_cast<const uint8_t*>(onfi_instance.unique_id);
+    static onfi::BadBlockTable table;
+    if (table.empty()) {
+        onfi::attach_bad_block_table(dev, id);
+        table = dev.bad_blocks;
+    }
+    auto usable = [&](unsigned int block) {
+        if (table.is_bad(block)) return false;
+        if (!dev.is_bad_block(block)) return true;
+        table.mark_bad(block);
+        table.save(onfi::bad_block_table_path(id));
+        return false;
+    };
+
     for (int tries = 0; tries < 16; ++tries) {
         unsigned int candidate = static_cast<unsigned int>(rand() % onfi_instance.num_blocks);
-        if (!onfi_instance.is_bad_block(candidate)) return candidate;
+        if (usable(candidate)) return candidate;
     }
     for (unsigned int block = 0; block < onfi_instance.num_blocks; ++block) {
-        if (!onfi_instance.is_bad_block(block)) return block;
+        if (usable(block)) return block;
     }
     return 0;
 }
@@ -0,0 +1,636 @@
+// End-to-end check of the ONFI stack against the simulated register file and the
+// pin-level NAND model. Only meaningful with `make HAL_BACKEND=sim`; the hardware build
+// reports the test as skipped.
+
+#include "gpio.hpp"
+#include "nandworks/command_registry.hpp"
+#include "nandworks/commands/onfi.hpp"
+#include "nandworks/dispatch.hpp"
+#include "nandworks/driver_context.hpp"
+#include "onfi_interface.hpp"
+#include "onfi/bad_block_table.hpp"
+#include "onfi/controller.hpp"
+#include "onfi/device.hpp"
+#include "onfi/device_config.hpp"
+#include "onfi/param_cache.hpp"
+#include "onfi/timed_commands.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#if NANDWORKS_HAL_SIM
+#include "sim/nand_model.hpp"
+#include "sim/register_file.hpp"
+
+int main() {
+    // Keep parameter pages cached by these sessions out of the user's cache
+    const std::string cache_dir = "/tmp/nandworks_param_cache." + std::to_string(::getpid());
+    ::setenv("NANDWORKS_PARAM_CACHE", cache_dir.c_str(), 1);
+
+    sim::NandModelConfig config;
+    config.factory_bad_blocks = {5};
+    config.luns = 2;
+    sim::NandModel model(config);
+    sim::register_file().attach(&model);
+
+    GpioSession session;
+    onfi_interface onfi;
+    onfi.get_started();
+
+    assert(onfi.num_bytes_in_page == config.page_size);
+    assert(onfi.num_spare_bytes_in_page == config.spare_size);
+    assert(onfi.num_pages_in_block == config.pages_per_block);
+    assert(onfi.num_blocks == config.blocks);
+    // tCCS comes from parameter page bytes 139-140
+    assert(onfi.capabilities.column_change_ns == 200);
+    assert(onfi.column_change_ns() == 200);
+    assert(onfi.is_bad_block(5));
+    assert(!onfi.is_bad_block(6));
+
+    const unsigned block = 7;
+    const unsigned page = 3;
+    const size_t page_size = onfi.num_bytes_in_page;
+    std::vector<uint8_t> payload(page_size);
+    for (size_t i = 0; i < page_size; ++i) payload[i] = static_cast<uint8_t>(i * 37 + 11);
+
+    onfi.erase_block(block);
+    onfi.program_page(block, page, payload.data(), false);
+    assert(model.array_page(block * config.pages_per_block + page)[100] == payload[100]);
+
+    sim::RegisterCounters& counters = sim::register_file().counters();
+    std::vector<uint8_t> readback(page_size);
+    onfi.read_page(block, page);
+    counters.reset();
+    onfi.get_data(readback.data(), static_cast<uint16_t>(readback.size()));
+    assert(readback == payload);
+
+    // Data-out: one GPLEV0 load plus the RE# low/high stores per byte, and a small
+    // constant for bus turnaround.
+    assert(counters.level_loads >= page_size);
+    assert(counters.total() <= 3 * page_size + 32);
+
+    assert(onfi.verify_program_page(block, page, payload.data(), false));
+
+    onfi.erase_block(block);
+    onfi.read_page(block, page);
+    onfi.get_data(readback.data(), static_cast<uint16_t>(readback.size()));
+    for (uint8_t byte : readback) assert(byte == 0xFF);
+
+    // Erasing a factory-bad block fails and must not clear the marker
+    onfi.erase_block(5);
+    assert(onfi.is_bad_block(5));
+
+    // Zero spin window: every read wait parks (sleep slices, since the simulated bus
+    // has no GPIO edge events) and still returns with the page data intact.
+    const RbWaitPolicy saved = onfi.wait_policy(RbWaitOp::Read);
+    onfi.set_wait_policy(RbWaitOp::Read, RbWaitPolicy{RbWaitMode::SpinThenEdge, 0, 5000});
+    onfi.reset_wait_stats();
+    onfi.program_page(block, page, payload.data(), false);
+    onfi.read_page(block, page);
+    onfi.get_data(readback.data(), static_cast<uint16_t>(readback.size()));
+    assert(readback == payload);
+    assert(onfi.wait_stats(RbWaitOp::Read).waits == 1);
+    assert(onfi.wait_stats(RbWaitOp::Read).parked == 1);
+    assert(onfi.wait_stats(RbWaitOp::Read).edge_wakeups == 0);
+    assert(onfi.wait_stats(RbWaitOp::Program).waits == 1);
+    onfi.set_wait_policy(RbWaitOp::Read, saved);
+
+    // Status polling: waits re-read the status byte instead of R/B#, and a 00h returns
+    // the bus to the page data before it is read out.
+    const RbWaitPolicy read_policy = onfi.wait_policy(RbWaitOp::Read);
+    const RbWaitPolicy erase_policy = onfi.wait_policy(RbWaitOp::Erase);
+    RbWaitPolicy poll{};
+    poll.mode = RbWaitMode::StatusPoll;
+    onfi.set_wait_policy(RbWaitOp::Read, poll);
+    onfi.reset_wait_stats();
+    {
+        onfi::OnfiController poll_ctrl(onfi);
+        onfi::NandDevice poll_dev(poll_ctrl);
+        onfi::apply_device_config(onfi::make_device_config(onfi), poll_dev);
+        std::vector<uint8_t> polled;
+        poll_dev.read_page(block, page, false, false, polled);
+        assert(std::equal(polled.begin(), polled.end(), model.array_page(block * config.pages_per_block + page).begin()));
+        const RbWaitStats& poll_stats = onfi.wait_stats(RbWaitOp::Read);
+        assert(poll_stats.status_polls == 1 && poll_stats.status_reads > 1);
+
+        poll.timeout_ns = 1;
+        onfi.set_wait_policy(RbWaitOp::Erase, poll);
+        onfi.enable_erase();
+        bool timed_out = false;
+        try {
+            poll_dev.erase_block(block + 2);
+        } catch (const std::runtime_error&) {
+            timed_out = true;
+        }
+        assert(timed_out);
+        onfi.wait_ready_blocking();
+    }
+    onfi.set_wait_policy(RbWaitOp::Read, read_policy);
+    onfi.set_wait_policy(RbWaitOp::Erase, erase_policy);
+
+    // Cache read: the block read streams through 31h/00h-addr-31h/3Fh and returns the
+    // same bytes a page-at-a-time read would.
+    assert(onfi.capabilities.cache_read());
+    onfi::OnfiController ctrl(onfi);
+    onfi::NandDevice dev(ctrl);
+    onfi::apply_device_config(onfi::make_device_config(onfi), dev);
+    onfi.erase_block(block);
+    const uint16_t cached_pages[] = {0, 1, 2, 9};
+    std::vector<std::vector<uint8_t>> written;
+    for (uint16_t p : cached_pages) {
+        std::vector<uint8_t> data(page_size);
+        for (size_t i = 0; i < page_size; ++i) data[i] = static_cast<uint8_t>(i * 7 + p * 13);
+        onfi.program_page(block, p, data.data(), false);
+        written.push_back(std::move(data));
+    }
+    struct CollectingSink : onfi::DataSink {
+        std::vector<std::vector<uint8_t>> pages;
+        void write(const uint8_t* data, std::size_t n) override { pages.emplace_back(data, data + n); }
+    } sink;
+    const uint64_t cache_reads_before = model.stats().cache_reads;
+    dev.read_block(block, false, cached_pages, 4, false, false, sink);
+    assert(model.stats().cache_reads - cache_reads_before == 4);
+    assert(sink.pages == written);
+    assert(dev.verify_erase_block(block, false, cached_pages + 3, 1, false, false) == false);
+    assert(dev.verify_program_block(block, false, cached_pages, 1, written[0].data(), false, false, 0));
+
+    // Cache program: every page but the last confirms with 15h; WP# asserted makes the
+    // chain report failure through the status register. (onfi_interface flows leave WP#
+    // asserted; NandDevice does not touch it.)
+    onfi.erase_block(block);
+    onfi.enable_erase();
+    const uint64_t cache_programs_before = model.stats().cache_programs;
+    assert(dev.program_block(block, false, cached_pages, 4, written[0].data(), false, false));
+    assert(model.stats().cache_programs - cache_programs_before == 3);
+    assert(dev.verify_program_block(block, false, cached_pages, 4, written[0].data(), false, false, 0));
+    onfi.disable_erase();
+    assert(!dev.program_block(block + 1, false, cached_pages, 4, written[0].data(), false, false));
+    onfi.enable_erase();
+
+    // Multi-plane: the default model has two planes; blocks 8 and 9 share the upper
+    // block-address bits and are erased, programmed and read as one operation each.
+    assert(dev.planes() == 2);
+    assert(dev.capabilities.multi_plane_program_erase() && dev.capabilities.multi_plane_read());
+    const unsigned int pair[] = {8, 9};
+    const uint64_t multi_before = model.stats().multi_plane_ops;
+    assert(dev.erase_blocks(pair, 2).empty());
+    const uint8_t* plane_data[] = {written[1].data(), written[2].data()};
+    assert(dev.program_page_multi_plane(pair, plane_data, 2, 4, false));
+    std::vector<std::vector<uint8_t>> plane_pages;
+    dev.read_page_multi_plane(pair, 2, 4, false, plane_pages);
+    assert(plane_pages[0] == written[1]);
+    assert(plane_pages[1] == written[2]);
+    assert(model.stats().multi_plane_ops - multi_before == 3);
+    assert(dev.program_blocks(pair, 2, false, cached_pages, 2, written[3].data(), false, false));
+    assert(dev.verify_program_block(9, false, cached_pages, 2, written[3].data(), false, false, 0));
+    assert(model.stats().plane_conflicts == 0);
+
+    // Two LUNs: erase and program LUN 1 while LUN 0 serves reads. The scheduler keeps
+    // one operation in flight per LUN, so both are busy at the same time.
+    assert(dev.luns() == 2 && dev.capabilities.multi_lun_operations());
+    const unsigned int lun1_block = 3;
+    std::vector<uint8_t> lun0_page_a, lun0_page_b, lun1_page;
+    std::vector<onfi::LunOperation> ops(5);
+    ops[0].kind = onfi::LunOperation::Kind::Erase;
+    ops[0].lun = 1; ops[0].block = lun1_block;
+    ops[1].kind = onfi::LunOperation::Kind::Program;
+    ops[1].lun = 1; ops[1].block = lun1_block; ops[1].page = 2; ops[1].data = written[2].data();
+    ops[2].kind = onfi::LunOperation::Kind::Read;
+    ops[2].lun = 1; ops[2].block = lun1_block; ops[2].page = 2; ops[2].out = &lun1_page;
+    ops[3].kind = onfi::LunOperation::Kind::Read;
+    ops[3].lun = 0; ops[3].block = 9; ops[3].page = 4; ops[3].out = &lun0_page_a;
+    ops[4].kind = onfi::LunOperation::Kind::Read;
+    ops[4].lun = 0; ops[4].block = 8; ops[4].page = 4; ops[4].out = &lun0_page_b;
+    const uint64_t concurrent_before = model.stats().concurrent_lun_samples;
+    assert(dev.run_lun_operations(ops));
+    assert(model.stats().concurrent_lun_samples > concurrent_before);
+    assert(lun1_page == written[2]);
+    assert(lun0_page_a == written[2]);
+    assert(lun0_page_b == written[1]);
+    const std::vector<uint8_t> lun1_array = model.array_page(dev.lun_block(1, lun1_block) * config.pages_per_block + 2);
+    assert(std::equal(written[2].begin(), written[2].end(), lun1_array.begin()));
+    // LUN 0's copy of that block is untouched
+    assert(model.array_page(lun1_block * config.pages_per_block + 2)[0] == 0xFF);
+
+    // Copyback keeps page data on the chip and patches the spare area in flight; a copy
+    // across planes goes through the host instead.
+    assert(dev.capabilities.copyback());
+    const uint8_t marker[2] = {0x12, 0x34};
+    const onfi::ColumnPatch spare_patch{static_cast<uint16_t>(page_size), marker, 2};
+    dev.erase_block(10);
+    dev.erase_block(12);
+    const uint64_t copyback_before = model.stats().copyback_programs;
+    const uint64_t data_in_before = model.stats().data_in_bytes;
+    assert(dev.copy_page(8, 4, 10, 4, &spare_patch, 1));
+    assert(model.stats().copyback_programs - copyback_before == 1);
+    assert(model.stats().data_in_bytes - data_in_before == 2);
+    const std::vector<uint8_t> copied = model.array_page(10 * config.pages_per_block + 4);
+    assert(std::equal(written[1].begin(), written[1].end(), copied.begin()));
+    assert(copied[page_size] == 0x12 && copied[page_size + 1] == 0x34);
+    assert(dev.copy_block(9, 12, false, cached_pages, 2));
+    assert(model.stats().copyback_programs - copyback_before == 1);
+    assert(dev.verify_program_block(12, false, cached_pages, 2, written[3].data(), false, false, 0));
+
+    // Column ranges: only the requested bytes cross the bus.
+    uint8_t range[8];
+    const uint64_t data_out_before = model.stats().data_out_bytes;
+    dev.read_range(10, 4, page_size, 2, range);
+    assert(model.stats().data_out_bytes - data_out_before == 2);
+    assert(range[0] == 0x12 && range[1] == 0x34);
+    dev.read_range(10, 4, 100, 8, range);
+    assert(std::equal(range, range + 8, written[1].begin() + 100));
+    std::vector<uint8_t> spare;
+    dev.read_spare(10, 4, spare);
+    assert(spare.size() == config.spare_size && spare[0] == 0x12 && spare[2] == 0xFF);
+    assert(dev.verify_range(10, 4, 100, 8, written[1].data() + 100, 0));
+    assert(dev.is_bad_block(5) && !dev.is_bad_block(6));
+    bool range_rejected = false;
+    try {
+        dev.read_range(10, 4, page_size, config.spare_size + 1, range);
+    } catch (const std::out_of_range&) {
+        range_rejected = true;
+    }
+    assert(range_rejected);
+
+    // Bad-block table: one marker byte per block crosses the bus, every marker page goes
+    // through one cache read pipeline per LUN, and the saved table spares the next
+    // attach the scan.
+    {
+        const uint32_t all_blocks = config.blocks * config.luns;
+        const uint64_t page_reads_before = model.stats().page_reads;
+        const uint64_t cache_reads_before = model.stats().cache_reads;
+        const uint64_t out_before = model.stats().data_out_bytes;
+        const onfi::BadBlockTable table = dev.scan_bad_blocks();
+        assert(table.blocks() == all_blocks);
+        assert(table.bad_blocks() == std::vector<uint32_t>{5});
+        assert(model.stats().page_reads - page_reads_before == all_blocks);
+        assert(model.stats().cache_reads - cache_reads_before == all_blocks);
+        assert(model.stats().data_out_bytes - out_before == all_blocks);
+        assert(!dev.is_bad(5));
+
+        const auto* id = reinterpret_cast<const uint8_t*>(onfi.unique_id);
+        const std::string bbt = onfi::bad_block_table_path(id);
+        assert(!bbt.empty() && !onfi::attach_bad_block_table(dev, id));
+        assert(dev.is_bad(5) && !dev.is_bad(6) && dev.bad_blocks.bad_count() == 1);
+        const uint64_t reads_after_scan = model.stats().page_reads;
+        onfi::NandDevice reused(ctrl);
+        onfi::apply_device_config(onfi::make_device_config(onfi), reused);
+        assert(onfi::attach_bad_block_table(reused, id));
+        assert(model.stats().page_reads == reads_after_scan);
+        assert(reused.is_bad(5) && reused.bad_blocks.bad_count() == 1);
+
+        // A damaged table is scanned again and rewritten
+        {
+            std::fstream file(bbt, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(10);
+            file.put('\x5A');
+        }
+        assert(!onfi::attach_bad_block_table(reused, id));
+        assert(reused.bad_blocks.bad_blocks() == std::vector<uint32_t>{5});
+        assert(onfi::attach_bad_block_table(reused, id));
+
+        // MLC parts also carry the marker on the last page of the block
+        std::vector<uint8_t> marked(page_size + config.spare_size, 0xFF);
+        marked[page_size] = 0x00;
+        dev.erase_block(20);
+        dev.program_page(20, config.pages_per_block - 1, marked.data(), true);
+        assert(!dev.is_bad_block(20));
+        dev.chip = micron_mlc;
+        assert(dev.is_bad_block(20));
+        assert(dev.scan_bad_blocks().bad_blocks() == (std::vector<uint32_t>{5, 20}));
+        dev.chip = default_async;
+        dev.erase_block(20);
+    }
+
+    // Bytewise reads in 512-byte chunks return the same page with far fewer column changes.
+    std::vector<uint8_t> chunked(page_size + config.spare_size);
+    const uint64_t commands_before = model.stats().commands;
+    dev.bytewise_chunk = 512;
+    dev.read_range(10, 4, 0, static_cast<uint32_t>(chunked.size()), chunked.data(), true);
+    dev.bytewise_chunk = 1;
+    const uint32_t chunks = (static_cast<uint32_t>(chunked.size()) + 511) / 512;
+    assert(model.stats().commands - commands_before == 2 + 2 * chunks);
+    assert(std::equal(written[1].begin(), written[1].end(), chunked.begin()));
+    assert(chunked[page_size] == 0x12);
+
+    // Suspend: an erase is suspended once per queued read, then resumed and completed.
+    // max_suspends caps the suspend windows, reads_per_suspend 0 serves the whole queue
+    // in one, and without a policy the reads wait for the erase. Every read counts as served.
+    dev.program_page(14, 0, written[0].data(), false);
+    std::vector<uint8_t> during_a, during_b;
+    std::vector<onfi::LunOperation> queued(2);
+    queued[0].block = 10; queued[0].page = 4; queued[0].out = &during_a;
+    queued[1].block = 8; queued[1].page = 4; queued[1].out = &during_b;
+    onfi::LunOperation erase14;
+    erase14.kind = onfi::LunOperation::Kind::Erase;
+    erase14.block = 14;
+    dev.suspend_policy = onfi::SuspendPolicy{config.suspend_command, config.resume_command, 0, 8};
+    assert(dev.run_suspendable(erase14, queued));
+    assert(model.stats().suspends == 2 && model.stats().resumes == 2);
+    assert(dev.suspend_stats().suspends == 2 && dev.suspend_stats().reads_served == 2);
+    assert(std::equal(written[1].begin(), written[1].end(), during_a.begin()));
+    assert(during_b == written[1]);
+    assert(model.array_page(14 * config.pages_per_block)[0] == 0xFF);
+
+    dev.reset_suspend_stats();
+    dev.suspend_policy.max_suspends = 1;
+    assert(dev.run_suspendable(erase14, queued));
+    assert(model.stats().suspends == 3);
+    assert(dev.suspend_stats().suspends == 1 && dev.suspend_stats().reads_served == 2);
+
+    dev.reset_suspend_stats();
+    dev.suspend_policy.max_suspends = 8;
+    dev.suspend_policy.reads_per_suspend = 0;
+    assert(dev.run_suspendable(erase14, queued));
+    assert(model.stats().suspends == 4);
+    assert(dev.suspend_stats().suspends == 1 && dev.suspend_stats().reads_served == 2);
+
+    dev.reset_suspend_stats();
+    dev.suspend_policy = onfi::SuspendPolicy{};
+    assert(dev.run_suspendable(erase14, queued));
+    assert(model.stats().suspends == 4);
+    assert(dev.suspend_stats().suspends == 0 && dev.suspend_stats().reads_served == 2);
+    assert(during_b == written[1]);
+
+    assert(model.stats().plane_conflicts == 0);
+    assert(model.stats().bus_conflicts == 0);
+    assert(model.stats().unknown_commands == 0);
+
+    // Three CE# targets on one bus: target 1 shares R/B# with target 0, target 2 has its
+    // own. The probe counts samples where targets 1 and 2 are busy together.
+    sim::NandModelConfig config1;
+    config1.blocks = 64;
+    config1.ce_pin = 7;
+    sim::NandModelConfig config2;
+    config2.pages_per_block = 128;
+    config2.ce_pin = 9;
+    config2.rb_pin = 8;
+    sim::NandModel target1(config1);
+    sim::NandModel target2(config2);
+    struct OverlapProbe : sim::PinBus {
+        const sim::NandModel* a = nullptr;
+        const sim::NandModel* b = nullptr;
+        uint64_t overlap = 0;
+        uint32_t on_sample(uint32_t host_levels, uint32_t host_outputs, uint32_t& driven) override {
+            if (a->busy() && b->busy()) ++overlap;
+            return sim::PinBus::on_sample(host_levels, host_outputs, driven);
+        }
+    } bus;
+    bus.a = &target1;
+    bus.b = &target2;
+    bus.add(&model);
+    bus.add(&target1);
+    bus.add(&target2);
+    onfi.set_targets({{GPIO_CE, GPIO_RB}, {7, GPIO_RB}, {9, 8}});
+    onfi.set_pin_direction_inactive();
+    sim::register_file().attach(&bus);
+    onfi.get_started();
+    assert(!onfi.has_private_rb(0) && !onfi.has_private_rb(1) && onfi.has_private_rb(2));
+    assert(onfi.selected_target() == 0 && onfi.num_blocks == config.blocks);
+    assert(onfi.target_geometry[1].blocks_per_lun == config1.blocks);
+    assert(onfi.target_geometry[2].pages_per_block == config2.pages_per_block);
+    onfi.enable_erase();
+
+    onfi::TargetTransport bus0(onfi, 0), bus1(onfi, 1), bus2(onfi, 2);
+    onfi::OnfiController ctrl0(bus0), ctrl1(bus1), ctrl2(bus2);
+    onfi::NandDevice dev0(ctrl0), dev1(ctrl1), dev2(ctrl2);
+    onfi::apply_device_config(onfi::make_device_config(onfi, 0), dev0);
+    onfi::apply_device_config(onfi::make_device_config(onfi, 1), dev1);
+    onfi::apply_device_config(onfi::make_device_config(onfi, 2), dev2);
+    std::vector<uint8_t> t0_page, t1_page, t2_page;
+    std::vector<onfi::LunOperation> target_ops(6);
+    target_ops[0].kind = onfi::LunOperation::Kind::Erase;
+    target_ops[0].target = 1; target_ops[0].block = 60;
+    target_ops[1].kind = onfi::LunOperation::Kind::Erase;
+    target_ops[1].target = 2; target_ops[1].block = 60;
+    target_ops[2].kind = onfi::LunOperation::Kind::Program;
+    target_ops[2].target = 1; target_ops[2].block = 60; target_ops[2].page = 1; target_ops[2].data = written[1].data();
+    target_ops[3].kind = onfi::LunOperation::Kind::Program;
+    target_ops[3].target = 2; target_ops[3].block = 60; target_ops[3].page = 127; target_ops[3].data = written[3].data();
+    target_ops[4].kind = onfi::LunOperation::Kind::Read;
+    target_ops[4].target = 0; target_ops[4].block = 9; target_ops[4].page = 4; target_ops[4].out = &t0_page;
+    target_ops[5].kind = onfi::LunOperation::Kind::Read;
+    target_ops[5].target = 2; target_ops[5].block = 60; target_ops[5].page = 127; target_ops[5].out = &t2_page;
+    assert(onfi::run_target_operations({&dev0, &dev1, &dev2}, target_ops));
+    assert(bus.overlap > 0);
+    assert(t0_page == written[2]);
+    assert(t2_page == written[3]);
+    dev1.read_page(60, 1, false, false, t1_page);
+    assert(t1_page == written[1]);
+    // Only the addressed target saw the commands
+    assert(model.array_page(60 * config.pages_per_block + 1)[0] == 0xFF);
+    assert(target2.array_page(60 * config2.pages_per_block + 1)[0] == 0xFF);
+    for (sim::NandModel* m : {&model, &target1, &target2}) {
+        assert(m->stats().bus_conflicts == 0);
+        assert(m->stats().unknown_commands == 0);
+    }
+
+    // A parameter page failing its CRC falls back to the redundant copies, and the
+    // validated page is cached under the unique ID for the next session
+    {
+        sim::NandModelConfig flaky_config;
+        flaky_config.page_size = 4096;
+        flaky_config.spare_size = 224;
+        flaky_config.corrupt_parameter_copies = 2;
+        sim::NandModel flaky(flaky_config);
+        onfi.set_targets({{GPIO_CE, GPIO_RB}});
+        onfi.set_pin_direction_inactive();
+        sim::register_file().attach(&flaky);
+
+        onfi.get_started();
+        assert(onfi.parameter_page_crc_ok);
+        assert(onfi.num_bytes_in_page == 4096 && onfi.num_spare_bytes_in_page == 224);
+        assert(flaky.stats().parameter_page_reads == 2);
+        const uint8_t* uid = reinterpret_cast<const uint8_t*>(onfi.unique_id);
+        const std::string entry = onfi::parameter_cache_path(uid);
+        assert(!entry.empty() && std::filesystem::file_size(entry) == onfi::kParameterPageBytes);
+
+        onfi.get_started();
+        assert(flaky.stats().parameter_page_reads == 2);
+        assert(onfi.num_bytes_in_page == 4096 && onfi.num_blocks == flaky_config.blocks);
+        assert(std::equal(flaky.parameter_page().begin(), flaky.parameter_page().end(), onfi.parameter_page));
+
+        // An entry that fails its CRC is ignored and rewritten
+        std::ofstream(entry, std::ios::binary | std::ios::trunc) << std::string(onfi::kParameterPageBytes, '\0');
+        onfi.get_started();
+        assert(flaky.stats().parameter_page_reads == 4);
+        assert(onfi.num_bytes_in_page == 4096);
+        uint8_t reloaded[onfi::kParameterPageBytes];
+        assert(onfi::load_cached_parameter_page(uid, reloaded));
+        assert(flaky.stats().bus_conflicts == 0);
+    }
+
+    // Sessions come up only as far as asked: bus, then reset, then identification
+    {
+        sim::NandModel fresh(config);
+        sim::register_file().attach(&fresh);
+        nandworks::DriverContext driver(false);
+        onfi_interface& bus_only = driver.require_session(nandworks::SessionLevel::Bus);
+        assert(driver.session_level() == nandworks::SessionLevel::Bus && fresh.stats().commands == 0);
+        assert((bus_only.get_status() & 0x40) != 0);
+        assert(fresh.stats().commands == 1);
+
+        driver.require_session(nandworks::SessionLevel::Reset);
+        assert(fresh.stats().commands == 2 && fresh.stats().parameter_page_reads == 0);
+        driver.require_session(nandworks::SessionLevel::Bus);
+        assert(fresh.stats().commands == 2);
+
+        onfi_interface& full = driver.require_onfi_started();
+        assert(driver.session_level() == nandworks::SessionLevel::Identified);
+        assert(full.num_blocks == config.blocks && full.num_luns == config.luns);
+        const uint64_t identified_commands = fresh.stats().commands;
+        driver.require_session(nandworks::SessionLevel::Reset);
+        assert(fresh.stats().commands == identified_commands);
+        assert(fresh.stats().bus_conflicts == 0 && fresh.stats().unknown_commands == 0);
+    }
+
+    // program-block --count and erase-chip hand the whole block list to the device, which
+    // pairs blocks on different planes into one operation
+    {
+        sim::NandModel cli_model(config);
+        sim::register_file().attach(&cli_model);
+        nandworks::DriverContext driver(false);
+        driver.set_caller_root(true);
+        nandworks::CommandRegistry registry;
+        nandworks::commands::register_onfi_commands(registry);
+        std::ostringstream out, err;
+        const uint64_t multi_before = cli_model.stats().multi_plane_ops;
+        assert(nandworks::dispatch_command(registry, driver, "program-block",
+                                           {"--block", "20", "--count", "2", "--pages", "0-1", "--verify", "--force"},
+                                           false, out, err) == 0);
+        assert(cli_model.stats().multi_plane_ops - multi_before == 2);
+        assert(cli_model.stats().page_programs == 4);
+
+        const uint64_t erase_multi_before = cli_model.stats().multi_plane_ops;
+        assert(nandworks::dispatch_command(registry, driver, "erase-chip", {"--start", "20", "--count", "4", "--force"},
+                                           false, out, err) == 0);
+        assert(cli_model.stats().multi_plane_ops - erase_multi_before == 2);
+        assert(cli_model.stats().block_erases == 4);
+        assert(cli_model.array_page(20 * config.pages_per_block)[0] == 0xFF);
+        assert(out.str().find("Erasing blocks 20, 21... done\nErasing blocks 22, 23... done\n") != std::string::npos);
+
+        // Factory bad block 5 fails the erase it shares with block 4: the run stops there
+        // unless --continue, which goes on and lists the failed blocks at the end
+        const uint64_t erases_before = cli_model.stats().block_erases;
+        out.str("");
+        assert(nandworks::dispatch_command(registry, driver, "erase-chip", {"--start", "4", "--count", "4", "--force"},
+                                           false, out, err) == 1);
+        assert(cli_model.stats().block_erases - erases_before == 2);
+        assert(out.str() == "Erasing blocks 4, 5... failed (status=0xe1)\n");
+        out.str("");
+        assert(nandworks::dispatch_command(registry, driver, "erase-chip",
+                                           {"--start", "4", "--count", "4", "--continue", "--force"},
+                                           false, out, err) == 1);
+        assert(cli_model.stats().block_erases - erases_before == 6);
+        assert(out.str().find("Erasing blocks 6, 7... done\nErase failed for blocks 4, 5\n") != std::string::npos);
+        assert(cli_model.stats().bus_conflicts == 0 && cli_model.stats().unknown_commands == 0);
+    }
+
+    // With a block count that is not a power of two the row address has holes between
+    // LUNs; the table stays dense and both lookup forms land on the same entry
+    {
+        sim::NandModelConfig odd_config;
+        odd_config.blocks = 100;
+        odd_config.luns = 2;
+        odd_config.factory_bad_blocks = {7, (1u << 7) | 3, (1u << 7) | 99};
+        sim::NandModel odd(odd_config);
+        sim::register_file().attach(&odd);
+        onfi.get_started();
+        assert(onfi.num_blocks == odd_config.blocks && onfi.num_luns == odd_config.luns);
+        onfi::OnfiController odd_ctrl(onfi);
+        onfi::NandDevice odd_dev(odd_ctrl);
+        onfi::apply_device_config(onfi::make_device_config(onfi), odd_dev);
+
+        const std::vector<uint32_t> expected{7, 100 + 3, 100 + 99};
+        const uint64_t cache_reads_before = odd.stats().cache_reads;
+        odd_dev.bad_blocks = odd_dev.scan_bad_blocks();
+        assert(odd.stats().cache_reads - cache_reads_before == 200);
+        assert(odd_dev.bad_blocks.blocks() == 200 && odd_dev.bad_blocks.bad_blocks() == expected);
+        assert(odd_dev.is_bad(0, 7) && odd_dev.is_bad(1, 3) && odd_dev.is_bad(1, 99));
+        assert(!odd_dev.is_bad(1, 7) && !odd_dev.is_bad(0, 99) && !odd_dev.is_bad(1, 100));
+        assert(odd_dev.is_bad(odd_dev.lun_block(1, 99)) && odd_dev.is_bad(7));
+        assert(!odd_dev.is_bad(odd_dev.lun_block(0, 99)));
+
+        // The block-by-block fallback probes the same rows
+        odd_dev.capabilities.optional_commands &= static_cast<uint16_t>(~0x0002);
+        const uint64_t fallback_before = odd.stats().cache_reads;
+        assert(odd_dev.scan_bad_blocks().bad_blocks() == expected);
+        assert(odd.stats().cache_reads == fallback_before);
+        assert(odd.stats().bus_conflicts == 0 && odd.stats().unknown_commands == 0);
+    }
+
+    // StatusPoll with R/B# not wired: the model drives a pin nobody reads and the host's
+    // R/B# floats high, so only the status polls keep the per-call paths (reset,
+    // parameter page, timed commands, get_data) from racing the array
+    {
+        sim::NandModelConfig unwired_config;
+        unwired_config.rb_pin = 4;
+        unwired_config.read_busy_samples = 64;
+        unwired_config.program_busy_samples = 64;
+        unwired_config.erase_busy_samples = 64;
+        sim::NandModel unwired(unwired_config);
+        sim::register_file().attach(&unwired);
+
+        const RbWaitOp ops[] = {RbWaitOp::Generic, RbWaitOp::Read, RbWaitOp::Program,
+                                RbWaitOp::Erase, RbWaitOp::Reset};
+        std::vector<RbWaitPolicy> saved_policies;
+        RbWaitPolicy polled{};
+        polled.mode = RbWaitMode::StatusPoll;
+        polled.timeout_ns = 1'000'000'000ULL;
+        for (RbWaitOp op : ops) {
+            saved_policies.push_back(onfi.wait_policy(op));
+            onfi.set_wait_policy(op, polled);
+        }
+        onfi.reset_wait_stats();
+
+        onfi.get_started();
+        assert(onfi.wait_stats(RbWaitOp::Reset).status_polls >= 1);
+        onfi.read_parameters(ONFI, false, false);
+        assert(onfi.parameter_page_crc_ok && onfi.num_blocks == unwired_config.blocks);
+        assert(std::equal(unwired.parameter_page().begin(), unwired.parameter_page().begin() + 256,
+                          onfi.parameter_page));
+
+        const unsigned int timed_block = 12;
+        std::vector<uint8_t> data(onfi.num_bytes_in_page);
+        for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<uint8_t>(i * 5 + 3);
+        const onfi::timed::OperationTiming erased = onfi::timed::erase_block(onfi, timed_block);
+        assert(erased.succeeded());
+        const onfi::timed::OperationTiming programmed =
+            onfi::timed::program_page(onfi, timed_block, 1, data.data(), static_cast<uint32_t>(data.size()), false);
+        assert(programmed.succeeded());
+        std::vector<uint8_t> read_back(data.size());
+        const onfi::timed::OperationTiming read =
+            onfi::timed::read_page(onfi, timed_block, 1, read_back.data(), static_cast<uint32_t>(read_back.size()), false);
+        assert(read.succeeded() && read_back == data);
+
+        for (RbWaitOp op : {RbWaitOp::Read, RbWaitOp::Program, RbWaitOp::Erase}) {
+            assert(onfi.wait_stats(op).status_polls >= 1);
+            assert(onfi.wait_stats(op).waits == onfi.wait_stats(op).status_polls);
+        }
+        assert(unwired.stats().ignored_while_busy == 0);
+        assert(unwired.stats().bus_conflicts == 0 && unwired.stats().unknown_commands == 0);
+
+        for (size_t i = 0; i < saved_policies.size(); ++i) onfi.set_wait_policy(ops[i], saved_policies[i]);
+    }
+    std::filesystem::remove_all(cache_dir);
+
+    std::cout << "sim_nand: OK" << std::endl;
+    return 0;
+}
+#else
+int main() {
+    std::cout << "sim_nand: skipped (build with HAL_BACKEND=sim)" << std::endl;
+    return 0;
+}
+#endif
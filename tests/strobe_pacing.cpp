@@ -0,0 +1,55 @@
+#include "dq_bus.hpp"
+#include "strobe_pacing.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+int main() {
+    for (uint8_t mode = 0; mode <= 5; ++mode) {
+        assert(onfi_async_timing(mode).mode == mode);
+    }
+    bool threw = false;
+    try {
+        onfi_async_timing(6);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // CPU slower than the spec: every mode runs unpaced
+    const StrobeCalibration slow{1.0, 60.0, 80.0};
+    for (uint8_t mode = 0; mode <= 5; ++mode) {
+        assert(!make_strobe_pacing(onfi_async_timing(mode), slow).active());
+    }
+
+    // Fast CPU in mode 4 (tWP 12, tWH 10, tWC 25, tDS 10, tRP 12, tREH 10, tRC 25, tREA 20)
+    const StrobeCalibration fast{1.0, 2.0, 5.0};
+    const StrobePacing p4 = make_strobe_pacing(onfi_async_timing(4), fast);
+    assert(p4.active());
+    assert(p4.mode == 4);
+    assert(p4.we_low == 8);   // tWP 12 - two store slots
+    assert(p4.we_high == 11); // tWH 10 - one slot, then stretched to tWC 25
+    assert(p4.re_low == 15);  // tREA 20 - GPLEV0 load
+    assert(p4.re_high == 8);  // tREH 10 - one slot
+
+    // Slower modes never need less padding
+    const StrobePacing p0 = make_strobe_pacing(onfi_async_timing(0), fast);
+    assert(p0.we_low >= p4.we_low && p0.we_high >= p4.we_high);
+    assert(p0.re_low >= p4.re_low && p0.re_high >= p4.re_high);
+
+    // Pacing adds delays only; the register stream is unchanged
+    const uint8_t payload[] = {0x00, 0xFF, 0xA5, 0x3C};
+    std::vector<DqBurstWord> words;
+    dq_build_data_in_burst(payload, sizeof(payload), words);
+    GpioWriteTrace plain, paced;
+    dq_emit_data_in_burst(words.data(), words.size(), plain);
+    dq_emit_data_in_burst<true>(words.data(), words.size(), paced, p4);
+    assert(plain.entries.size() == paced.entries.size());
+    for (size_t i = 0; i < plain.entries.size(); ++i) {
+        assert(plain.entries[i].reg == paced.entries[i].reg);
+        assert(plain.entries[i].value == paced.entries[i].value);
+    }
+    return 0;
+}
@@ -8,6 +8,7 @@ Description: This source file is to test the basic functionality of the interfac
 
 // onfi_interface.hpp has the necessary functionalities defined
 #include "onfi_interface.hpp"
+#include "onfi/bad_block_table.hpp"
 #include "onfi/device.hpp"
 #include "onfi/device_config.hpp"
 #include "onfi/controller.hpp"
@@ -26,24 +27,43 @@ const int MAX_ALLOWED_ERRORS = 50; // Example: Allow up to 50 bit errors per pag
 
 using namespace std;
 
-// Utility: pick a random good block (skip factory-marked bad blocks)
+static void configure_device(onfi_interface& onfi_instance, onfi::NandDevice& device) {
+    const auto config = onfi::make_device_config(onfi_instance);
+    onfi::apply_device_config(config, device);
+}
+
+// Utility: pick a random good block (skip factory-marked bad blocks). The chip is
+// scanned once; later runs reuse the bad-block table saved under its unique ID. The
+// table is only as fresh as its last scan and these tests program and erase, so the
+// pick is re-probed (one marker read) and a block found bad is added to the table.
 static unsigned int pick_good_block(onfi_interface &onfi_instance) {
+    onfi::OnfiController ctrl(onfi_instance);
+    onfi::NandDevice dev(ctrl);
+    configure_device(onfi_instance, dev);
+    const auto* id = reinterpret_cast<const uint8_t*>(onfi_instance.unique_id);
+    static onfi::BadBlockTable table;
+    if (table.empty()) {
+        onfi::attach_bad_block_table(dev, id);
+        table = dev.bad_blocks;
+    }
+    auto usable = [&](unsigned int b) {
+        if (table.is_bad(b)) return false;
+        if (!dev.is_bad_block(b)) return true;
+        table.mark_bad(b);
+        table.save(onfi::bad_block_table_path(id));
+        return false;
+    };
     // Try random picks first, then fall back to first good
     for (int tries = 0; tries < 16; ++tries) {
         unsigned int b = rand() % onfi_instance.num_blocks;
-        if (!onfi_instance.is_bad_block(b)) return b;
+        if (usable(b)) return b;
     }
     for (unsigned int b = 0; b < onfi_instance.num_blocks; ++b) {
-        if (!onfi_instance.is_bad_block(b)) return b;
+        if (usable(b)) return b;
     }
     return 0; // worst case; caller should still work
 }
 
-static void configure_device(onfi_interface& onfi_instance, onfi::NandDevice& device) {
-    const auto config = onfi::make_device_config(onfi_instance);
-    onfi::apply_device_config(config, device);
-}
-
 /**
 these are the page indices that will be used for analysis for SLC
 */
@@ -0,0 +1,52 @@
+#include "timing.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <time.h>
+
+namespace {
+
+uint64_t clock_raw_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t distance(uint64_t a, uint64_t b) {
+    return a > b ? a - b : b - a;
+}
+
+} // namespace
+
+int main() {
+    const TimebaseInfo& info = timebase_info();
+    assert(info.source != nullptr);
+    assert(info.frequency_hz > 0);
+    assert(info.resolution_ns > 0.0);
+    assert(info.read_cost_ns > 0.0);
+
+    // Same epoch as CLOCK_MONOTONIC_RAW
+    assert(distance(get_timestamp_ns(), clock_raw_ns()) < 1000000);
+
+    // Never goes backwards
+    uint64_t previous = get_timestamp_ns();
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t now = get_timestamp_ns();
+        assert(now >= previous);
+        previous = now;
+    }
+
+    // Tracks CLOCK_MONOTONIC_RAW over an interval to within 0.5%
+    const uint64_t raw_start = clock_raw_ns();
+    const uint64_t tb_start = get_timestamp_ns();
+    busy_wait_ns(20000000);
+    const uint64_t tb_elapsed = get_timestamp_ns() - tb_start;
+    const uint64_t raw_elapsed = clock_raw_ns() - raw_start;
+    assert(tb_elapsed >= 20000000);
+    assert(distance(tb_elapsed, raw_elapsed) < raw_elapsed / 200);
+
+    std::cout << "timebase: " << info.source << " " << info.frequency_hz << " Hz, "
+              << info.read_cost_ns << " ns per read" << std::endl;
+    return 0;
+}